@@ -23,37 +23,171 @@
  * 4. Build and flash to your development board
  */
 
-// Multi-channel ADC configuration with DMA double-buffering
+// Multi-channel ADC acquisition: one circular DMA buffer in two halves.
+// The DMA runs continuously (circular mode, started once), so no samples
+// are lost between blocks. The half-transfer callback hands the first half
+// to processing while the DMA fills the second; the transfer-complete
+// callback hands over the second while it wraps round to refill the first.
 #define SENSOR_CHANNELS 3
-#define BUFFER_SIZE 64
-static uint16_t adc_buffer_a[SENSOR_CHANNELS * BUFFER_SIZE];
-static uint16_t adc_buffer_b[SENSOR_CHANNELS * BUFFER_SIZE];
-static volatile bool buffer_ready = false;
-static volatile uint16_t* active_buffer = adc_buffer_a;
+#define BUFFER_SIZE 64                  // Samples per channel in one half (one block)
+#ifndef SAMPLE_RATE_HZ
+#define SAMPLE_RATE_HZ 1000             // Scans per second (64ms per block at 1kHz)
+#endif
+#define BLOCK_WORDS (SENSOR_CHANNELS * BUFFER_SIZE)
+static uint16_t adc_buffer[2 * BLOCK_WORDS];
+
+// Who may touch each half. The DMA owns a half while it is filling it. The
+// ISR passes it to processing as READY; processing takes it (PROCESSING)
+// and gives it back when done. If the DMA wraps into a half that processing
+// has not given back, processing missed its deadline: the half is counted
+// as an overrun and reclaimed, and acquisition_release() reports its data
+// as damaged.
+typedef enum {
+    HALF_DMA,
+    HALF_READY,
+    HALF_PROCESSING
+} half_owner_t;
+
+typedef struct {
+    volatile half_owner_t owner[2];
+    volatile uint32_t sequence[2];      // Block number held by each half
+    volatile uint32_t blocks;           // Blocks completed by the DMA
+    volatile uint32_t overruns;         // Blocks lost because processing was late
+} acquisition_t;
+
+static acquisition_t acquisition;
+
+// Block conversion: each channel's raw counts become fixed-point values,
+// value = ((raw - offset) * gain) >> CONVERT_GAIN_SHIFT, in a unit chosen
+// per channel (unit gives its size in physical terms). With 12-bit samples
+// and offsets within the ADC range every value fits in int16 exactly, so
+// no path needs to saturate.
+#define CONVERT_GAIN_SHIFT 13           // Gain is Q2.13, up to 4 output LSBs per count
+#define ADC_FULL_SCALE 4095
+
+typedef struct {
+    int16_t offset[SENSOR_CHANNELS];    // ADC counts at zero
+    int16_t gain[SENSOR_CHANNELS];      // Q2.13
+    float unit[SENSOR_CHANNELS];        // Physical value of one output LSB
+} channel_calibration_t;
+
+static channel_calibration_t calibration;
+
+// Power-on scaling of each sensor, the linear conversion of the board's
+// adc_to_physical_value(): physical = (raw - zero_counts) * units_per_count.
+// One output LSB is one count, so alarms, trend and display work in the
+// same physical units as with the per-sample float conversion.
+typedef struct {
+    float zero_counts;
+    float units_per_count;
+} sensor_scaling_t;
+
+static const sensor_scaling_t sensor_default_scaling[SENSOR_CHANNELS] = {
+    { 2048.0f, 0.01f },
+    { 2048.0f, 0.02f },
+    { 2048.0f, 0.05f },
+};
+static int16_t sensor_values[SENSOR_CHANNELS][BUFFER_SIZE];   // Latest block, channel-major
+
+// Conversion instruction set: Cortex-M4 DSP extension on target, AVX2 or
+// SSE2 on the host build, plain C otherwise
+#if defined(__ARM_FEATURE_DSP)
+#define CONVERT_DSP 1
+#elif defined(__AVX2__)
+#include <immintrin.h>
+#define CONVERT_AVX2 1
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define CONVERT_SSE2 1
+#endif
+
+// Cycle counter for conversion timing (TSC ticks or ns on the host build)
+#ifdef HOST_BUILD
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define convert_cycle_count() ((uint32_t)__rdtsc())
+#else
+#include <time.h>
+static inline uint32_t convert_cycle_count(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)(ts.tv_sec * 1000000000ull + ts.tv_nsec);
+}
+#endif
+#else
+#define convert_cycle_count() (DWT->CYCCNT)
+#endif
+
+// Streaming statistics over one channel's converted values (output LSBs),
+// gathered in a single pass over each block. A block's statistics merge
+// into the running ones, so the mean, variance, min and max cover every
+// sample since the window started. Square roots are left to the readers
+// (stats_std_deviation), which run at display or logging rate.
+//  - Floating point: Welford's mean and sum of squared deviations, merged
+//    with Chan's formula.
+//  - STATS_FIXED_POINT: exact integer sum and sum of squares (SMLAL on the
+//    M4); the deviations are only formed when the variance is read.
+#ifndef STATS_FIXED_POINT
+#define STATS_FIXED_POINT 0
+#endif
+#define STATS_EWMA_SHIFT 9              // EWMA weight 1/512 per sample (8 blocks)
+
+typedef struct {
+    uint32_t count;                     // Samples since the window started
+#if STATS_FIXED_POINT
+    int64_t sum;
+    int64_t sum_squares;
+    int32_t ewma;                       // Q16
+#else
+    float mean;
+    float m2;                           // Sum of squared deviations from mean
+    float ewma;
+#endif
+    int16_t min, max;
+    bool seeded;                        // EWMA has started
+} channel_stats_t;
 
 // Sensor data structure with statistics
 typedef struct {
     float current_value;
     float moving_average;
     float min_value, max_value;
-    float std_deviation;
+    float previous_average;             // moving_average at the last update, for the trend
     trend_t trend;
     alarm_state_t alarm_status;
     uint32_t last_update_time;
+    uint32_t window_start;              // When stats last restarted
+    channel_stats_t stats;
 } sensor_data_t;
 
 static sensor_data_t sensors[SENSOR_CHANNELS];
 
+void update_sensor_statistics(sensor_data_t* sensor, const int16_t* values, int count, float unit);
+void calibrate_channel(int channel, float zero_counts, float units_per_count, float unit);
+
 /**
  * @brief Initialize multi-sensor acquisition system
  */
 HAL_StatusTypeDef init_environmental_monitor(void) {
     // Configure timer for 1kHz ADC triggering
-    configure_adc_trigger_timer(1000); // 1kHz
+    configure_adc_trigger_timer(SAMPLE_RATE_HZ);
+    
+    // Start ADC in scan mode with circular DMA over both halves; it is
+    // never restarted
+    for (int half = 0; half < 2; half++) {
+        acquisition.owner[half] = HALF_DMA;
+    }
+    acquisition.blocks = 0;
+    acquisition.overruns = 0;
     
-    // Start ADC in scan mode with DMA
-    if (HAL_ADC_Start_DMA(&hadc1, (uint32_t*)active_buffer, 
-                         SENSOR_CHANNELS * BUFFER_SIZE) != HAL_OK) {
+    // Physical units from the first block; calibrate_channel can refine
+    // each sensor's scaling later
+    for (int channel = 0; channel < SENSOR_CHANNELS; channel++) {
+        const sensor_scaling_t* scaling = &sensor_default_scaling[channel];
+        calibrate_channel(channel, scaling->zero_counts, scaling->units_per_count,
+                          scaling->units_per_count);
+    }
+    if (HAL_ADC_Start_DMA(&hadc1, (uint32_t*)adc_buffer, 2 * BLOCK_WORDS) != HAL_OK) {
         return HAL_ERROR;
     }
     
@@ -66,92 +200,469 @@ HAL_StatusTypeDef init_environmental_monitor(void) {
 }
 
 /**
- * @brief DMA complete callback - process sensor data
+ * @brief A half of the DMA buffer has filled (ADC interrupt)
+ * 
+ * The DMA has already moved on into the other half, so that half must be
+ * back with the DMA by now; if it is not, processing is late.
+ */
+static void acquisition_half_complete(uint32_t half) {
+    uint32_t other = half ^ 1;
+    
+    if (acquisition.owner[other] != HALF_DMA) {
+        acquisition.overruns++;
+        acquisition.owner[other] = HALF_DMA;
+    }
+    acquisition.sequence[half] = acquisition.blocks++;
+    acquisition.owner[half] = HALF_READY;
+    
+    // Signal main loop to process data
+    set_processing_flag();
+}
+
+/**
+ * @brief DMA half-transfer callback - first half ready
+ */
+void HAL_ADC_ConvHalfCpltCallback(ADC_HandleTypeDef* hadc) {
+    if (hadc->Instance == ADC1) {
+        acquisition_half_complete(0);
+    }
+}
+
+/**
+ * @brief DMA complete callback - second half ready (DMA wraps to the first)
  */
 void HAL_ADC_ConvCpltCallback(ADC_HandleTypeDef* hadc) {
     if (hadc->Instance == ADC1) {
-        buffer_ready = true;
-        
-        // Switch to alternate buffer for continuous acquisition
-        active_buffer = (active_buffer == adc_buffer_a) ? adc_buffer_b : adc_buffer_a;
-        HAL_ADC_Start_DMA(&hadc1, (uint32_t*)active_buffer, 
-                         SENSOR_CHANNELS * BUFFER_SIZE);
-        
-        // Signal main loop to process data
-        set_processing_flag();
+        acquisition_half_complete(1);
+    }
+}
+
+/**
+ * @brief Take the block waiting for processing, if any (main loop)
+ * 
+ * Only one half can be READY at a time: the ISR reclaims the other one.
+ * @param sequence Block number, consecutive unless blocks were lost
+ * @return Interleaved block of BLOCK_WORDS samples, or NULL
+ */
+const uint16_t* acquisition_take(uint32_t* sequence) {
+    const uint16_t* block = NULL;
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    
+    for (uint32_t half = 0; half < 2; half++) {
+        if (acquisition.owner[half] == HALF_READY) {
+            acquisition.owner[half] = HALF_PROCESSING;
+            *sequence = acquisition.sequence[half];
+            block = &adc_buffer[half * BLOCK_WORDS];
+        }
+    }
+    
+    __set_PRIMASK(primask);
+    return block;
+}
+
+/**
+ * @brief Give a block back to the DMA (main loop)
+ * @return true if the DMA did not reach it while it was held, so what was
+ *         read from it is intact
+ */
+bool acquisition_release(const uint16_t* block) {
+    uint32_t half = (block == adc_buffer) ? 0 : 1;
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    
+    bool intact = acquisition.owner[half] == HALF_PROCESSING;
+    acquisition.owner[half] = HALF_DMA;
+    
+    __set_PRIMASK(primask);
+    return intact;
+}
+
+/**
+ * @brief Set a channel's linear scaling for the block conversion
+ * @param zero_counts ADC reading at a physical value of zero (0 to ADC_FULL_SCALE)
+ * @param units_per_count Physical change per ADC count
+ * @param unit Physical value of one output LSB; at least units_per_count / 4
+ */
+void calibrate_channel(int channel, float zero_counts, float units_per_count, float unit) {
+    float gain = units_per_count / unit * (1 << CONVERT_GAIN_SHIFT);
+    if (gain > 32767.0f) gain = 32767.0f;
+    if (gain < -32768.0f) gain = -32768.0f;
+    if (zero_counts < 0.0f) zero_counts = 0.0f;
+    if (zero_counts > ADC_FULL_SCALE) zero_counts = ADC_FULL_SCALE;
+    
+    calibration.offset[channel] = (int16_t)lrintf(zero_counts);
+    calibration.gain[channel] = (int16_t)lrintf(gain);
+    calibration.unit[channel] = unit;
+}
+
+/**
+ * @brief Reference conversion, one sample at a time
+ * @param block Interleaved scans of SENSOR_CHANNELS samples
+ * @param out Channel-major output: channel c's values start at out + c * stride
+ */
+void convert_block_scalar(const uint16_t* block, uint32_t scans,
+                          const channel_calibration_t* cal, int16_t* out, uint32_t stride) {
+    for (uint32_t i = 0; i < scans; i++) {
+        for (uint32_t c = 0; c < SENSOR_CHANNELS; c++) {
+            int32_t x = block[i * SENSOR_CHANNELS + c] - cal->offset[c];
+            out[c * stride + i] = (int16_t)((x * cal->gain[c]) >> CONVERT_GAIN_SHIFT);
+        }
+    }
+}
+
+/**
+ * @brief De-interleave and convert a block in one pass, several scans at a time
+ * 
+ * Same result as convert_block_scalar, bit for bit. Each step gathers the
+ * next few scans of every channel into one register, so each output store
+ * writes consecutive values of one channel.
+ *  - DSP: two scans per step. SSUB16 removes both offsets, two SMUADs
+ *    (against the gain in one half and zero in the other) form the
+ *    products, and PKHTB packs the two results into one store.
+ *  - SSE2/AVX2: 8 or 16 scans per step. With the difference scaled by
+ *    2^(16 - CONVERT_GAIN_SHIFT), PMULHW's high half is the product
+ *    shifted down by CONVERT_GAIN_SHIFT; the difference of 12-bit values
+ *    still fits in int16 after the scaling.
+ * Scans left over at the end go through the scalar code.
+ */
+void convert_block(const uint16_t* block, uint32_t scans,
+                   const channel_calibration_t* cal, int16_t* out, uint32_t stride) {
+    uint32_t i = 0;
+    
+#if defined(CONVERT_DSP)
+    uint32_t offset[SENSOR_CHANNELS], gain_low[SENSOR_CHANNELS], gain_high[SENSOR_CHANNELS];
+    for (uint32_t c = 0; c < SENSOR_CHANNELS; c++) {
+        offset[c] = (uint16_t)cal->offset[c] * 0x00010001u;
+        gain_low[c] = (uint16_t)cal->gain[c];
+        gain_high[c] = (uint32_t)(uint16_t)cal->gain[c] << 16;
+    }
+    for (; i + 2 <= scans; i += 2) {
+        const uint16_t* scan = &block[i * SENSOR_CHANNELS];
+        for (uint32_t c = 0; c < SENSOR_CHANNELS; c++) {
+            uint32_t pair = __PKHBT(scan[c], scan[SENSOR_CHANNELS + c], 16);
+            uint32_t x = __SSUB16(pair, offset[c]);
+            int32_t low = (int32_t)__SMUAD(x, gain_low[c]);
+            int32_t high = (int32_t)__SMUAD(x, gain_high[c]);
+            uint32_t word = __PKHTB((uint32_t)high << (16 - CONVERT_GAIN_SHIFT), low,
+                                    CONVERT_GAIN_SHIFT);
+            memcpy(&out[c * stride + i], &word, sizeof(word));
+        }
+    }
+#elif defined(CONVERT_AVX2)
+    __m256i offset[SENSOR_CHANNELS], gain[SENSOR_CHANNELS];
+    for (uint32_t c = 0; c < SENSOR_CHANNELS; c++) {
+        offset[c] = _mm256_set1_epi16(cal->offset[c]);
+        gain[c] = _mm256_set1_epi16(cal->gain[c]);
+    }
+    for (; i + 16 <= scans; i += 16) {
+        const uint16_t* scan = &block[i * SENSOR_CHANNELS];
+        for (uint32_t c = 0; c < SENSOR_CHANNELS; c++) {
+            const uint16_t* x = &scan[c];
+            const uint32_t n = SENSOR_CHANNELS;
+            __m256i v = _mm256_setr_epi16(
+                x[0], x[n], x[2 * n], x[3 * n], x[4 * n], x[5 * n], x[6 * n], x[7 * n],
+                x[8 * n], x[9 * n], x[10 * n], x[11 * n],
+                x[12 * n], x[13 * n], x[14 * n], x[15 * n]);
+            v = _mm256_slli_epi16(_mm256_sub_epi16(v, offset[c]), 16 - CONVERT_GAIN_SHIFT);
+            _mm256_storeu_si256((__m256i*)&out[c * stride + i], _mm256_mulhi_epi16(v, gain[c]));
+        }
+    }
+#elif defined(CONVERT_SSE2)
+    __m128i offset[SENSOR_CHANNELS], gain[SENSOR_CHANNELS];
+    for (uint32_t c = 0; c < SENSOR_CHANNELS; c++) {
+        offset[c] = _mm_set1_epi16(cal->offset[c]);
+        gain[c] = _mm_set1_epi16(cal->gain[c]);
+    }
+    for (; i + 8 <= scans; i += 8) {
+        const uint16_t* scan = &block[i * SENSOR_CHANNELS];
+        for (uint32_t c = 0; c < SENSOR_CHANNELS; c++) {
+            const uint16_t* x = &scan[c];
+            const uint32_t n = SENSOR_CHANNELS;
+            __m128i v = _mm_setr_epi16(x[0], x[n], x[2 * n], x[3 * n],
+                                       x[4 * n], x[5 * n], x[6 * n], x[7 * n]);
+            v = _mm_slli_epi16(_mm_sub_epi16(v, offset[c]), 16 - CONVERT_GAIN_SHIFT);
+            _mm_storeu_si128((__m128i*)&out[c * stride + i], _mm_mulhi_epi16(v, gain[c]));
+        }
+    }
+#endif
+    
+    // Scalar path (and tail)
+    if (i < scans) {
+        convert_block_scalar(&block[i * SENSOR_CHANNELS], scans - i, cal, &out[i], stride);
     }
 }
 
 /**
  * @brief Advanced sensor data processing with statistics
+ * 
+ * The block is converted into sensor_values and given back first, so the
+ * deadline (the next block, BUFFER_SIZE samples later) only covers the
+ * conversion. A block the DMA reached meanwhile is dropped; it is already
+ * in the overrun count.
  */
 void process_sensor_data(void) {
-    if (!buffer_ready) return;
+    uint32_t sequence;
+    const uint16_t* block = acquisition_take(&sequence);
+    if (block == NULL) return;
     
-    uint16_t* processing_buffer = (active_buffer == adc_buffer_a) ? 
-                                  adc_buffer_b : adc_buffer_a;
+    convert_block(block, BUFFER_SIZE, &calibration, &sensor_values[0][0], BUFFER_SIZE);
+    if (!acquisition_release(block)) {
+        return;
+    }
     
     for (int sensor = 0; sensor < SENSOR_CHANNELS; sensor++) {
-        // Extract sensor-specific samples from interleaved buffer
-        float samples[BUFFER_SIZE];
-        for (int i = 0; i < BUFFER_SIZE; i++) {
-            samples[i] = adc_to_physical_value(
-                processing_buffer[i * SENSOR_CHANNELS + sensor], sensor);
-        }
-        
         // Update statistics
-        update_sensor_statistics(&sensors[sensor], samples, BUFFER_SIZE);
+        update_sensor_statistics(&sensors[sensor], sensor_values[sensor], BUFFER_SIZE,
+                                 calibration.unit[sensor]);
         
         // Check for alarms
         evaluate_alarm_conditions(&sensors[sensor], sensor);
     }
+}
+
+/**
+ * @brief Combine statistics gathered over later samples into a running set
+ * 
+ * from must cover the samples that follow into's, so its EWMA (which
+ * depends on order) is the current one.
+ */
+void stats_merge(channel_stats_t* into, const channel_stats_t* from) {
+    if (from->count == 0) return;
     
-    buffer_ready = false;
+    if (into->count == 0 || from->min < into->min) into->min = from->min;
+    if (into->count == 0 || from->max > into->max) into->max = from->max;
+#if STATS_FIXED_POINT
+    into->sum += from->sum;
+    into->sum_squares += from->sum_squares;
+#else
+    uint32_t count = into->count + from->count;
+    float delta = from->mean - into->mean;
+    into->mean += delta * from->count / count;
+    into->m2 += from->m2 + delta * delta * ((float)into->count * from->count / count);
+#endif
+    into->count += from->count;
+    into->ewma = from->ewma;
+    into->seeded = from->seeded;
 }
 
 /**
- * @brief Update comprehensive sensor statistics
+ * @brief Add a block of one channel's values in a single pass
  */
-void update_sensor_statistics(sensor_data_t* sensor, float* samples, int count) {
-    // Current value (latest sample)
-    sensor->current_value = samples[count - 1];
+void stats_update_block(channel_stats_t* stats, const int16_t* values, uint32_t count) {
+    if (count == 0) return;
     
-    // Moving average with exponential weighting
-    static const float alpha = 0.1f; // Smoothing factor
-    sensor->moving_average = alpha * sensor->current_value + 
-                            (1.0f - alpha) * sensor->moving_average;
+    channel_stats_t block = { 0 };
+    block.count = count;
+    block.min = block.max = values[0];
     
-    // Min/Max tracking with time-based reset
-    if (sensor->current_value < sensor->min_value || 
-        HAL_GetTick() - sensor->last_update_time > STATS_RESET_PERIOD) {
-        sensor->min_value = sensor->current_value;
+#if STATS_FIXED_POINT
+    // |value| < 2^14, so the Q16 EWMA and its difference stay within int32
+    int32_t ewma = stats->seeded ? stats->ewma : (int32_t)values[0] * 65536;
+    int32_t sum = 0;
+    int64_t sum_squares = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        int32_t x = values[i];
+        sum += x;
+        sum_squares += x * x;
+        if (x < block.min) block.min = (int16_t)x;
+        if (x > block.max) block.max = (int16_t)x;
+        ewma += (x * 65536 - ewma) >> STATS_EWMA_SHIFT;
     }
-    if (sensor->current_value > sensor->max_value || 
-        HAL_GetTick() - sensor->last_update_time > STATS_RESET_PERIOD) {
-        sensor->max_value = sensor->current_value;
+    block.sum = sum;
+    block.sum_squares = sum_squares;
+#else
+    const float alpha = 1.0f / (1 << STATS_EWMA_SHIFT);
+    float ewma = stats->seeded ? stats->ewma : values[0];
+    float mean = 0.0f, m2 = 0.0f;
+    for (uint32_t i = 0; i < count; i++) {
+        float x = values[i];
+        float delta = x - mean;
+        mean += delta / (i + 1);
+        m2 += delta * (x - mean);
+        if (values[i] < block.min) block.min = values[i];
+        if (values[i] > block.max) block.max = values[i];
+        ewma += alpha * (x - ewma);
     }
+    block.mean = mean;
+    block.m2 = m2;
+#endif
+    block.ewma = ewma;
+    block.seeded = true;
+    stats_merge(stats, &block);
+}
+
+/**
+ * @brief Start a new statistics window; the EWMA carries on
+ */
+void stats_restart(channel_stats_t* stats) {
+    channel_stats_t restarted = { 0 };
+    restarted.ewma = stats->ewma;
+    restarted.seeded = stats->seeded;
+    *stats = restarted;
+}
+
+float stats_mean(const channel_stats_t* stats) {
+    if (stats->count == 0) return 0.0f;
+#if STATS_FIXED_POINT
+    return (float)stats->sum / stats->count;
+#else
+    return stats->mean;
+#endif
+}
+
+float stats_ewma(const channel_stats_t* stats) {
+#if STATS_FIXED_POINT
+    return stats->ewma * (1.0f / 65536.0f);
+#else
+    return stats->ewma;
+#endif
+}
+
+/**
+ * @brief Population variance of the window, in output LSBs squared
+ */
+float stats_variance(const channel_stats_t* stats) {
+    if (stats->count == 0) return 0.0f;
+#if STATS_FIXED_POINT
+    // Squared deviations about q = sum / n (truncated) are exact integers;
+    // moving them to the true mean subtracts r^2 / n, with r = sum - q * n
+    int64_t n = stats->count;
+    int64_t q = stats->sum / n;
+    int64_t r = stats->sum - q * n;
+    int64_t m2 = stats->sum_squares - 2 * q * stats->sum + n * q * q;
+    return ((float)m2 - (float)r * (float)r / n) / n;
+#else
+    return stats->m2 / stats->count;
+#endif
+}
+
+float stats_std_deviation(const channel_stats_t* stats) {
+    return sqrtf(stats_variance(stats));
+}
+
+/**
+ * @brief Update comprehensive sensor statistics
+ * @param values The block's converted values for this sensor
+ * @param unit Physical value of one converted LSB
+ */
+void update_sensor_statistics(sensor_data_t* sensor, const int16_t* values, int count, float unit) {
+    uint32_t now = HAL_GetTick();
     
-    // Standard deviation calculation
-    float variance = 0;
-    for (int i = 0; i < count; i++) {
-        float diff = samples[i] - sensor->moving_average;
-        variance += diff * diff;
+    // Min/Max (and mean and variance) over a window restarted periodically
+    if (now - sensor->window_start > STATS_RESET_PERIOD) {
+        stats_restart(&sensor->stats);
+        sensor->window_start = now;
     }
-    sensor->std_deviation = sqrtf(variance / count);
+    stats_update_block(&sensor->stats, values, count);
+    
+    // Current value (latest sample)
+    sensor->current_value = values[count - 1] * unit;
+    
+    // Moving average with exponential weighting
+    sensor->moving_average = stats_ewma(&sensor->stats) * unit;
+    sensor->min_value = sensor->stats.min * unit;
+    sensor->max_value = sensor->stats.max * unit;
     
     // Trend analysis
-    static float previous_average = 0;
-    float change_rate = (sensor->moving_average - previous_average) / 
-                       (HAL_GetTick() - sensor->last_update_time) * 1000.0f;
+    uint32_t elapsed = now - sensor->last_update_time;
+    if (elapsed > 0) {
+        float change_rate = (sensor->moving_average - sensor->previous_average) /
+                           elapsed * 1000.0f;
+        
+        if (fabsf(change_rate) < TREND_THRESHOLD) {
+            sensor->trend = TREND_STABLE;
+        } else if (change_rate > 0) {
+            sensor->trend = TREND_RISING;
+        } else {
+            sensor->trend = TREND_FALLING;
+        }
+    }
+    
+    sensor->previous_average = sensor->moving_average;
+    sensor->last_update_time = now;
+}
+
+/**
+ * @brief Standard deviation of a sensor over the current window
+ * 
+ * For the display and logging stages; the square root is only taken here.
+ */
+float sensor_std_deviation(int sensor) {
+    return stats_std_deviation(&sensors[sensor].stats) * fabsf(calibration.unit[sensor]);
+}
+
+#ifdef HOST_BUILD
+/**
+ * @brief Host benchmark: block conversion against the scalar paths
+ * 
+ * Converts blocks of pseudo-random 12-bit samples with varied calibrations
+ * and times the per-sample float path this replaced (adc_to_physical_value
+ * for each channel in turn), convert_block_scalar and convert_block, which
+ * must match the scalar result exactly.
+ * @return 0 if convert_block matched convert_block_scalar on every block
+ */
+int benchmark_convert_block(void) {
+    #define CONVERT_BENCH_BLOCKS 20000
+    static uint16_t block[BLOCK_WORDS];
+    static int16_t reference[SENSOR_CHANNELS][BUFFER_SIZE];
+    static float floats[SENSOR_CHANNELS][BUFFER_SIZE];
+    channel_calibration_t cal;
+    uint32_t float_cycles = 0, scalar_cycles = 0, block_cycles = 0, mismatches = 0;
+    uint32_t seed = 1;
+    volatile float sink = 0.0f;
     
-    if (fabsf(change_rate) < TREND_THRESHOLD) {
-        sensor->trend = TREND_STABLE;
-    } else if (change_rate > 0) {
-        sensor->trend = TREND_RISING;
-    } else {
-        sensor->trend = TREND_FALLING;
+    for (uint32_t b = 0; b < CONVERT_BENCH_BLOCKS; b++) {
+        for (uint32_t i = 0; i < BLOCK_WORDS; i++) {
+            seed = seed * 1664525u + 1013904223u;
+            block[i] = (uint16_t)(seed >> 20);
+        }
+        for (uint32_t c = 0; c < SENSOR_CHANNELS; c++) {
+            seed = seed * 1664525u + 1013904223u;
+            cal.offset[c] = (int16_t)((seed >> 8) % (ADC_FULL_SCALE + 1));
+            cal.gain[c] = (int16_t)(seed >> 16);
+        }
+        
+        uint32_t start = convert_cycle_count();
+        for (int sensor = 0; sensor < SENSOR_CHANNELS; sensor++) {
+            for (int i = 0; i < BUFFER_SIZE; i++) {
+                floats[sensor][i] = adc_to_physical_value(block[i * SENSOR_CHANNELS + sensor],
+                                                          sensor);
+            }
+        }
+        uint32_t t1 = convert_cycle_count();
+        convert_block_scalar(block, BUFFER_SIZE, &cal, &reference[0][0], BUFFER_SIZE);
+        uint32_t t2 = convert_cycle_count();
+        convert_block(block, BUFFER_SIZE, &cal, &sensor_values[0][0], BUFFER_SIZE);
+        uint32_t t3 = convert_cycle_count();
+        float_cycles += t1 - start;
+        scalar_cycles += t2 - t1;
+        block_cycles += t3 - t2;
+        sink += floats[b % SENSOR_CHANNELS][b % BUFFER_SIZE];
+        
+        if (memcmp(reference, sensor_values, sizeof(reference)) != 0) {
+            mismatches++;
+        }
     }
     
-    previous_average = sensor->moving_average;
-    sensor->last_update_time = HAL_GetTick();
-}
\ No newline at end of file
+#if defined(CONVERT_DSP)
+    const char* path = "Cortex-M4 DSP";
+#elif defined(CONVERT_AVX2)
+    const char* path = "AVX2";
+#elif defined(CONVERT_SSE2)
+    const char* path = "SSE2";
+#else
+    const char* path = "scalar";
+#endif
+    const float samples = (float)CONVERT_BENCH_BLOCKS * BLOCK_WORDS;
+    printf("Block conversion (%d blocks of %d scans x %d channels)\n",
+           CONVERT_BENCH_BLOCKS, BUFFER_SIZE, SENSOR_CHANNELS);
+    printf("  float per channel:  %.2f cycles/sample\n", float_cycles / samples);
+    printf("  fixed-point scalar: %.2f cycles/sample\n", scalar_cycles / samples);
+    printf("  convert_block (%s): %.2f cycles/sample, %.1fx scalar, %u mismatched blocks\n",
+           path, block_cycles / samples, (float)scalar_cycles / block_cycles,
+           (unsigned)mismatches);
+    (void)sink;
+    return mismatches ? 1 : 0;
+}
+#endif
@@ -0,0 +1,416 @@
+/*
+ * Code Example 46 - Host Acquisition Simulator
+ * Language: C
+ * Chapter: Chapter_11_Capstone_Projects_Advanced_System_Integration
+ *
+ * Runs the acquisition and processing code from code_example_46.c on a PC
+ * against a model of the ADC's circular DMA: scans are written into the
+ * buffer one at a time in virtual time and the half-transfer and
+ * transfer-complete callbacks fire where the hardware raises them. The
+ * main loop is run either promptly or with a processing delay, so lost
+ * samples and overruns can be checked without a board. The STM32 HAL is
+ * replaced by the small stand-ins below.
+ *
+ * Usage:
+ * 1. gcc -O2 -Wall -o adc_sim code_example_46_host_sim.c -lm
+ *    (add -DSAMPLE_RATE_HZ=10000 to run the scan rate faster; -mavx2
+ *    selects the AVX2 block conversion instead of SSE2, -DEMULATE_DSP the
+ *    Cortex-M4 one with the DSP instructions emulated in C;
+ *    -DSTATS_FIXED_POINT=1 the fixed-point statistics)
+ * 2. ./adc_sim --selftest runs the acquisition, statistics and calibration
+ *    checks and the block conversion benchmark
+ *
+ * Each channel's ADC model counts up by one per scan, so every sample that
+ * reaches processing can be checked for gaps and order.
+ */
+
+#define HOST_BUILD
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+// Host stand-ins for the STM32 HAL and the book's helper functions
+typedef enum { HAL_OK, HAL_ERROR } HAL_StatusTypeDef;
+typedef struct { void* Instance; } ADC_HandleTypeDef;
+typedef struct { void* Instance; } TIM_HandleTypeDef;
+
+typedef enum { TREND_STABLE, TREND_RISING, TREND_FALLING } trend_t;
+typedef enum { ALARM_NONE, ALARM_WARNING, ALARM_CRITICAL } alarm_state_t;
+
+#define ADC1 ((void*)1)
+#define STATS_RESET_PERIOD 60000        // ms
+#define TREND_THRESHOLD 0.5f            // Units per second
+
+static ADC_HandleTypeDef hadc1 = { ADC1 };
+static TIM_HandleTypeDef htim_display, htim_logging, htim_alarms;
+
+static uint32_t __get_PRIMASK(void) {
+    return 0;
+}
+
+static void __set_PRIMASK(uint32_t primask) {
+    (void)primask;
+}
+
+static void __disable_irq(void) {
+}
+
+#ifdef EMULATE_DSP
+// C versions of the Cortex-M4 DSP instructions the block conversion uses
+#define __ARM_FEATURE_DSP 1
+
+static uint32_t __SSUB16(uint32_t a, uint32_t b) {
+    uint16_t low = (uint16_t)((int16_t)a - (int16_t)b);
+    uint16_t high = (uint16_t)((int16_t)(a >> 16) - (int16_t)(b >> 16));
+    return ((uint32_t)high << 16) | low;
+}
+
+static uint32_t __SMUAD(uint32_t a, uint32_t b) {
+    return (uint32_t)((int16_t)a * (int16_t)b + (int16_t)(a >> 16) * (int16_t)(b >> 16));
+}
+
+static uint32_t __PKHBT(uint32_t a, uint32_t b, uint32_t shift) {
+    return (a & 0xFFFFu) | ((b << shift) & 0xFFFF0000u);
+}
+
+static uint32_t __PKHTB(uint32_t a, uint32_t b, uint32_t shift) {
+    return (a & 0xFFFF0000u) | (((uint32_t)((int32_t)b >> shift)) & 0xFFFFu);
+}
+#endif
+
+// Virtual time, advanced one scan at a time by sim_scan
+static uint64_t sim_scans;
+
+uint32_t HAL_GetTick(void);
+
+static void configure_adc_trigger_timer(uint32_t rate_hz) {
+    (void)rate_hz;
+}
+
+HAL_StatusTypeDef HAL_TIM_Base_Start_IT(TIM_HandleTypeDef* htim) {
+    (void)htim;
+    return HAL_OK;
+}
+
+// Circular DMA target, filled by sim_scan
+static uint16_t* dma_buffer;
+static uint32_t dma_length, dma_index;
+
+HAL_StatusTypeDef HAL_ADC_Start_DMA(ADC_HandleTypeDef* hadc, uint32_t* data, uint32_t length) {
+    (void)hadc;
+    dma_buffer = (uint16_t*)data;
+    dma_length = length;
+    dma_index = 0;
+    return HAL_OK;
+}
+
+static uint32_t processing_flags;
+
+static void set_processing_flag(void) {
+    processing_flags++;
+}
+
+static float adc_to_physical_value(uint16_t raw, int sensor);
+static void evaluate_alarm_conditions(void* sensor, int index);
+
+#include "code_example_46.c"
+
+// The per-sample conversion the block kernel replaced, for the benchmark
+static float adc_to_physical_value(uint16_t raw, int sensor) {
+    const sensor_scaling_t* scaling = &sensor_default_scaling[sensor];
+    return (raw - scaling->zero_counts) * scaling->units_per_count;
+}
+
+// Gap check: each channel's samples must arrive as consecutive counts.
+// sim_reset sets an identity calibration, so each converted value is the
+// raw sample.
+static uint16_t expected_raw[SENSOR_CHANNELS];
+static uint32_t samples_seen, samples_out_of_order;
+
+static void evaluate_alarm_conditions(void* sensor, int index) {
+    (void)sensor;
+    for (int i = 0; i < BUFFER_SIZE; i++) {
+        if (sensor_values[index][i] != expected_raw[index]) {
+            samples_out_of_order++;
+        }
+        expected_raw[index] = (uint16_t)((sensor_values[index][i] + 1) & 0xFFF);
+        samples_seen++;
+    }
+}
+
+uint32_t HAL_GetTick(void) {
+    return (uint32_t)(sim_scans * 1000 / SAMPLE_RATE_HZ);
+}
+
+/**
+ * @brief One scan: every channel converts and the DMA stores it
+ *
+ * Channel c reads (scan + 1000 * c) mod 4096. The callbacks fire as the
+ * DMA crosses the middle and the end of the buffer.
+ */
+static void sim_scan(void) {
+    for (uint32_t c = 0; c < SENSOR_CHANNELS; c++) {
+        dma_buffer[dma_index++] = (uint16_t)((sim_scans + 1000 * c) & 0xFFF);
+    }
+    sim_scans++;
+    if (dma_index == dma_length / 2) {
+        HAL_ADC_ConvHalfCpltCallback(&hadc1);
+    } else if (dma_index == dma_length) {
+        dma_index = 0;
+        HAL_ADC_ConvCpltCallback(&hadc1);
+    }
+}
+
+static void sim_reset(void) {
+    sim_scans = 0;
+    processing_flags = 0;
+    samples_seen = 0;
+    samples_out_of_order = 0;
+    for (uint32_t c = 0; c < SENSOR_CHANNELS; c++) {
+        expected_raw[c] = (uint16_t)((1000 * c) & 0xFFF);
+    }
+    memset(sensors, 0, sizeof(sensors));
+    init_environmental_monitor();
+    for (int c = 0; c < SENSOR_CHANNELS; c++) {
+        calibrate_channel(c, 0.0f, 1.0f, 1.0f);
+    }
+}
+
+/**
+ * @brief Continuous acquisition with a prompt main loop
+ *
+ * Runs a minute of scans, calling process_sensor_data after every scan as
+ * an idle main loop would. Every sample must reach processing, in order,
+ * across every half and every wrap, with no overruns.
+ * @return Number of failed checks
+ */
+static int check_continuous(void) {
+    const uint32_t scans = 60 * SAMPLE_RATE_HZ;
+
+    sim_reset();
+    for (uint32_t n = 0; n < scans; n++) {
+        sim_scan();
+        process_sensor_data();
+    }
+
+    uint32_t expected = (scans / BUFFER_SIZE) * BLOCK_WORDS;
+    printf("Continuous acquisition (%u scans at %dHz, %d channels, %d-scan blocks)\n",
+           (unsigned)scans, SAMPLE_RATE_HZ, SENSOR_CHANNELS, BUFFER_SIZE);
+    printf("  %u blocks, %u samples processed of %u, %u out of order, %u overruns\n",
+           (unsigned)acquisition.blocks, (unsigned)samples_seen, (unsigned)expected,
+           (unsigned)samples_out_of_order, (unsigned)acquisition.overruns);
+    if (samples_seen != expected || samples_out_of_order != 0 || acquisition.overruns != 0) {
+        printf("  FAILED\n");
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Late processing is counted and its data dropped
+ *
+ * Holds a block for longer than one block time, so the DMA wraps into it
+ * before it is given back, then leaves a block untaken until the DMA
+ * reaches it. Both must count as overruns, and the held block must be
+ * reported damaged.
+ * @return Number of failed checks
+ */
+static int check_overrun(void) {
+    uint32_t sequence;
+    int failures = 0;
+
+    sim_reset();
+    while (acquisition.blocks < 1) {
+        sim_scan();
+    }
+
+    // Held for a block and a half: the DMA is halfway through it again
+    const uint16_t* block = acquisition_take(&sequence);
+    for (uint32_t n = 0; n < BUFFER_SIZE * 3 / 2; n++) {
+        sim_scan();
+    }
+    bool intact = acquisition_release(block);
+    uint32_t held_overruns = acquisition.overruns;
+
+    // Block 1 is not taken at all: lost when the DMA wraps into it
+    while (acquisition.blocks < 3) {
+        sim_scan();
+    }
+    uint32_t skipped_overruns = acquisition.overruns - held_overruns;
+
+    // Prompt again: block 2 must be whole and numbered past the gap
+    const uint16_t* next = acquisition_take(&sequence);
+    bool next_intact = next != NULL && acquisition_release(next);
+
+    printf("Late processing\n");
+    printf("  held 1.5 blocks: %s, %u overrun; skipped: %u overrun; "
+           "next block %u %s\n", intact ? "intact" : "damaged", (unsigned)held_overruns,
+           (unsigned)skipped_overruns, (unsigned)sequence, next_intact ? "intact" : "damaged");
+    if (block == NULL || intact || held_overruns != 1 || skipped_overruns != 1 ||
+        !next_intact || sequence != 2) {
+        printf("  FAILED\n");
+        failures++;
+    }
+    return failures;
+}
+
+/**
+ * @brief Streaming statistics against a double-precision reference
+ *
+ * Each channel gets noise of a different spread around a different large
+ * offset (the case a sum-of-squares in float gets wrong). The engine fed a
+ * block at a time must match the reference mean, variance, min, max and
+ * EWMA, and two halves gathered separately and merged must match the whole.
+ * @return Number of failed checks
+ */
+static int check_statistics(void) {
+    #define STATS_CHECK_BLOCKS 900
+    static int16_t values[SENSOR_CHANNELS][STATS_CHECK_BLOCKS * BUFFER_SIZE];
+    const uint32_t total = STATS_CHECK_BLOCKS * BUFFER_SIZE;
+    const uint32_t split = 317 * BUFFER_SIZE;
+    uint32_t seed = 7;
+    int failures = 0;
+
+    printf("Streaming statistics (%s, %u samples per channel)\n",
+           STATS_FIXED_POINT ? "fixed point" : "floating point", (unsigned)total);
+    for (uint32_t c = 0; c < SENSOR_CHANNELS; c++) {
+        const int32_t base = 12000 - 9000 * (int32_t)c;
+        const int32_t spread = 50 << (2 * c);
+        for (uint32_t i = 0; i < total; i++) {
+            seed = seed * 1664525u + 1013904223u;
+            values[c][i] = (int16_t)(base + (int32_t)((seed >> 8) % (2 * spread + 1)) - spread);
+        }
+
+        double sum = 0.0, m2 = 0.0, ewma = values[c][0];
+        int16_t min = values[c][0], max = values[c][0];
+        for (uint32_t i = 0; i < total; i++) {
+            sum += values[c][i];
+            if (values[c][i] < min) min = values[c][i];
+            if (values[c][i] > max) max = values[c][i];
+            ewma += (values[c][i] - ewma) / (1 << STATS_EWMA_SHIFT);
+        }
+        double mean = sum / total;
+        for (uint32_t i = 0; i < total; i++) {
+            m2 += (values[c][i] - mean) * (values[c][i] - mean);
+        }
+        double std_deviation = sqrt(m2 / total);
+
+        channel_stats_t whole = { 0 }, first = { 0 }, second = { 0 };
+        for (uint32_t i = 0; i < total; i += BUFFER_SIZE) {
+            stats_update_block(&whole, &values[c][i], BUFFER_SIZE);
+            stats_update_block(i < split ? &first : &second, &values[c][i], BUFFER_SIZE);
+        }
+        stats_merge(&first, &second);
+
+        printf("  channel %u: mean %.3f (ref %.3f), std %.4f (ref %.4f), "
+               "min %d max %d, EWMA %.3f (ref %.3f)\n", (unsigned)c,
+               stats_mean(&whole), mean, stats_std_deviation(&whole), std_deviation,
+               whole.min, whole.max, stats_ewma(&whole), ewma);
+        bool ok = whole.count == total && whole.min == min && whole.max == max &&
+                  fabs(stats_mean(&whole) - mean) < 0.01 &&
+                  fabs(stats_std_deviation(&whole) - std_deviation) < 1e-4 * std_deviation &&
+                  fabs(stats_ewma(&whole) - ewma) < 0.05 &&
+                  first.count == total && first.min == min && first.max == max &&
+                  fabs(stats_mean(&first) - mean) < 0.01 &&
+                  fabs(stats_std_deviation(&first) - std_deviation) < 1e-4 * std_deviation;
+        if (!ok) {
+            printf("  FAILED\n");
+            failures++;
+        }
+    }
+    return failures;
+}
+
+/**
+ * @brief Each sensor's trend follows its own average
+ *
+ * Sensor 1 rises at 10 units/s while the others hold steady. The steady
+ * sensors must report TREND_STABLE, however the updates interleave.
+ * @return Number of failed checks
+ */
+static int check_trend(void) {
+    int16_t block[BUFFER_SIZE];
+    int16_t ramp = 0;
+
+    sim_reset();
+    for (uint32_t b = 0; b < 100; b++) {
+        sim_scans += BUFFER_SIZE;
+        for (int sensor = 0; sensor < SENSOR_CHANNELS; sensor++) {
+            for (int i = 0; i < BUFFER_SIZE; i++) {
+                block[i] = sensor == 1 ? ramp + i : (int16_t)(2000 + 1000 * sensor);
+            }
+            update_sensor_statistics(&sensors[sensor], block, BUFFER_SIZE, 0.01f);
+        }
+        ramp += BUFFER_SIZE;
+    }
+
+    printf("Trend detection\n");
+    int failures = 0;
+    for (int sensor = 0; sensor < SENSOR_CHANNELS; sensor++) {
+        trend_t expected = sensor == 1 ? TREND_RISING : TREND_STABLE;
+        printf("  sensor %d: average %.2f, trend %d (expected %d)\n", sensor,
+               sensors[sensor].moving_average, sensors[sensor].trend, expected);
+        if (sensors[sensor].trend != expected) {
+            failures++;
+        }
+    }
+    if (failures) {
+        printf("  FAILED\n");
+    }
+    return failures;
+}
+
+/**
+ * @brief Power-on calibration gives the units adc_to_physical_value did
+ *
+ * Converts every 12-bit code on every channel with the calibration
+ * init_environmental_monitor sets, and compares value * unit with the float
+ * conversion. One output LSB is one count, so they must agree to rounding.
+ * @return Number of failed checks
+ */
+static int check_default_calibration(void) {
+    static uint16_t block[BLOCK_WORDS];
+    float worst = 0.0f;
+
+    init_environmental_monitor();
+    for (uint32_t base = 0; base <= ADC_FULL_SCALE; base += BUFFER_SIZE) {
+        for (uint32_t i = 0; i < BLOCK_WORDS; i++) {
+            block[i] = (uint16_t)((base + i / SENSOR_CHANNELS) & ADC_FULL_SCALE);
+        }
+        convert_block(block, BUFFER_SIZE, &calibration, &sensor_values[0][0], BUFFER_SIZE);
+        for (int c = 0; c < SENSOR_CHANNELS; c++) {
+            for (int i = 0; i < BUFFER_SIZE; i++) {
+                float expected = adc_to_physical_value(block[i * SENSOR_CHANNELS + c], c);
+                float error = fabsf(sensor_values[c][i] * calibration.unit[c] - expected);
+                if (error > worst) worst = error;
+            }
+        }
+    }
+
+    printf("Default calibration against adc_to_physical_value\n");
+    printf("  worst difference %.2e\n", worst);
+    if (worst > 1e-3f) {
+        printf("  FAILED\n");
+        return 1;
+    }
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    if (argc > 1 && strcmp(argv[1], "--selftest") == 0) {
+        int failures = check_continuous();
+        failures += check_overrun();
+        failures += check_statistics();
+        failures += check_trend();
+        failures += check_default_calibration();
+        failures += benchmark_convert_block();
+        return failures ? 1 : 0;
+    }
+    fprintf(stderr, "usage: %s --selftest\n", argv[0]);
+    return 2;
+}
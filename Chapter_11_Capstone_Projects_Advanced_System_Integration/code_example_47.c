@@ -23,22 +23,259 @@
  * 4. Build and flash to your development board
  */
 
-#define MAX_VOICES 3
+#include "code_example_47_wavetables.h"
+
+#define MAX_VOICES 32
+#define VOICE_BATCH 4              // Voices mixed per SIMD step
+#define SILENT_VOICE MAX_VOICES    // Active-list padding entry, renders silence
+#define NO_VOICE 0xFF              // Empty link / unmapped note
 #define SAMPLE_RATE 48000
 #define AUDIO_BUFFER_SIZE 128
-#define EFFECTS_BUFFER_SIZE 1024
 
-// Voice structure with complete synthesis parameters
+// Reverb network: parallel lowpass-feedback combs into series allpasses.
+// Delay lines are powers of two so indices wrap with a mask, not a divide.
+#define REVERB_COMBS 4
+#define REVERB_ALLPASSES 2
+#define REVERB_COMB_SIZE 2048    // Must be a power of two >= longest comb delay
+#define REVERB_ALLPASS_SIZE 1024 // Must be a power of two >= longest allpass delay
+#define REVERB_COMB_MASK (REVERB_COMB_SIZE - 1)
+#define REVERB_ALLPASS_MASK (REVERB_ALLPASS_SIZE - 1)
+
+// Place delay memory (40KB float, 20KB Q15) in the 64KB core-coupled RAM.
+// CCM is CPU-only, zero-wait-state and not zeroed by the startup code.
+#define REVERB_IN_CCMRAM 1
+#if REVERB_IN_CCMRAM && !defined(HOST_BUILD)
+#define REVERB_MEMORY __attribute__((section(".ccmram")))
+#else
+#define REVERB_MEMORY
+#endif
+
+// Render mode: 1 = fill whole DMA half-buffers from the DAC callbacks,
+// 0 = legacy one-sample-per-TIM_AUDIO-interrupt rendering (kept for A/B timing)
+#define AUDIO_BLOCK_RENDERING 1
+
+// Sample format: 1 = Q15 samples with Q31 accumulators end to end (no FPU
+// needed while rendering), 0 = float effects chain. Both produce DAC codes.
+#ifndef AUDIO_FIXED_POINT
+#define AUDIO_FIXED_POINT 0
+#endif
+
+#define Q15_ONE 32767
+#define Q31_ONE 0x7FFFFFFF
+#define SVF_STATE_SHIFT 12       // Filter state is Q4.27: Q15 << 12, 16x headroom
+#define DISTORTION_MAX_DRIVE 15.0f // Full-scale Q15 input times Q12 drive fits int32
+#define AUDIO_DENORMAL_GUARD 1e-18f // Inaudible DC fed into float recursions
+
+// Control rate: envelopes advance once per CONTROL_BLOCK samples and voice
+// gains ramp linearly between control points (3kHz at 48kHz)
+#define CONTROL_BLOCK 16
+#define CONTROL_BLOCK_SHIFT 4    // log2(CONTROL_BLOCK)
+
+// Wavetable oscillator: 32-bit phase, top bits index the table, next 15 interpolate
+#define WAVETABLE_INDEX_BITS 8   // log2(WAVETABLE_SIZE)
+#define PHASE_INDEX_SHIFT (32 - WAVETABLE_INDEX_BITS)
+#define PHASE_FRAC_SHIFT (PHASE_INDEX_SHIFT - 15)
+
+// Voice mixer instruction set: Cortex-M4 DSP extension on target,
+// SSE2 or NEON on the host build, plain C otherwise. SSE2 also runs each
+// batch's oscillators four voices to a vector.
+#if defined(__ARM_FEATURE_DSP)
+#define VOICE_MIX_DSP 1
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define VOICE_MIX_SSE2 1
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define VOICE_MIX_NEON 1
+#endif
+
+// Cycle counter used for render timing (TSC ticks or ns on the host build)
+#ifdef HOST_BUILD
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define audio_cycle_count() ((uint32_t)__rdtsc())
+#else
+#include <time.h>
+static inline uint32_t audio_cycle_count(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)(ts.tv_sec * 1000000000ull + ts.tv_nsec);
+}
+#endif
+#else
+#define audio_cycle_count() (DWT->CYCCNT)
+#endif
+
+// Barrier between writing a queue slot and publishing its index
+#ifdef HOST_BUILD
+#define audio_memory_barrier() __atomic_thread_fence(__ATOMIC_SEQ_CST)
+#else
+#define audio_memory_barrier() __DMB()
+#endif
+
+// CPU load: running load is a 1/8-weight moving average of per-block load.
+// Above the shed threshold one voice is dropped every AUDIO_SHED_HOLDOFF
+// blocks and the voice limit follows; below the restore threshold the
+// limit grows back by one voice per block. Shedding starts off in the host
+// build, where the load is wall-clock time and would make renders depend
+// on scheduling (see audio_set_load_shedding).
+#define AUDIO_LOAD_SMOOTHING 0.125f
+#define AUDIO_LOAD_SHED_PERCENT 85.0f
+#define AUDIO_LOAD_RESTORE_PERCENT 70.0f
+#define AUDIO_SHED_HOLDOFF 8      // Blocks for the average to see a shed voice
+#define AUDIO_MIN_VOICES 4        // Never shed below this polyphony
+
+// MIDI event queue from the UART receive interrupt to the audio renderer
+#define MIDI_QUEUE_SIZE 64       // Must be a power of two
+#define MIDI_QUEUE_MASK (MIDI_QUEUE_SIZE - 1)
+
+// Events are stamped this many samples ahead of the DAC output position.
+// Two halves is the earliest point the renderer can still place them, so
+// every event gets the same latency (5.3ms) instead of block-sized jitter.
+#define MIDI_EVENT_LATENCY (2 * AUDIO_BUFFER_SIZE)
+
+// ADSR envelope with linear segments
+typedef enum {
+    ENV_IDLE,
+    ENV_ATTACK,
+    ENV_DECAY,
+    ENV_SUSTAIN,
+    ENV_RELEASE
+} env_stage_t;
+
+typedef struct {
+    env_stage_t stage;
+    float level;                 // 0.0 to 1.0
+} envelope_f32_t;
+
+typedef struct {
+    env_stage_t stage;
+    int32_t level;               // Q31, 0 to Q31_ONE
+} envelope_q31_t;
+
+// Per-control-tick segment steps shared by all voices, in both formats
+typedef struct {
+    float attack_step, decay_step, sustain_level, release_step;
+    int32_t attack_step_q31, decay_step_q31, sustain_level_q31, release_step_q31;
+} envelope_rates_t;
+
+// Chamberlin state-variable filter, lowpass output
+typedef struct {
+    float f, q;                  // Tuning and damping coefficients
+    float low, band;
+} svf_f32_t;
+
+typedef struct {
+    int32_t f;                   // Q15
+    int32_t q;                   // Q14 (damping reaches 2.0)
+    int32_t low, band;           // Q4.27
+} svf_q15_t;
+
+// Soft-clip distortion: soft_clip(x * drive) / drive
+typedef struct {
+    bool enabled;
+    float drive, inv_drive;
+} distortion_f32_t;
+
+typedef struct {
+    bool enabled;
+    int32_t drive, inv_drive;    // Q12 (drive 0.1 to DISTORTION_MAX_DRIVE)
+} distortion_q15_t;
+
+// Reverb network state. All lines share one write counter; each line masks
+// it with its own size, and reads at (pos - delay).
+typedef struct {
+    float comb[REVERB_COMBS][REVERB_COMB_SIZE];
+    float allpass[REVERB_ALLPASSES][REVERB_ALLPASS_SIZE];
+    float comb_store[REVERB_COMBS];   // Damping lowpass state per comb
+    uint32_t pos;
+    float feedback, damp, mix;
+} reverb_f32_t;
+
 typedef struct {
-    float frequency;
-    float phase;
-    float amplitude;
-    waveform_t waveform;
-    adsr_state_t envelope;
-    bool active;
-    uint8_t midi_note;
-    uint8_t velocity;
-} voice_t;
+    int16_t comb[REVERB_COMBS][REVERB_COMB_SIZE];
+    int16_t allpass[REVERB_ALLPASSES][REVERB_ALLPASS_SIZE];
+    int32_t comb_store[REVERB_COMBS];
+    uint32_t pos;
+    int32_t feedback, damp, mix;      // Q15
+} reverb_q15_t;
+
+#if AUDIO_FIXED_POINT
+typedef envelope_q31_t envelope_t;
+#else
+typedef envelope_f32_t envelope_t;
+#endif
+
+// Structure-of-arrays voice store. Per-sample state lives in parallel arrays
+// and active_list packs the indices of sounding voices, so rendering cost
+// follows the number of active voices rather than MAX_VOICES. Entries past
+// active_count always hold SILENT_VOICE so the last batch needs no tail code.
+typedef struct {
+    // Oscillator and envelope state (touched every sample)
+    uint32_t phase_acc[MAX_VOICES];   // Wavetable phase (full scale = 1 cycle)
+    uint32_t phase_inc[MAX_VOICES];   // Per-sample increment, set at note-on
+    const int16_t* table[MAX_VOICES]; // Band-limited table chosen for the note
+    int16_t amplitude[MAX_VOICES];    // Velocity gain, Q15
+    envelope_t envelope[MAX_VOICES];
+    int32_t gain_acc[MAX_VOICES];     // Ramped output gain, Q15 << 16
+    int32_t gain_step[MAX_VOICES];    // Per-sample ramp increment
+    uint8_t ramp_left[MAX_VOICES];    // Samples until the next control point
+    
+    // Note data (touched at note-on/off only)
+    float frequency[MAX_VOICES];
+    waveform_t waveform[MAX_VOICES];
+    uint8_t midi_note[MAX_VOICES];
+    uint8_t velocity[MAX_VOICES];
+    uint32_t start_order[MAX_VOICES]; // Note-on sequence number, for stealing
+    bool active[MAX_VOICES];
+    
+    // Packed list of active voice indices
+    uint8_t active_list[MAX_VOICES + VOICE_BATCH - 1];
+    uint8_t active_pos[MAX_VOICES];   // Position of each active voice in the list
+    uint8_t active_count;
+    
+    // Allocator: free stack, intrusive age lists (oldest at head) per
+    // AGE_HELD / AGE_RELEASED, and the voice currently holding each note
+    uint8_t free_stack[MAX_VOICES];
+    uint8_t free_count;
+    uint8_t age_prev[MAX_VOICES];
+    uint8_t age_next[MAX_VOICES];
+    uint8_t age_list[MAX_VOICES];     // List each allocated voice is on
+    uint8_t list_head[2];
+    uint8_t list_tail[2];
+    uint8_t note_to_voice[128];
+    uint32_t steal_count;
+    uint8_t voice_limit;              // Polyphony allowed by the load governor
+} voice_store_t;
+
+enum {
+    AGE_HELD,                    // Key still down
+    AGE_RELEASED                 // Note off received, envelope releasing
+};
+
+// Which voice to take when all voices are sounding
+typedef enum {
+    VOICE_STEAL_OLDEST,          // Longest sounding, held or released
+    VOICE_STEAL_QUIETEST,        // Quieter of the oldest held and oldest released
+    VOICE_STEAL_RELEASED_FIRST   // Oldest released voice, else oldest held
+} voice_steal_policy_t;
+
+// Timestamped MIDI channel message
+typedef struct {
+    uint32_t timestamp;          // Sample clock at which to apply the event
+    uint8_t status;
+    uint8_t data1;
+    uint8_t data2;
+} midi_event_t;
+
+// Single-producer/single-consumer ring. Only the producer writes head and
+// only the consumer writes tail, so neither side needs to mask interrupts.
+typedef struct {
+    midi_event_t events[MIDI_QUEUE_SIZE];
+    volatile uint32_t head;
+    volatile uint32_t tail;
+    volatile uint32_t overflows;
+} midi_queue_t;
 
 // Effects parameters
 typedef struct {
@@ -49,173 +286,2081 @@ typedef struct {
     float distortion_drive;
 } effects_params_t;
 
-static voice_t voices[MAX_VOICES];
-static float audio_buffer_a[AUDIO_BUFFER_SIZE];
-static float audio_buffer_b[AUDIO_BUFFER_SIZE];
-static volatile float* active_audio_buffer = audio_buffer_a;
+// Render timing collected with the DWT cycle counter
+typedef struct {
+    uint32_t total_cycles;       // Cycles spent rendering since last reset
+    uint32_t total_samples;      // Samples rendered since last reset
+    uint32_t peak_block_cycles;  // Worst single render call (block or sample)
+    uint32_t reverb_block_cycles; // Reverb cost of the last block
+    uint32_t reverb_peak_cycles; // Worst reverb block since last reset
+    float load_percent;          // Running load, % of the real-time budget
+    float peak_load_percent;     // Worst single block since last reset
+    uint32_t underruns;          // Blocks finished after the DMA reached them
+    uint32_t overruns;           // Refills that started a whole half late
+    uint32_t voices_shed;        // Voices dropped by the load governor
+    uint32_t shed_holdoff;       // Blocks until the next shed is allowed
+} audio_render_stats_t;
+
+// Snapshot returned by audio_get_load_stats()
+typedef struct {
+    float load_percent;
+    float peak_load_percent;
+    uint32_t peak_block_cycles;
+    uint32_t budget_cycles;      // Cycles available per AUDIO_BUFFER_SIZE block
+    uint32_t underruns;
+    uint32_t overruns;
+    uint32_t voices_shed;
+    uint8_t active_voices;
+    uint8_t voice_limit;
+} audio_load_stats_t;
+
+static voice_store_t voice_store;
+static uint32_t note_on_counter = 0;
+static voice_steal_policy_t voice_steal_policy = VOICE_STEAL_RELEASED_FIRST;
+
+// Sample clock: index of the first frame of the next block to render, and
+// of the first frame in the half the DMA is currently playing
+static volatile uint32_t render_clock = 0;
+static volatile uint32_t playing_half_start = 0;
+static volatile uint32_t playing_half = 0;
+
+static midi_queue_t midi_queue;
+static uint8_t midi_rx_byte;
 static effects_params_t effects;
+static effects_params_t effects_applied;   // Values the coefficients were built from
+static bool effects_applied_valid = false;
+
+// One circular DMA buffer: the DAC plays one half while the CPU fills the other
+static uint16_t dac_buffer[2 * AUDIO_BUFFER_SIZE];
+static volatile audio_render_stats_t render_stats;
+#ifdef HOST_BUILD
+static bool load_shedding_enabled = false;
+#else
+static bool load_shedding_enabled = true;
+#endif
+
+// Batch scratch: sample n of batch voice k is stored at [n * VOICE_BATCH + k],
+// so each sample's four oscillator values and gains are contiguous
+static int16_t batch_osc[AUDIO_BUFFER_SIZE * VOICE_BATCH] __attribute__((aligned(16)));
+static int16_t batch_gain[AUDIO_BUFFER_SIZE * VOICE_BATCH] __attribute__((aligned(16)));
+static int32_t voice_mix[AUDIO_BUFFER_SIZE] __attribute__((aligned(16)));
 
-// Circular delay buffer for reverb
-static float reverb_buffer[EFFECTS_BUFFER_SIZE];
-static uint16_t reverb_index = 0;
+static envelope_rates_t envelope_rates;
+
+// Effects chain state in the selected sample format
+// fx_filter_target holds coefficients only; fx_filter glides to it over a block
+#if AUDIO_FIXED_POINT
+static svf_q15_t fx_filter;
+static svf_q15_t fx_filter_target;
+static distortion_q15_t fx_distortion;
+static reverb_q15_t fx_reverb REVERB_MEMORY;
+#else
+static svf_f32_t fx_filter;
+static svf_f32_t fx_filter_target;
+static distortion_f32_t fx_distortion;
+static reverb_f32_t fx_reverb REVERB_MEMORY;
+static float fx_block[AUDIO_BUFFER_SIZE];
+#endif
+
+// Freeverb tunings rescaled from 44.1kHz to 48kHz (mutually prime lengths)
+static const uint16_t reverb_comb_delays[REVERB_COMBS] = { 1215, 1293, 1390, 1476 };
+static const uint16_t reverb_allpass_delays[REVERB_ALLPASSES] = { 605, 480 };
+
+void render_voices(int32_t* mix, uint32_t frames);
+void render_voices_with_events(int32_t* mix, uint32_t frames);
+void handle_midi_note_on(uint8_t note, uint8_t velocity);
+void handle_midi_note_off(uint8_t note);
+void envelope_configure(float attack_s, float decay_s, float sustain, float release_s);
+void effects_update_coefficients(void);
+void apply_effects_block_q15(int32_t* io, uint32_t frames);
+void apply_effects_block(float* io, uint32_t frames);
+static void audio_update_load(uint32_t cycles, uint32_t frames);
 
 /**
  * @brief Initialize high-performance audio synthesis system
  */
 HAL_StatusTypeDef init_audio_synthesizer(void) {
-    // Configure high-speed timer for 48kHz DAC triggering
+    // Configure high-speed timer for 48kHz DAC triggering (TRGO -> DAC)
     configure_audio_timer(SAMPLE_RATE);
     
+    // Enable DWT cycle counter for render timing
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+    
     // Initialize voices
     for (int i = 0; i < MAX_VOICES; i++) {
-        voices[i].active = false;
-        voices[i].waveform = WAVEFORM_SINE;
-        init_adsr_envelope(&voices[i].envelope);
+        voice_store.active[i] = false;
+        voice_store.waveform[i] = WAVEFORM_SINE;
+        voice_store.envelope[i].stage = ENV_IDLE;
+        voice_store.envelope[i].level = 0;
+        voice_store.gain_acc[i] = 0;
+        voice_store.ramp_left[i] = 0;
+    }
+    envelope_configure(0.005f, 0.1f, 0.7f, 0.2f);
+    
+    // Default effect settings
+    effects.filter_cutoff = 8000.0f;
+    effects.filter_resonance = 0.2f;
+    effects.distortion_drive = 0.0f;
+    effects.reverb_time = 0.3f;
+    effects.reverb_mix = 0.2f;
+    effects_applied_valid = false;
+    for (int i = 0; i < MAX_VOICES + VOICE_BATCH - 1; i++) {
+        voice_store.active_list[i] = SILENT_VOICE;
+    }
+    voice_store.active_count = 0;
+    
+    // All voices start on the free stack, voice 0 on top
+    voice_store.free_count = MAX_VOICES;
+    for (int i = 0; i < MAX_VOICES; i++) {
+        voice_store.free_stack[i] = (uint8_t)(MAX_VOICES - 1 - i);
+    }
+    voice_store.list_head[AGE_HELD] = voice_store.list_tail[AGE_HELD] = NO_VOICE;
+    voice_store.list_head[AGE_RELEASED] = voice_store.list_tail[AGE_RELEASED] = NO_VOICE;
+    memset(voice_store.note_to_voice, NO_VOICE, sizeof(voice_store.note_to_voice));
+    voice_store.steal_count = 0;
+    voice_store.voice_limit = MAX_VOICES;
+    
+    // CCM is not cleared by the startup code; clear the filter state too so
+    // a re-init renders exactly like a cold start
+    memset(&fx_reverb, 0, sizeof(fx_reverb));
+    memset(&fx_filter, 0, sizeof(fx_filter));
+    
+    // Pre-fill with silence (DAC mid-scale) so the first half played is clean
+    for (int i = 0; i < 2 * AUDIO_BUFFER_SIZE; i++) {
+        dac_buffer[i] = 2048;
     }
     
-    // Start audio processing
+#if AUDIO_BLOCK_RENDERING
+    // Timer only triggers the DAC; rendering is driven by the DMA callbacks
+    HAL_TIM_Base_Start(&htim_audio);
+#else
     HAL_TIM_Base_Start_IT(&htim_audio);
-    HAL_DAC_Start_DMA(&hdac1, (uint32_t*)active_audio_buffer, AUDIO_BUFFER_SIZE);
+#endif
+    
+    // DMA stream must be configured as circular in STM32CubeMX
+    HAL_DAC_Start_DMA(&hdac1, DAC_CHANNEL_1, (uint32_t*)dac_buffer,
+                      2 * AUDIO_BUFFER_SIZE, DAC_ALIGN_12B_R);
+    
+    // MIDI input, one byte per receive interrupt
+    HAL_UART_Receive_IT(&huart_midi, &midi_rx_byte, 1);
     
     return HAL_OK;
 }
 
+/**
+ * @brief Convert one rendered sample to 12-bit DAC format
+ * 
+ * Distortion, reverb and the wet gain can push the float path past full
+ * scale, so it is clipped here rather than wrapping the DAC code.
+ */
+static inline uint16_t sample_to_dac(float sample) {
+    if (sample > 1.0f) sample = 1.0f;
+    if (sample < -1.0f) sample = -1.0f;
+    return (uint16_t)((sample + 1.0f) * 2047.5f);
+}
+
+/**
+ * @brief Convert one Q15 sample to 12-bit DAC format (shift and offset only)
+ */
+static inline uint16_t q15_to_dac(int32_t sample) {
+    return (uint16_t)((sample + 32768) >> 4);
+}
+
+/**
+ * @brief Render a block of samples into the DAC buffer
+ * @param dst Destination half of dac_buffer
+ * @param frames Number of samples to render
+ */
+void render_audio_block(uint16_t* dst, uint32_t frames) {
+    uint32_t start = audio_cycle_count();
+    
+    // Effect parameters are sampled once per block (recomputed on change)
+    effects_update_coefficients();
+    
+    // Mix all active voices for the whole block (Q30), applying queued
+    // MIDI events at their sample positions
+    render_voices_with_events(voice_mix, frames);
+    
+#if AUDIO_FIXED_POINT
+    for (uint32_t n = 0; n < frames; n++) {
+        voice_mix[n] >>= 15;     // Q30 -> Q15 in place
+    }
+    apply_effects_block_q15(voice_mix, frames);
+    for (uint32_t n = 0; n < frames; n++) {
+        dst[n] = q15_to_dac(voice_mix[n]);
+    }
+#else
+    for (uint32_t n = 0; n < frames; n++) {
+        fx_block[n] = (float)voice_mix[n] * (1.0f / 1073741824.0f);
+    }
+    apply_effects_block(fx_block, frames);
+    for (uint32_t n = 0; n < frames; n++) {
+        dst[n] = sample_to_dac(fx_block[n]);
+    }
+#endif
+    
+    uint32_t cycles = audio_cycle_count() - start;
+    render_stats.total_cycles += cycles;
+    render_stats.total_samples += frames;
+    if (cycles > render_stats.peak_block_cycles) {
+        render_stats.peak_block_cycles = cycles;
+    }
+    audio_update_load(cycles, frames);
+}
+
+/**
+ * @brief Half of dac_buffer the DMA is reading right now (0 or 1)
+ */
+static inline uint32_t audio_dma_half(void) {
+    uint32_t dma_pos = 2 * AUDIO_BUFFER_SIZE - __HAL_DMA_GET_COUNTER(hdac1.DMA_Handle1);
+    return (dma_pos / AUDIO_BUFFER_SIZE) & 1;
+}
+
+/**
+ * @brief Refill one half of dac_buffer, checking the DMA position around it
+ * 
+ * While a half is refilled the DMA must be playing the other half. If it is
+ * already in the target half on entry, the interrupt was held off for a
+ * whole block and stale audio was replayed (overrun). If it has reached the
+ * target half by the time rendering ends, the block was too slow and the
+ * start of it went out stale (underrun).
+ */
+static void audio_refill_half(uint32_t half) {
+    if (audio_dma_half() == half) {
+        render_stats.overruns++;
+    }
+    
+    render_audio_block(&dac_buffer[half * AUDIO_BUFFER_SIZE], AUDIO_BUFFER_SIZE);
+    
+    if (audio_dma_half() == half) {
+        render_stats.underruns++;
+    }
+}
+
+#if AUDIO_BLOCK_RENDERING
+/**
+ * @brief DAC DMA half-transfer: first half played out, refill it
+ */
+void HAL_DAC_ConvHalfCpltCallbackCh1(DAC_HandleTypeDef* hdac) {
+    (void)hdac;
+    // DAC now plays the second half, which holds the previous block
+    playing_half_start = render_clock - AUDIO_BUFFER_SIZE;
+    playing_half = 1;
+    audio_refill_half(0);
+}
+
+/**
+ * @brief DAC DMA transfer complete: second half played out, refill it
+ */
+void HAL_DAC_ConvCpltCallbackCh1(DAC_HandleTypeDef* hdac) {
+    (void)hdac;
+    playing_half_start = render_clock - AUDIO_BUFFER_SIZE;
+    playing_half = 0;
+    audio_refill_half(1);
+}
+#else
 /**
  * @brief High-priority audio processing interrupt (48kHz)
+ * 
+ * Legacy per-sample mode: one interrupt and one render call per output
+ * sample. Kept so the per-sample cost can be compared with block mode.
  */
 void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef *htim) {
     if (htim->Instance == TIM_AUDIO) {
         static uint32_t buffer_index = 0;
         
-        // Generate audio sample
-        float sample = generate_audio_sample();
-        
-        // Apply effects chain
-        sample = apply_effects_chain(sample);
-        
-        // Convert to DAC format and store
-        uint16_t dac_value = (uint16_t)((sample + 1.0f) * 2047.5f);
-        active_audio_buffer[buffer_index] = dac_value;
+        playing_half_start = render_clock - 2 * AUDIO_BUFFER_SIZE;
+        playing_half = 0;
+        render_audio_block(&dac_buffer[buffer_index], 1);
         
         buffer_index++;
-        if (buffer_index >= AUDIO_BUFFER_SIZE) {
+        if (buffer_index >= 2 * AUDIO_BUFFER_SIZE) {
             buffer_index = 0;
-            // Switch buffers
-            active_audio_buffer = (active_audio_buffer == audio_buffer_a) ? 
-                                  audio_buffer_b : audio_buffer_a;
         }
     }
 }
+#endif
+
+/**
+ * @brief Average render cost in CPU cycles per output sample
+ * 
+ * Compare AUDIO_BLOCK_RENDERING 0 and 1 with the same voice load. Hardware
+ * exception entry/exit (~24 cycles per interrupt) is not included, so the
+ * real per-sample saving of block mode is larger than the difference shown.
+ */
+float audio_get_cycles_per_sample(void) {
+    if (render_stats.total_samples == 0) {
+        return 0.0f;
+    }
+    return (float)render_stats.total_cycles / render_stats.total_samples;
+}
+
+/**
+ * @brief Clear render timing statistics
+ */
+void audio_reset_render_stats(void) {
+    render_stats.total_cycles = 0;
+    render_stats.total_samples = 0;
+    render_stats.peak_block_cycles = 0;
+    render_stats.reverb_peak_cycles = 0;
+    render_stats.peak_load_percent = 0.0f;
+    render_stats.underruns = 0;
+    render_stats.overruns = 0;
+    render_stats.voices_shed = 0;
+}
+
+/**
+ * @brief CPU cycles available for rendering a given number of samples
+ */
+static inline uint32_t audio_budget_cycles(uint32_t frames) {
+    return (uint32_t)((uint64_t)SystemCoreClock * frames / SAMPLE_RATE);
+}
+
+/**
+ * @brief Let the load governor shed voices (default on target, off on host)
+ * 
+ * The load meter runs either way. Disabling it leaves voice_limit where it is.
+ */
+void audio_set_load_shedding(bool enabled) {
+    load_shedding_enabled = enabled;
+}
 
 /**
- * @brief Generate polyphonic audio sample
+ * @brief Update the load meter after a render and govern polyphony
+ * 
+ * Shedding fades a voice out over one control tick (release heads first)
+ * and lowers voice_limit, so new notes steal instead of adding load back.
  */
-float generate_audio_sample(void) {
-    float mixed_sample = 0.0f;
-    int active_voice_count = 0;
+static void audio_update_load(uint32_t cycles, uint32_t frames) {
+    float load = 100.0f * cycles / audio_budget_cycles(frames);
     
-    for (int i = 0; i < MAX_VOICES; i++) {
-        if (voices[i].active) {
-            // Generate oscillator sample
-            float voice_sample = generate_oscillator_sample(&voices[i]);
-            
-            // Apply ADSR envelope
-            float envelope_value = process_adsr_envelope(&voices[i].envelope);
-            voice_sample *= envelope_value;
-            
-            // Mix with other voices
-            mixed_sample += voice_sample * voices[i].amplitude;
-            active_voice_count++;
-            
-            // Update voice parameters
-            update_voice_parameters(&voices[i]);
+    render_stats.load_percent += (load - render_stats.load_percent) * AUDIO_LOAD_SMOOTHING;
+    if (load > render_stats.peak_load_percent) {
+        render_stats.peak_load_percent = load;
+    }
+    if (!load_shedding_enabled) {
+        return;
+    }
+    
+    if (render_stats.shed_holdoff > 0) {
+        render_stats.shed_holdoff--;
+    } else if (render_stats.load_percent > AUDIO_LOAD_SHED_PERCENT &&
+               voice_store.active_count > AUDIO_MIN_VOICES) {
+        int v = voice_store.list_head[AGE_RELEASED];
+        if (v == NO_VOICE) {
+            v = voice_store.list_head[AGE_HELD];
         }
+        // Envelope to zero: the gain ramps down and render_voices retires it
+        voice_store.envelope[v].stage = ENV_IDLE;
+        voice_store.envelope[v].level = 0;
+        voice_store.ramp_left[v] = 0;
+        voice_store.voice_limit = voice_store.active_count - 1;
+        render_stats.voices_shed++;
+        render_stats.shed_holdoff = AUDIO_SHED_HOLDOFF;
+        return;
+    }
+    
+    if (render_stats.load_percent < AUDIO_LOAD_RESTORE_PERCENT &&
+        voice_store.voice_limit < MAX_VOICES) {
+        voice_store.voice_limit++;
+    }
+}
+
+/**
+ * @brief Read the CPU load meter, xrun counters and polyphony governor state
+ * 
+ * Safe to call from the main loop: every field is a single 32-bit read, so
+ * at worst the snapshot mixes values from two consecutive blocks.
+ */
+void audio_get_load_stats(audio_load_stats_t* stats) {
+    stats->load_percent = render_stats.load_percent;
+    stats->peak_load_percent = render_stats.peak_load_percent;
+    stats->peak_block_cycles = render_stats.peak_block_cycles;
+    stats->budget_cycles = audio_budget_cycles(AUDIO_BUFFER_SIZE);
+    stats->underruns = render_stats.underruns;
+    stats->overruns = render_stats.overruns;
+    stats->voices_shed = render_stats.voices_shed;
+    stats->active_voices = voice_store.active_count;
+    stats->voice_limit = voice_store.voice_limit;
+}
+
+
+/**
+ * @brief Select the band-limited table for a waveform and note frequency
+ * 
+ * Band k holds only harmonics below Nyquist for notes up to
+ * WAVETABLE_BAND0_TOP_HZ * 2^k. The lowest band whose top is at or above
+ * the note has the most harmonics that are still alias-free, so it gives
+ * the brightest tone.
+ */
+static const int16_t* wavetable_select(waveform_t waveform, float frequency) {
+    int band = 0;
+    float band_top = WAVETABLE_BAND0_TOP_HZ;
+    
+    while (band < WAVETABLE_BANDS - 1 && frequency > band_top) {
+        band_top *= 2.0f;
+        band++;
     }
     
-    // Normalize by active voice count to prevent clipping
-    if (active_voice_count > 0) {
-        mixed_sample /= active_voice_count;
+    switch (waveform) {
+        case WAVEFORM_SQUARE:   return wavetable_square[band];
+        case WAVEFORM_TRIANGLE: return wavetable_triangle[band];
+        case WAVEFORM_SAWTOOTH: return wavetable_sawtooth[band];
+        case WAVEFORM_SINE:
+        default:                return wavetable_sine;
     }
+}
+
+/**
+ * @brief Set up oscillator phase increment and table at note-on
+ * 
+ * The only divide and band search happen here, once per note.
+ */
+void oscillator_note_on(int v) {
+    voice_store.phase_inc[v] = (uint32_t)(voice_store.frequency[v] *
+                                          (4294967296.0f / SAMPLE_RATE));
+    voice_store.phase_acc[v] = 0;
+    voice_store.table[v] = wavetable_select(voice_store.waveform[v],
+                                            voice_store.frequency[v]);
+}
+
+/**
+ * @brief Read the wavetable at a phase with linear interpolation (Q15)
+ */
+static inline int32_t wavetable_read(const int16_t* table, uint32_t phase) {
+    uint32_t index = phase >> PHASE_INDEX_SHIFT;
+    int32_t frac = (phase >> PHASE_FRAC_SHIFT) & 0x7FFF;
     
-    return mixed_sample;
+    // Guard point at the end means index + 1 never wraps.
+    // A 15-bit fraction keeps the product inside 32 bits for any Q15 step.
+    int32_t s0 = table[index];
+    int32_t s1 = table[index + 1];
+    return s0 + (((s1 - s0) * frac) >> 15);
+}
+
+/**
+ * @brief Envelope step per control tick for a segment, at most one full span
+ */
+static float envelope_tick_step(float span, float seconds) {
+    float step = span * CONTROL_BLOCK / (seconds * SAMPLE_RATE);
+    return (step > 1.0f) ? 1.0f : step;
 }
 
 /**
- * @brief Apply real-time effects chain
+ * @brief Set ADSR segment times (seconds) and sustain level (0.0 to 1.0)
+ * 
+ * Converts times to per-control-tick steps for both formats, so the
+ * control loop only adds and compares.
  */
-float apply_effects_chain(float input) {
-    float output = input;
+void envelope_configure(float attack_s, float decay_s, float sustain, float release_s) {
+    envelope_rates.attack_step = envelope_tick_step(1.0f, attack_s);
+    envelope_rates.decay_step = envelope_tick_step(1.0f - sustain, decay_s);
+    envelope_rates.sustain_level = sustain;
+    envelope_rates.release_step = envelope_tick_step(1.0f, release_s);
     
-    // State-variable filter
-    static float filter_state[2] = {0, 0};
-    output = state_variable_filter(output, effects.filter_cutoff, 
-                                  effects.filter_resonance, filter_state);
+    envelope_rates.attack_step_q31 = (int32_t)(envelope_rates.attack_step * 2147483647.0);
+    envelope_rates.decay_step_q31 = (int32_t)(envelope_rates.decay_step * 2147483647.0);
+    envelope_rates.sustain_level_q31 = (int32_t)(sustain * 2147483647.0);
+    envelope_rates.release_step_q31 = (int32_t)(envelope_rates.release_step * 2147483647.0);
+}
+
+/**
+ * @brief Advance a float envelope by one control tick
+ */
+static inline float envelope_process_f32(envelope_f32_t* env) {
+    switch (env->stage) {
+        case ENV_ATTACK:
+            if (env->level >= 1.0f - envelope_rates.attack_step) {
+                env->level = 1.0f;
+                env->stage = ENV_DECAY;
+            } else {
+                env->level += envelope_rates.attack_step;
+            }
+            break;
+        case ENV_DECAY:
+            if (env->level - envelope_rates.sustain_level <= envelope_rates.decay_step) {
+                env->level = envelope_rates.sustain_level;
+                env->stage = ENV_SUSTAIN;
+            } else {
+                env->level -= envelope_rates.decay_step;
+            }
+            break;
+        case ENV_RELEASE:
+            if (env->level <= envelope_rates.release_step) {
+                env->level = 0.0f;
+                env->stage = ENV_IDLE;
+            } else {
+                env->level -= envelope_rates.release_step;
+            }
+            break;
+        default:
+            break;
+    }
+    return env->level;
+}
+
+/**
+ * @brief Advance a Q31 envelope by one control tick
+ */
+static inline int32_t envelope_process_q31(envelope_q31_t* env) {
+    switch (env->stage) {
+        case ENV_ATTACK:
+            if (env->level >= Q31_ONE - envelope_rates.attack_step_q31) {
+                env->level = Q31_ONE;
+                env->stage = ENV_DECAY;
+            } else {
+                env->level += envelope_rates.attack_step_q31;
+            }
+            break;
+        case ENV_DECAY:
+            if (env->level - envelope_rates.sustain_level_q31 <= envelope_rates.decay_step_q31) {
+                env->level = envelope_rates.sustain_level_q31;
+                env->stage = ENV_SUSTAIN;
+            } else {
+                env->level -= envelope_rates.decay_step_q31;
+            }
+            break;
+        case ENV_RELEASE:
+            if (env->level <= envelope_rates.release_step_q31) {
+                env->level = 0;
+                env->stage = ENV_IDLE;
+            } else {
+                env->level -= envelope_rates.release_step_q31;
+            }
+            break;
+        default:
+            break;
+    }
+    return env->level;
+}
+
+/**
+ * @brief Add a voice to the packed active list
+ */
+static void voice_activate(int v) {
+    uint8_t pos = voice_store.active_count++;
+    voice_store.active_list[pos] = (uint8_t)v;
+    voice_store.active_pos[v] = pos;
+    voice_store.active[v] = true;
+}
+
+/**
+ * @brief Append a voice to the newest end of an age list
+ */
+static void age_list_append(int list, int v) {
+    uint8_t tail = voice_store.list_tail[list];
     
-    // Soft-clipping distortion
-    if (effects.distortion_drive > 0.1f) {
-        output = soft_clip(output * effects.distortion_drive) / effects.distortion_drive;
+    voice_store.age_prev[v] = tail;
+    voice_store.age_next[v] = NO_VOICE;
+    voice_store.age_list[v] = (uint8_t)list;
+    if (tail == NO_VOICE) {
+        voice_store.list_head[list] = (uint8_t)v;
+    } else {
+        voice_store.age_next[tail] = (uint8_t)v;
     }
+    voice_store.list_tail[list] = (uint8_t)v;
+}
+
+/**
+ * @brief Unlink a voice from whichever age list it is on
+ */
+static void age_list_remove(int v) {
+    int list = voice_store.age_list[v];
+    uint8_t prev = voice_store.age_prev[v];
+    uint8_t next = voice_store.age_next[v];
     
-    // Digital reverb
-    float delayed_sample = reverb_buffer[reverb_index];
-    reverb_buffer[reverb_index] = output + delayed_sample * effects.reverb_time;
-    reverb_index = (reverb_index + 1) % EFFECTS_BUFFER_SIZE;
+    if (prev == NO_VOICE) {
+        voice_store.list_head[list] = next;
+    } else {
+        voice_store.age_next[prev] = next;
+    }
+    if (next == NO_VOICE) {
+        voice_store.list_tail[list] = prev;
+    } else {
+        voice_store.age_prev[next] = prev;
+    }
+}
+
+/**
+ * @brief Current voice loudness (ramped envelope x velocity gain), Q15
+ */
+static inline int32_t voice_level_q15(int v) {
+    return voice_store.gain_acc[v] >> 16;
+}
+
+/**
+ * @brief Choose a sounding voice to steal according to voice_steal_policy
+ * 
+ * Only the heads of the two age lists are candidates, so this is O(1).
+ * The oldest released voice has decayed longest, which makes it a good
+ * stand-in for the quietest released voice.
+ */
+static int voice_steal(void) {
+    int held = voice_store.list_head[AGE_HELD];
+    int released = voice_store.list_head[AGE_RELEASED];
     
-    output = output * (1.0f - effects.reverb_mix) + 
-             delayed_sample * effects.reverb_mix;
+    voice_store.steal_count++;
+    if (released == NO_VOICE) return held;
+    if (held == NO_VOICE) return released;
     
-    return output;
+    switch (voice_steal_policy) {
+        case VOICE_STEAL_OLDEST:
+            return ((int32_t)(voice_store.start_order[released] -
+                              voice_store.start_order[held]) < 0) ? released : held;
+        case VOICE_STEAL_QUIETEST:
+            return (voice_level_q15(released) <= voice_level_q15(held)) ? released : held;
+        case VOICE_STEAL_RELEASED_FIRST:
+        default:
+            return released;
+    }
 }
 
 /**
- * @brief MIDI note on handler with voice allocation
+ * @brief Take a voice for a new note: pop the free stack or steal, O(1)
+ * 
+ * Steals once voice_limit voices are sounding, even if voices are free.
  */
-void handle_midi_note_on(uint8_t note, uint8_t velocity) {
-    // Find available voice or steal oldest
-    int voice_index = find_available_voice();
-    if (voice_index == -1) {
-        voice_index = find_oldest_voice();
+static int voice_allocate(void) {
+    if (voice_store.free_count > 0 && voice_store.active_count < voice_store.voice_limit) {
+        return voice_store.free_stack[--voice_store.free_count];
     }
     
-    // Configure voice
-    voices[voice_index].midi_note = note;
-    voices[voice_index].velocity = velocity;
-    voices[voice_index].frequency = midi_note_to_frequency(note);
-    voices[voice_index].amplitude = velocity / 127.0f;
-    voices[voice_index].active = true;
+    int v = voice_steal();
+    age_list_remove(v);
+    if (voice_store.note_to_voice[voice_store.midi_note[v]] == v) {
+        voice_store.note_to_voice[voice_store.midi_note[v]] = NO_VOICE;
+    }
+    return v;
+}
+
+/**
+ * @brief Retire a finished voice: leave the active and age lists, free it
+ */
+static void voice_retire(int v) {
+    // Remove from the packed active list (swap with last)
+    uint8_t pos = voice_store.active_pos[v];
+    uint8_t last = voice_store.active_list[--voice_store.active_count];
+    
+    voice_store.active_list[pos] = last;
+    voice_store.active_pos[last] = pos;
+    voice_store.active_list[voice_store.active_count] = SILENT_VOICE;
+    voice_store.active[v] = false;
     
-    // Trigger envelope
-    trigger_adsr_envelope(&voices[voice_index].envelope);
+    age_list_remove(v);
+    if (voice_store.note_to_voice[voice_store.midi_note[v]] == v) {
+        voice_store.note_to_voice[voice_store.midi_note[v]] = NO_VOICE;
+    }
+    voice_store.free_stack[voice_store.free_count++] = (uint8_t)v;
 }
 
 /**
- * @brief Generate oscillator waveform sample
+ * @brief Control point: advance a voice's envelope and ramp its gain there
+ * @return Per-sample gain step reaching the new target in CONTROL_BLOCK samples
  */
-float generate_oscillator_sample(voice_t* voice) {
-    float sample = 0.0f;
+static inline int32_t voice_ramp_step(envelope_t* env, int32_t g, int32_t voice_gain) {
+#if AUDIO_FIXED_POINT
+    int32_t target = ((envelope_process_q31(env) >> 16) * voice_gain) >> 15;
+#else
+    int32_t target = (int32_t)(envelope_process_f32(env) * voice_gain);
+#endif
+    return ((target << 16) - g) >> CONTROL_BLOCK_SHIFT;
+}
+
+#if defined(VOICE_MIX_SSE2)
+/**
+ * @brief Render oscillator samples and gains for one batch of 4 voices (SSE2)
+ * 
+ * The four voices run in lockstep, one vector lane each, between control
+ * points; each voice keeps its own control grid, so a run ends at the first
+ * lane that needs one. Each lane's two interpolation points are one 32-bit
+ * load, and PMADDWD against (-frac, frac) forms (s1 - s0) * frac exactly,
+ * so the output matches wavetable_read bit for bit.
+ * @param batch Four entries of the active list (may include SILENT_VOICE)
+ * @param frames Number of samples
+ * @param gain_scale Per-voice gain normalization, Q15 (1 / active voice count)
+ */
+static void fill_voice_batch(const uint8_t* batch, uint32_t frames, int32_t gain_scale) {
+    static const int16_t silent_table[2] = { 0, 0 };
+    uint32_t phase[VOICE_BATCH] __attribute__((aligned(16)));
+    uint32_t inc[VOICE_BATCH] __attribute__((aligned(16)));
+    int32_t g[VOICE_BATCH] __attribute__((aligned(16)));
+    int32_t step[VOICE_BATCH] __attribute__((aligned(16)));
+    uint32_t ramp_left[VOICE_BATCH];
+    int32_t voice_gain[VOICE_BATCH];
+    const int16_t* table[VOICE_BATCH];
+    const __m128i frac_mask = _mm_set1_epi32(0x7FFF);
+    const __m128i low_half = _mm_set1_epi32(0xFFFF);
+    uint32_t n = 0;
     
-    switch (voice->waveform) {
-        case WAVEFORM_SINE:
-            sample = sinf(voice->phase * 2.0f * M_PI);
-            break;
-        case WAVEFORM_SQUARE:
-            sample = (voice->phase < 0.5f) ? 1.0f : -1.0f;
-            break;
-        case WAVEFORM_TRIANGLE:
-            sample = (voice->phase < 0.5f) ? 
-                     (4.0f * voice->phase - 1.0f) : 
-                     (3.0f - 4.0f * voice->phase);
-            break;
-        case WAVEFORM_SAWTOOTH:
-            sample = 2.0f * voice->phase - 1.0f;
-            break;
+    for (int k = 0; k < VOICE_BATCH; k++) {
+        int v = batch[k];
+        if (v == SILENT_VOICE) {
+            // Reads zeros at phase 0 with zero gain and never needs a control point
+            phase[k] = inc[k] = 0;
+            g[k] = step[k] = 0;
+            ramp_left[k] = UINT32_MAX;
+            table[k] = silent_table;
+            continue;
+        }
+        phase[k] = voice_store.phase_acc[v];
+        inc[k] = voice_store.phase_inc[v];
+        g[k] = voice_store.gain_acc[v];
+        step[k] = voice_store.gain_step[v];
+        ramp_left[k] = voice_store.ramp_left[v];
+        table[k] = voice_store.table[v];
+        voice_gain[k] = (voice_store.amplitude[v] * gain_scale) >> 15;
     }
     
-    // Update phase
-    voice->phase += voice->frequency / SAMPLE_RATE;
-    if (voice->phase >= 1.0f) {
-        voice->phase -= 1.0f;
+    const int16_t* t0 = table[0];
+    const int16_t* t1 = table[1];
+    const int16_t* t2 = table[2];
+    const int16_t* t3 = table[3];
+    
+    while (n < frames) {
+        uint32_t run = frames - n;
+        for (int k = 0; k < VOICE_BATCH; k++) {
+            if (ramp_left[k] == 0) {
+                step[k] = voice_ramp_step(&voice_store.envelope[batch[k]], g[k], voice_gain[k]);
+                ramp_left[k] = CONTROL_BLOCK;
+            }
+            if (ramp_left[k] < run) run = ramp_left[k];
+        }
+        for (int k = 0; k < VOICE_BATCH; k++) {
+            ramp_left[k] -= run;
+        }
+        
+        __m128i vphase = _mm_load_si128((const __m128i*)phase);
+        __m128i vinc = _mm_load_si128((const __m128i*)inc);
+        __m128i vg = _mm_load_si128((const __m128i*)g);
+        __m128i vstep = _mm_load_si128((const __m128i*)step);
+        for (uint32_t end = n + run; n < end; n++) {
+            // Gather each lane's (s0, s1) pair, s0 in the low half. Built in
+            // registers: reloading four scalar stores as one vector would
+            // stall on store forwarding.
+            __m128i index = _mm_srli_epi32(vphase, PHASE_INDEX_SHIFT);
+            int32_t p0, p1, p2, p3;
+            memcpy(&p0, &t0[_mm_cvtsi128_si32(index)], 4);
+            memcpy(&p1, &t1[_mm_cvtsi128_si32(_mm_shuffle_epi32(index, 1))], 4);
+            memcpy(&p2, &t2[_mm_cvtsi128_si32(_mm_shuffle_epi32(index, 2))], 4);
+            memcpy(&p3, &t3[_mm_cvtsi128_si32(_mm_shuffle_epi32(index, 3))], 4);
+            __m128i points = _mm_unpacklo_epi64(
+                _mm_unpacklo_epi32(_mm_cvtsi32_si128(p0), _mm_cvtsi32_si128(p1)),
+                _mm_unpacklo_epi32(_mm_cvtsi32_si128(p2), _mm_cvtsi32_si128(p3)));
+            __m128i frac = _mm_and_si128(_mm_srli_epi32(vphase, PHASE_FRAC_SHIFT), frac_mask);
+            __m128i weights = _mm_or_si128(_mm_slli_epi32(frac, 16),
+                                           _mm_and_si128(_mm_sub_epi32(_mm_setzero_si128(), frac),
+                                                         low_half));
+            __m128i s0 = _mm_srai_epi32(_mm_slli_epi32(points, 16), 16);
+            __m128i osc = _mm_add_epi32(s0, _mm_srai_epi32(_mm_madd_epi16(points, weights), 15));
+            // Round up so a falling ramp ends exactly on its target
+            __m128i gain = _mm_srai_epi32(_mm_add_epi32(vg, low_half), 16);
+            
+            // Low half: the four oscillator samples; high half: the four gains
+            __m128i packed = _mm_packs_epi32(osc, gain);
+            _mm_storel_epi64((__m128i*)&batch_osc[n * VOICE_BATCH], packed);
+            _mm_storel_epi64((__m128i*)&batch_gain[n * VOICE_BATCH],
+                             _mm_unpackhi_epi64(packed, packed));
+            vphase = _mm_add_epi32(vphase, vinc);   // Wraps for free on 32-bit overflow
+            vg = _mm_add_epi32(vg, vstep);
+        }
+        _mm_store_si128((__m128i*)phase, vphase);
+        _mm_store_si128((__m128i*)g, vg);
     }
     
-    return sample;
-}
\ No newline at end of file
+    for (int k = 0; k < VOICE_BATCH; k++) {
+        int v = batch[k];
+        if (v == SILENT_VOICE) continue;
+        voice_store.phase_acc[v] = phase[k];
+        voice_store.gain_acc[v] = g[k];
+        voice_store.gain_step[v] = step[k];
+        voice_store.ramp_left[v] = (uint8_t)ramp_left[k];
+    }
+}
+#else
+/**
+ * @brief Render oscillator samples and gains for one batch of 4 voices
+ * 
+ * Envelopes are evaluated only at control points, every CONTROL_BLOCK
+ * samples of each voice's life; in between the gain is a linear ramp, so a
+ * sample costs one table read and one add. The ramp state is kept per
+ * voice, so blocks split at MIDI events keep the same control grid.
+ * @param batch Four entries of the active list (may include SILENT_VOICE)
+ * @param frames Number of samples
+ * @param gain_scale Per-voice gain normalization, Q15 (1 / active voice count)
+ */
+static void fill_voice_batch(const uint8_t* batch, uint32_t frames, int32_t gain_scale) {
+    for (int k = 0; k < VOICE_BATCH; k++) {
+        int v = batch[k];
+        int16_t* osc = &batch_osc[k];
+        int16_t* gain = &batch_gain[k];
+        
+        if (v == SILENT_VOICE) {
+            for (uint32_t n = 0; n < frames; n++) {
+                osc[n * VOICE_BATCH] = 0;
+                gain[n * VOICE_BATCH] = 0;
+            }
+            continue;
+        }
+        
+        // Keep this voice's state in registers for the whole block
+        uint32_t phase = voice_store.phase_acc[v];
+        uint32_t inc = voice_store.phase_inc[v];
+        const int16_t* table = voice_store.table[v];
+        int32_t voice_gain = (voice_store.amplitude[v] * gain_scale) >> 15;
+        envelope_t* env = &voice_store.envelope[v];
+        int32_t g = voice_store.gain_acc[v];
+        int32_t step = voice_store.gain_step[v];
+        uint32_t ramp_left = voice_store.ramp_left[v];
+        uint32_t n = 0;
+        
+        while (n < frames) {
+            if (ramp_left == 0) {
+                step = voice_ramp_step(env, g, voice_gain);
+                ramp_left = CONTROL_BLOCK;
+            }
+            
+            uint32_t end = (frames - n < ramp_left) ? frames : n + ramp_left;
+            ramp_left -= end - n;
+            for (; n < end; n++) {
+                osc[n * VOICE_BATCH] = (int16_t)wavetable_read(table, phase);
+                // Round up so a falling ramp ends exactly on its target
+                gain[n * VOICE_BATCH] = (int16_t)((g + 0xFFFF) >> 16);
+                phase += inc;  // Wraps for free on 32-bit overflow
+                g += step;
+            }
+        }
+        
+        voice_store.phase_acc[v] = phase;
+        voice_store.gain_acc[v] = g;
+        voice_store.gain_step[v] = step;
+        voice_store.ramp_left[v] = (uint8_t)ramp_left;
+    }
+}
+#endif
+
+/**
+ * @brief Multiply-accumulate one batch into the Q30 mix: mix[n] += sum(osc * gain)
+ */
+static void mix_voice_batch(int32_t* mix, uint32_t frames) {
+    uint32_t n = 0;
+    
+#if defined(VOICE_MIX_DSP)
+    // Two SMLAD per sample: each multiplies two Q15 pairs and accumulates
+    const uint32_t* osc = (const uint32_t*)batch_osc;
+    const uint32_t* gain = (const uint32_t*)batch_gain;
+    for (; n < frames; n++) {
+        int32_t acc = mix[n];
+        acc = __SMLAD(osc[2 * n], gain[2 * n], acc);
+        acc = __SMLAD(osc[2 * n + 1], gain[2 * n + 1], acc);
+        mix[n] = acc;
+    }
+#elif defined(VOICE_MIX_SSE2)
+    // Four samples per step: PMADDWD forms pair sums, shuffles finish the batch
+    for (; n + 4 <= frames; n += 4) {
+        const __m128i* osc = (const __m128i*)&batch_osc[n * VOICE_BATCH];
+        const __m128i* gain = (const __m128i*)&batch_gain[n * VOICE_BATCH];
+        __m128 p0 = _mm_castsi128_ps(_mm_madd_epi16(_mm_load_si128(&osc[0]),
+                                                    _mm_load_si128(&gain[0])));
+        __m128 p1 = _mm_castsi128_ps(_mm_madd_epi16(_mm_load_si128(&osc[1]),
+                                                    _mm_load_si128(&gain[1])));
+        __m128i even = _mm_castps_si128(_mm_shuffle_ps(p0, p1, _MM_SHUFFLE(2, 0, 2, 0)));
+        __m128i odd = _mm_castps_si128(_mm_shuffle_ps(p0, p1, _MM_SHUFFLE(3, 1, 3, 1)));
+        __m128i acc = _mm_loadu_si128((const __m128i*)&mix[n]);
+        acc = _mm_add_epi32(acc, _mm_add_epi32(even, odd));
+        _mm_storeu_si128((__m128i*)&mix[n], acc);
+    }
+#elif defined(VOICE_MIX_NEON)
+    // Two samples per step: widening multiply, then pairwise adds
+    for (; n + 2 <= frames; n += 2) {
+        int16x8_t osc = vld1q_s16(&batch_osc[n * VOICE_BATCH]);
+        int16x8_t gain = vld1q_s16(&batch_gain[n * VOICE_BATCH]);
+        int32x4_t p = vmull_s16(vget_low_s16(osc), vget_low_s16(gain));
+        int32x4_t q = vmull_s16(vget_high_s16(osc), vget_high_s16(gain));
+        int32x2_t sums = vpadd_s32(vpadd_s32(vget_low_s32(p), vget_high_s32(p)),
+                                   vpadd_s32(vget_low_s32(q), vget_high_s32(q)));
+        vst1_s32(&mix[n], vadd_s32(vld1_s32(&mix[n]), sums));
+    }
+#endif
+    
+    // Scalar path (and tail for odd block sizes)
+    for (; n < frames; n++) {
+        const int16_t* osc = &batch_osc[n * VOICE_BATCH];
+        const int16_t* gain = &batch_gain[n * VOICE_BATCH];
+        mix[n] += osc[0] * gain[0] + osc[1] * gain[1] +
+                  osc[2] * gain[2] + osc[3] * gain[3];
+    }
+}
+
+/**
+ * @brief Render all active voices into a Q30 mix buffer
+ * 
+ * Gains are normalized by the active voice count, so their sum never
+ * exceeds 1.0 and the Q30 accumulator cannot overflow.
+ */
+void render_voices(int32_t* mix, uint32_t frames) {
+    uint8_t count = voice_store.active_count;
+    
+    for (uint32_t n = 0; n < frames; n++) {
+        mix[n] = 0;
+    }
+    if (count == 0) {
+        return;
+    }
+    
+    int32_t gain_scale = Q15_ONE / count;
+    for (uint8_t b = 0; b < count; b += VOICE_BATCH) {
+        fill_voice_batch(&voice_store.active_list[b], frames, gain_scale);
+        mix_voice_batch(mix, frames);
+    }
+    
+    // Retire voices whose release and final gain ramp have finished. Walking
+    // backwards means the swap-with-last in voice_retire only moves
+    // already-checked entries.
+    for (int i = count - 1; i >= 0; i--) {
+        int v = voice_store.active_list[i];
+        if (voice_store.envelope[v].stage == ENV_IDLE && voice_store.ramp_left[v] == 0) {
+            voice_retire(v);
+        }
+    }
+}
+
+/**
+ * @brief Saturate to the Q15 range
+ */
+static inline int32_t sat_q15(int32_t x) {
+    if (x > 32767) return 32767;
+    if (x < -32768) return -32768;
+    return x;
+}
+
+/**
+ * @brief Compute state-variable filter coefficients (float)
+ * @param resonance 0.0 (no peak) to 1.0 (near self-oscillation)
+ */
+void svf_set_f32(svf_f32_t* svf, float cutoff, float resonance) {
+    if (cutoff > SAMPLE_RATE / 6.0f) cutoff = SAMPLE_RATE / 6.0f;
+    svf->f = 2.0f * sinf((float)M_PI * cutoff / SAMPLE_RATE);
+    svf->q = 2.0f - 1.9f * resonance;
+    
+    // Chamberlin poles stay inside the unit circle while f^2 + 2fq < 4
+    float f_max = 0.95f * (sqrtf(svf->q * svf->q + 4.0f) - svf->q);
+    if (svf->f > f_max) svf->f = f_max;
+}
+
+/**
+ * @brief Compute state-variable filter coefficients (fixed point)
+ */
+void svf_set_q15(svf_q15_t* svf, float cutoff, float resonance) {
+    svf_f32_t coeffs;
+    svf_set_f32(&coeffs, cutoff, resonance);
+    svf->f = (int32_t)(coeffs.f * 32768.0f);
+    svf->q = (int32_t)(coeffs.q * 16384.0f);
+}
+
+/**
+ * @brief Filter one sample, lowpass output (float)
+ * 
+ * The guard offset keeps the state from decaying into denormals after the
+ * input goes silent, where every operation would stall the FPU.
+ */
+static inline float svf_process_f32(svf_f32_t* svf, float input) {
+    svf->low += svf->f * svf->band;
+    float high = input + AUDIO_DENORMAL_GUARD - svf->low - svf->q * svf->band;
+    svf->band += svf->f * high;
+    return svf->low;
+}
+
+/**
+ * @brief Filter one sample, lowpass output (Q15 in/out, Q4.27 state)
+ */
+static inline int32_t svf_process_q15(svf_q15_t* svf, int32_t input) {
+    svf->low += (int32_t)(((int64_t)svf->f * svf->band) >> 15);
+    int32_t high = input * (1 << SVF_STATE_SHIFT) - svf->low -
+                   (int32_t)(((int64_t)svf->q * svf->band) >> 14);
+    svf->band += (int32_t)(((int64_t)svf->f * high) >> 15);
+    return sat_q15(svf->low >> SVF_STATE_SHIFT);
+}
+
+/**
+ * @brief Set distortion drive for both formats
+ * 
+ * Limited to DISTORTION_MAX_DRIVE, so the Q15 path's full-scale input
+ * times its Q12 drive stays within int32.
+ */
+void distortion_set_f32(distortion_f32_t* dist, float drive) {
+    if (drive > DISTORTION_MAX_DRIVE) drive = DISTORTION_MAX_DRIVE;
+    dist->enabled = (drive > 0.1f);
+    dist->drive = drive;
+    dist->inv_drive = dist->enabled ? 1.0f / drive : 1.0f;
+}
+
+void distortion_set_q15(distortion_q15_t* dist, float drive) {
+    distortion_f32_t coeffs;
+    distortion_set_f32(&coeffs, drive);
+    dist->enabled = coeffs.enabled;
+    dist->drive = (int32_t)(coeffs.drive * 4096.0f);
+    dist->inv_drive = (int32_t)(coeffs.inv_drive * 4096.0f);
+}
+
+/**
+ * @brief Cubic soft clip, then undo the drive gain (float)
+ */
+static inline float distortion_process_f32(const distortion_f32_t* dist, float input) {
+    if (!dist->enabled) return input;
+    
+    float x = input * dist->drive;
+    if (x >= 1.0f) {
+        x = 2.0f / 3.0f;
+    } else if (x <= -1.0f) {
+        x = -2.0f / 3.0f;
+    } else {
+        x = x - x * x * x * (1.0f / 3.0f);
+    }
+    return x * dist->inv_drive;
+}
+
+/**
+ * @brief Cubic soft clip, then undo the drive gain (Q15)
+ */
+static inline int32_t distortion_process_q15(const distortion_q15_t* dist, int32_t input) {
+    if (!dist->enabled) return input;
+    
+    int32_t x = (input * dist->drive) >> 12;
+    if (x >= 32767) {
+        x = 21845;               // 2/3 in Q15
+    } else if (x <= -32768) {
+        x = -21845;
+    } else {
+        // x^3 is Q45; shift back to Q15 and multiply by 1/3 (10923 in Q15)
+        int32_t cube = (int32_t)(((int64_t)x * x * x) >> 30);
+        x = x - ((cube * 10923) >> 15);
+    }
+    return sat_q15((x * dist->inv_drive) >> 12);
+}
+
+/**
+ * @brief Set reverb decay and wet mix for both formats
+ * @param reverb_time 0.0 (small room) to 1.0 (long tail)
+ */
+void reverb_set_f32(reverb_f32_t* rv, float reverb_time, float mix) {
+    rv->feedback = 0.7f + 0.28f * reverb_time;
+    rv->damp = 0.2f;
+    rv->mix = mix;
+}
+
+void reverb_set_q15(reverb_q15_t* rv, float reverb_time, float mix) {
+    reverb_f32_t coeffs;
+    reverb_set_f32(&coeffs, reverb_time, mix);
+    rv->feedback = (int32_t)(coeffs.feedback * 32767.0f);
+    rv->damp = (int32_t)(coeffs.damp * 32767.0f);
+    rv->mix = (int32_t)(coeffs.mix * 32767.0f);
+}
+
+/**
+ * @brief Process a block through the reverb network in place (float)
+ * 
+ * Each comb runs over the whole block before the next, keeping its state in
+ * registers. This is safe because every delay is longer than the block.
+ * The guard offset written into each comb keeps a silent tail (and the
+ * allpasses it feeds) out of the denormal range.
+ */
+void reverb_process_block_f32(reverb_f32_t* rv, float* io, uint32_t frames) {
+    float wet[AUDIO_BUFFER_SIZE];
+    uint32_t pos = rv->pos;
+    float damp1 = rv->damp;
+    float damp2 = 1.0f - rv->damp;
+    
+    for (uint32_t n = 0; n < frames; n++) {
+        wet[n] = 0.0f;
+    }
+    
+    // Parallel combs with a one-pole lowpass in the feedback path
+    for (int c = 0; c < REVERB_COMBS; c++) {
+        float* line = rv->comb[c];
+        uint32_t delay = reverb_comb_delays[c];
+        float store = rv->comb_store[c];
+        
+        for (uint32_t n = 0; n < frames; n++) {
+            uint32_t w = (pos + n) & REVERB_COMB_MASK;
+            float out = line[(w - delay) & REVERB_COMB_MASK];
+            store = out * damp2 + store * damp1;
+            line[w] = io[n] * 0.03f + store * rv->feedback + AUDIO_DENORMAL_GUARD;
+            wet[n] += out;
+        }
+        rv->comb_store[c] = store;
+    }
+    
+    // Series allpasses diffuse the comb echoes
+    for (int a = 0; a < REVERB_ALLPASSES; a++) {
+        float* line = rv->allpass[a];
+        uint32_t delay = reverb_allpass_delays[a];
+        
+        for (uint32_t n = 0; n < frames; n++) {
+            uint32_t w = (pos + n) & REVERB_ALLPASS_MASK;
+            float buffered = line[(w - delay) & REVERB_ALLPASS_MASK];
+            float in = wet[n];
+            wet[n] = buffered - in;
+            line[w] = in + buffered * 0.5f;
+        }
+    }
+    
+    rv->pos = pos + frames;
+    
+    for (uint32_t n = 0; n < frames; n++) {
+        io[n] = io[n] * (1.0f - rv->mix) + wet[n] * 1.5f * rv->mix;
+    }
+}
+
+/**
+ * @brief Process a block through the reverb network in place (Q15)
+ */
+void reverb_process_block_q15(reverb_q15_t* rv, int32_t* io, uint32_t frames) {
+    int32_t wet[AUDIO_BUFFER_SIZE];
+    uint32_t pos = rv->pos;
+    int32_t damp1 = rv->damp;
+    int32_t damp2 = Q15_ONE - rv->damp;
+    
+    for (uint32_t n = 0; n < frames; n++) {
+        wet[n] = 0;
+    }
+    
+    for (int c = 0; c < REVERB_COMBS; c++) {
+        int16_t* line = rv->comb[c];
+        uint32_t delay = reverb_comb_delays[c];
+        int32_t store = rv->comb_store[c];
+        
+        for (uint32_t n = 0; n < frames; n++) {
+            uint32_t w = (pos + n) & REVERB_COMB_MASK;
+            int32_t out = line[(w - delay) & REVERB_COMB_MASK];
+            store = (out * damp2 + store * damp1) >> 15;
+            line[w] = (int16_t)sat_q15(((io[n] * 983) >> 15) +   // 0.03 in Q15
+                                       ((store * rv->feedback) >> 15));
+            wet[n] += out;
+        }
+        rv->comb_store[c] = store;
+    }
+    
+    for (int a = 0; a < REVERB_ALLPASSES; a++) {
+        int16_t* line = rv->allpass[a];
+        uint32_t delay = reverb_allpass_delays[a];
+        
+        for (uint32_t n = 0; n < frames; n++) {
+            uint32_t w = (pos + n) & REVERB_ALLPASS_MASK;
+            int32_t buffered = line[(w - delay) & REVERB_ALLPASS_MASK];
+            int32_t in = wet[n];
+            wet[n] = buffered - in;
+            line[w] = (int16_t)sat_q15(in + (buffered >> 1));
+        }
+    }
+    
+    rv->pos = pos + frames;
+    
+    for (uint32_t n = 0; n < frames; n++) {
+        // The allpasses can push wet to ~6x full scale, so the products can
+        // exceed int32 at high mix: accumulate the mix in 64 bits
+        int32_t wet_scaled = (wet[n] * 3) >> 1;
+        io[n] = sat_q15((int32_t)(((int64_t)io[n] * (Q15_ONE - rv->mix) +
+                                   (int64_t)wet_scaled * rv->mix) >> 15));
+    }
+}
+
+/**
+ * @brief Load changed effect parameters into the active chain's coefficients
+ * 
+ * Called once per block. Coefficients are only recomputed for parameters
+ * that differ from the last call, so an idle block costs a few compares.
+ * A new filter setting becomes the glide target for the next block.
+ */
+void effects_update_coefficients(void) {
+    bool all = !effects_applied_valid;
+    
+    if (all || effects.filter_cutoff != effects_applied.filter_cutoff ||
+        effects.filter_resonance != effects_applied.filter_resonance) {
+#if AUDIO_FIXED_POINT
+        svf_set_q15(&fx_filter_target, effects.filter_cutoff, effects.filter_resonance);
+#else
+        svf_set_f32(&fx_filter_target, effects.filter_cutoff, effects.filter_resonance);
+#endif
+        if (all) {
+            fx_filter.f = fx_filter_target.f;
+            fx_filter.q = fx_filter_target.q;
+        }
+    }
+    
+    if (all || effects.distortion_drive != effects_applied.distortion_drive) {
+#if AUDIO_FIXED_POINT
+        distortion_set_q15(&fx_distortion, effects.distortion_drive);
+#else
+        distortion_set_f32(&fx_distortion, effects.distortion_drive);
+#endif
+    }
+    
+    if (all || effects.reverb_time != effects_applied.reverb_time ||
+        effects.reverb_mix != effects_applied.reverb_mix) {
+#if AUDIO_FIXED_POINT
+        reverb_set_q15(&fx_reverb, effects.reverb_time, effects.reverb_mix);
+#else
+        reverb_set_f32(&fx_reverb, effects.reverb_time, effects.reverb_mix);
+#endif
+    }
+    
+    effects_applied = effects;
+    effects_applied_valid = true;
+}
+
+/**
+ * @brief Record reverb cost for one block
+ */
+static inline void reverb_record_cycles(uint32_t cycles) {
+    render_stats.reverb_block_cycles = cycles;
+    if (cycles > render_stats.reverb_peak_cycles) {
+        render_stats.reverb_peak_cycles = cycles;
+    }
+}
+
+#if AUDIO_FIXED_POINT
+/**
+ * @brief Apply real-time effects chain to a block in place (Q15)
+ */
+void apply_effects_block_q15(int32_t* io, uint32_t frames) {
+    if (fx_filter.f != fx_filter_target.f || fx_filter.q != fx_filter_target.q) {
+        // Filter setting changed: glide the coefficients across the block
+        int32_t f_step = (fx_filter_target.f - fx_filter.f) / (int32_t)frames;
+        int32_t q_step = (fx_filter_target.q - fx_filter.q) / (int32_t)frames;
+        for (uint32_t n = 0; n < frames; n++) {
+            fx_filter.f += f_step;
+            fx_filter.q += q_step;
+            int32_t output = svf_process_q15(&fx_filter, io[n]);
+            io[n] = distortion_process_q15(&fx_distortion, output);
+        }
+        fx_filter.f = fx_filter_target.f;
+        fx_filter.q = fx_filter_target.q;
+    } else {
+        for (uint32_t n = 0; n < frames; n++) {
+            int32_t output = svf_process_q15(&fx_filter, io[n]);
+            io[n] = distortion_process_q15(&fx_distortion, output);
+        }
+    }
+    
+    uint32_t start = audio_cycle_count();
+    reverb_process_block_q15(&fx_reverb, io, frames);
+    reverb_record_cycles(audio_cycle_count() - start);
+}
+#else
+/**
+ * @brief Apply real-time effects chain to a block in place
+ */
+void apply_effects_block(float* io, uint32_t frames) {
+    if (fx_filter.f != fx_filter_target.f || fx_filter.q != fx_filter_target.q) {
+        // Filter setting changed: glide the coefficients across the block
+        float f_step = (fx_filter_target.f - fx_filter.f) / frames;
+        float q_step = (fx_filter_target.q - fx_filter.q) / frames;
+        for (uint32_t n = 0; n < frames; n++) {
+            fx_filter.f += f_step;
+            fx_filter.q += q_step;
+            float output = svf_process_f32(&fx_filter, io[n]);
+            io[n] = distortion_process_f32(&fx_distortion, output);
+        }
+        fx_filter.f = fx_filter_target.f;
+        fx_filter.q = fx_filter_target.q;
+    } else {
+        for (uint32_t n = 0; n < frames; n++) {
+            float output = svf_process_f32(&fx_filter, io[n]);
+            io[n] = distortion_process_f32(&fx_distortion, output);
+        }
+    }
+    
+    uint32_t start = audio_cycle_count();
+    reverb_process_block_f32(&fx_reverb, io, frames);
+    reverb_record_cycles(audio_cycle_count() - start);
+}
+#endif
+
+/**
+ * @brief Reverb cost in cycles: last block and worst block since reset
+ * 
+ * Budget the reverb against voices: one block at 48kHz and 168MHz is
+ * 448,000 cycles for AUDIO_BUFFER_SIZE = 128.
+ */
+void audio_get_reverb_cycles(uint32_t* last_block, uint32_t* peak_block) {
+    *last_block = render_stats.reverb_block_cycles;
+    *peak_block = render_stats.reverb_peak_cycles;
+}
+
+/**
+ * @brief Current DAC output position on the sample clock
+ * 
+ * Derived from the DMA read position, so it is exact at any moment and
+ * stays correct even if a half-transfer callback is still pending. The
+ * callbacks update playing_half and playing_half_start together, so they
+ * are read with interrupts masked; one landing between the two reads
+ * would put the result a whole half out.
+ */
+uint32_t audio_sample_clock(void) {
+#ifdef HOST_BUILD
+    return render_clock;
+#else
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    uint32_t half = playing_half;
+    uint32_t half_start = playing_half_start;
+    uint32_t remaining = __HAL_DMA_GET_COUNTER(hdac1.DMA_Handle1);
+    __set_PRIMASK(primask);
+    
+    uint32_t dma_pos = 2 * AUDIO_BUFFER_SIZE - remaining;
+    uint32_t into_half = (dma_pos - half * AUDIO_BUFFER_SIZE) &
+                         (2 * AUDIO_BUFFER_SIZE - 1);
+    return half_start + into_half;
+#endif
+}
+
+/**
+ * @brief Queue an event for a given sample time (producer side)
+ * 
+ * Events must be queued in timestamp order; the renderer applies them FIFO.
+ * @return false if the queue is full and the event was dropped
+ */
+bool midi_event_schedule(uint32_t timestamp, uint8_t status, uint8_t data1, uint8_t data2) {
+    uint32_t head = midi_queue.head;
+    
+    if (head - midi_queue.tail >= MIDI_QUEUE_SIZE) {
+        midi_queue.overflows++;
+        return false;
+    }
+    
+    midi_event_t* ev = &midi_queue.events[head & MIDI_QUEUE_MASK];
+    ev->timestamp = timestamp;
+    ev->status = status;
+    ev->data1 = data1;
+    ev->data2 = data2;
+    
+    // Slot contents must be visible before the consumer sees the new head
+    audio_memory_barrier();
+    midi_queue.head = head + 1;
+    return true;
+}
+
+/**
+ * @brief Queue an event stamped at its arrival time plus fixed latency
+ */
+bool midi_event_post(uint8_t status, uint8_t data1, uint8_t data2) {
+    return midi_event_schedule(audio_sample_clock() + MIDI_EVENT_LATENCY,
+                               status, data1, data2);
+}
+
+/**
+ * @brief Parse MIDI bytes into channel messages (running status supported)
+ */
+void midi_parse_byte(uint8_t byte) {
+    static uint8_t running_status = 0;
+    static uint8_t data[2];
+    static uint8_t data_count = 0;
+    
+    if (byte >= 0xF8) {
+        return;                  // Real-time messages do not affect parsing
+    }
+    if (byte >= 0x80) {
+        // System common and SysEx cancel running status; ignore them
+        running_status = (byte < 0xF0) ? byte : 0;
+        data_count = 0;
+        return;
+    }
+    if (running_status == 0) {
+        return;
+    }
+    
+    data[data_count++] = byte;
+    
+    // Program change and channel pressure carry one data byte, others two
+    uint8_t type = running_status & 0xF0;
+    uint8_t needed = (type == 0xC0 || type == 0xD0) ? 1 : 2;
+    if (data_count == needed) {
+        midi_event_post(running_status, data[0], (needed == 2) ? data[1] : 0);
+        data_count = 0;
+    }
+}
+
+/**
+ * @brief MIDI UART receive interrupt: parse the byte and re-arm
+ */
+void HAL_UART_RxCpltCallback(UART_HandleTypeDef* huart) {
+    if (huart->Instance == USART_MIDI) {
+        midi_parse_byte(midi_rx_byte);
+        HAL_UART_Receive_IT(&huart_midi, &midi_rx_byte, 1);
+    }
+}
+
+/**
+ * @brief Apply one MIDI event to the synthesizer (consumer side only)
+ */
+static void midi_apply_event(const midi_event_t* ev) {
+    switch (ev->status & 0xF0) {
+        case 0x90:
+            if (ev->data2 > 0) {
+                handle_midi_note_on(ev->data1, ev->data2);
+                break;
+            }
+            // Note on with velocity 0 is a note off
+            handle_midi_note_off(ev->data1);
+            break;
+        case 0x80:
+            handle_midi_note_off(ev->data1);
+            break;
+        default:
+            break;
+    }
+}
+
+/**
+ * @brief Render voices for a block, splitting it at queued event times
+ * 
+ * Every event is applied exactly at its sample position. Events that arrive
+ * late (timestamp already rendered) are applied at the start of the block.
+ * Voice state is only changed here, in the audio interrupt, so the renderer
+ * never sees a half-updated voice.
+ */
+void render_voices_with_events(int32_t* mix, uint32_t frames) {
+    uint32_t block_start = render_clock;
+    uint32_t done = 0;
+    
+    while (done < frames) {
+        uint32_t now = block_start + done;
+        uint32_t segment = frames - done;
+        
+        while (midi_queue.tail != midi_queue.head) {
+            uint32_t tail = midi_queue.tail;
+            audio_memory_barrier();
+            const midi_event_t* ev = &midi_queue.events[tail & MIDI_QUEUE_MASK];
+            int32_t offset = (int32_t)(ev->timestamp - now);
+            
+            if (offset > 0) {
+                // Render up to the next event, then apply it
+                if ((uint32_t)offset < segment) {
+                    segment = (uint32_t)offset;
+                }
+                break;
+            }
+            
+            midi_apply_event(ev);
+            audio_memory_barrier();
+            midi_queue.tail = tail + 1;
+        }
+        
+        render_voices(&mix[done], segment);
+        done += segment;
+    }
+    
+    render_clock = block_start + frames;
+}
+
+/**
+ * @brief Select how voices are stolen once all MAX_VOICES are sounding
+ */
+void set_voice_steal_policy(voice_steal_policy_t policy) {
+    voice_steal_policy = policy;
+}
+
+/**
+ * @brief MIDI note on handler with voice allocation
+ * 
+ * Called from the renderer via the MIDI event queue; do not call from
+ * other interrupt contexts. Every step is O(1): a repeated note reuses its
+ * voice through note_to_voice, otherwise a voice comes off the free stack
+ * or is stolen from the head of an age list.
+ */
+void handle_midi_note_on(uint8_t note, uint8_t velocity) {
+    int voice_index = voice_store.note_to_voice[note];
+    
+    if (voice_index == NO_VOICE) {
+        voice_index = voice_allocate();
+    } else {
+        // Retrigger: becomes the newest held voice
+        age_list_remove(voice_index);
+    }
+    age_list_append(AGE_HELD, voice_index);
+    voice_store.note_to_voice[note] = (uint8_t)voice_index;
+    
+    // Configure voice
+    voice_store.midi_note[voice_index] = note;
+    voice_store.velocity[voice_index] = velocity;
+    voice_store.frequency[voice_index] = midi_note_to_frequency(note);
+    voice_store.amplitude[voice_index] = (int16_t)((velocity * Q15_ONE) / 127);
+    voice_store.start_order[voice_index] = ++note_on_counter;
+    oscillator_note_on(voice_index);
+    
+    if (!voice_store.active[voice_index]) {
+        voice_store.gain_acc[voice_index] = 0;
+        voice_activate(voice_index);
+    }
+    voice_store.ramp_left[voice_index] = 0;  // Control point on the next sample
+    
+    // Trigger envelope (restarts from the current level if stolen)
+    voice_store.envelope[voice_index].stage = ENV_ATTACK;
+}
+
+/**
+ * @brief MIDI note off handler: release the voice holding the note, O(1)
+ */
+void handle_midi_note_off(uint8_t note) {
+    int v = voice_store.note_to_voice[note];
+    
+    if (v == NO_VOICE) {
+        return;
+    }
+    
+    voice_store.note_to_voice[note] = NO_VOICE;
+    voice_store.envelope[v].stage = ENV_RELEASE;
+    age_list_remove(v);
+    age_list_append(AGE_RELEASED, v);
+}
+
+/**
+ * @brief Reference oscillator using sinf and a per-sample divide
+ * 
+ * Original naive implementation, kept for benchmarking the wavetable path.
+ * Square, triangle and sawtooth are not band-limited and alias at high notes.
+ */
+float generate_oscillator_sample_libm(float* phase, float frequency, waveform_t waveform) {
+    float sample = 0.0f;
+    
+    switch (waveform) {
+        case WAVEFORM_SINE:
+            sample = sinf(*phase * 2.0f * M_PI);
+            break;
+        case WAVEFORM_SQUARE:
+            sample = (*phase < 0.5f) ? 1.0f : -1.0f;
+            break;
+        case WAVEFORM_TRIANGLE:
+            sample = (*phase < 0.5f) ? 
+                     (4.0f * *phase - 1.0f) : 
+                     (3.0f - 4.0f * *phase);
+            break;
+        case WAVEFORM_SAWTOOTH:
+            sample = 2.0f * *phase - 1.0f;
+            break;
+    }
+    
+    // Update phase
+    *phase += frequency / SAMPLE_RATE;
+    if (*phase >= 1.0f) {
+        *phase -= 1.0f;
+    }
+    
+    return sample;
+}
+
+#ifdef HOST_BUILD
+/**
+ * @brief Host benchmark: wavetable oscillator vs sinf reference path
+ * 
+ * All voices play sine, the worst case for the reference path. Timing uses
+ * the TSC, so compare the two paths by ratio rather than absolute cycles.
+ */
+void benchmark_oscillator_paths(void) {
+    #define BENCH_VOICES 16
+    #define BENCH_SAMPLES SAMPLE_RATE
+    float frequency[BENCH_VOICES];
+    float phase[BENCH_VOICES];
+    uint32_t phase_acc[BENCH_VOICES];
+    uint32_t phase_inc[BENCH_VOICES];
+    volatile float sink = 0.0f;
+    
+    for (int v = 0; v < BENCH_VOICES; v++) {
+        frequency[v] = 110.0f * (1.0f + 0.37f * v);
+        phase[v] = 0.0f;
+        phase_acc[v] = 0;
+        phase_inc[v] = (uint32_t)(frequency[v] * (4294967296.0f / SAMPLE_RATE));
+    }
+    
+    uint32_t start = audio_cycle_count();
+    for (int n = 0; n < BENCH_SAMPLES; n++) {
+        float mix = 0.0f;
+        for (int v = 0; v < BENCH_VOICES; v++) {
+            mix += generate_oscillator_sample_libm(&phase[v], frequency[v], WAVEFORM_SINE);
+        }
+        sink += mix;
+    }
+    uint32_t libm_cycles = audio_cycle_count() - start;
+    
+    start = audio_cycle_count();
+    for (int n = 0; n < BENCH_SAMPLES; n++) {
+        float mix = 0.0f;
+        for (int v = 0; v < BENCH_VOICES; v++) {
+            mix += (float)wavetable_read(wavetable_sine, phase_acc[v]) * (1.0f / 32768.0f);
+            phase_acc[v] += phase_inc[v];
+        }
+        sink += mix;
+    }
+    uint32_t table_cycles = audio_cycle_count() - start;
+    
+    float libm_per_sample = (float)libm_cycles / (BENCH_SAMPLES * BENCH_VOICES);
+    float table_per_sample = (float)table_cycles / (BENCH_SAMPLES * BENCH_VOICES);
+    
+    printf("Oscillator benchmark (%d voices x %d samples)\n", BENCH_VOICES, BENCH_SAMPLES);
+    printf("  sinf reference: %.1f cycles/voice-sample\n", libm_per_sample);
+    printf("  wavetable:      %.1f cycles/voice-sample\n", table_per_sample);
+    printf("  speedup:        %.1fx (voices in the same budget)\n",
+           libm_per_sample / table_per_sample);
+    (void)sink;
+}
+
+/**
+ * @brief Host benchmark: render cost against number of active voices
+ * 
+ * Cost per sample should grow with active voices in steps of VOICE_BATCH,
+ * independent of MAX_VOICES. The per-voice figure includes the envelope
+ * ramp, gain and mix; the wavetable figure of benchmark_oscillator_paths
+ * is one voice's oscillator alone, without batching.
+ */
+void benchmark_voice_scaling(void) {
+    #define SCALING_BLOCKS 375   // One second at 128 samples per block
+    
+    printf("Voice scaling benchmark (%d-voice batches)\n", VOICE_BATCH);
+    for (int voices = VOICE_BATCH; voices <= MAX_VOICES; voices *= 2) {
+        init_audio_synthesizer();
+        for (int v = 0; v < voices; v++) {
+            handle_midi_note_on((uint8_t)(36 + v), 100);
+        }
+        
+        uint32_t start = audio_cycle_count();
+        for (int b = 0; b < SCALING_BLOCKS; b++) {
+            render_voices(voice_mix, AUDIO_BUFFER_SIZE);
+        }
+        uint32_t cycles = audio_cycle_count() - start;
+        float per_sample = (float)cycles / (SCALING_BLOCKS * AUDIO_BUFFER_SIZE);
+        
+        printf("  %2d voices: %.1f cycles/sample (%.1f per voice)\n", voices,
+               per_sample, per_sample / voices);
+    }
+}
+// Standard MIDI File contents flattened to one time-ordered event list
+typedef struct {
+    midi_event_t* events;        // timestamp = samples from the start
+    uint32_t count;
+} midi_sequence_t;
+
+typedef struct {
+    uint32_t tick;
+    uint32_t order;              // File order, keeps the sort stable
+    uint32_t tempo;              // us per quarter note, tempo events only
+    uint8_t status;              // 0xFF marks a tempo event
+    uint8_t data1;
+    uint8_t data2;
+} smf_raw_event_t;
+
+static uint32_t smf_read_be(const uint8_t* p, int bytes) {
+    uint32_t value = 0;
+    while (bytes--) value = (value << 8) | *p++;
+    return value;
+}
+
+static uint32_t smf_read_vlq(const uint8_t** p, const uint8_t* end) {
+    uint32_t value = 0;
+    for (int i = 0; i < 4 && *p < end; i++) {
+        uint8_t byte = *(*p)++;
+        value = (value << 7) | (byte & 0x7F);
+        if (!(byte & 0x80)) break;
+    }
+    return value;
+}
+
+static int smf_compare(const void* a, const void* b) {
+    const smf_raw_event_t* x = a;
+    const smf_raw_event_t* y = b;
+    if (x->tick != y->tick) return (x->tick < y->tick) ? -1 : 1;
+    return (x->order < y->order) ? -1 : (x->order > y->order);
+}
+
+/**
+ * @brief Load a format 0/1 Standard MIDI File into sample-stamped events
+ * 
+ * Keeps channel messages, applies the tempo map and drops meta and SysEx
+ * events. SMPTE time division is not supported.
+ * @return 0 on success, -1 on error (seq->events must be freed by the caller)
+ */
+int midi_file_load(const char* path, midi_sequence_t* seq) {
+    FILE* f = fopen(path, "rb");
+    if (!f) return -1;
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    uint8_t* data = malloc((size_t)size);
+    if (!data || fread(data, 1, (size_t)size, f) != (size_t)size) {
+        fclose(f);
+        free(data);
+        return -1;
+    }
+    fclose(f);
+    
+    const uint8_t* end = data + size;
+    if (size < 14 || memcmp(data, "MThd", 4) != 0 || (data[12] & 0x80)) {
+        free(data);
+        return -1;
+    }
+    uint32_t tracks = smf_read_be(data + 10, 2);
+    uint32_t division = smf_read_be(data + 12, 2);
+    const uint8_t* p = data + 8 + smf_read_be(data + 4, 4);
+    
+    // Every event is at least two bytes, so size/2 bounds the event count
+    smf_raw_event_t* raw = malloc(sizeof(smf_raw_event_t) * ((size_t)size / 2 + 1));
+    if (!raw) {
+        free(data);
+        return -1;
+    }
+    uint32_t count = 0;
+    
+    for (uint32_t t = 0; t < tracks && p + 8 <= end; t++) {
+        uint32_t length = smf_read_be(p + 4, 4);
+        const uint8_t* q = p + 8;
+        const uint8_t* track_end = (q + length <= end) ? q + length : end;
+        bool is_track = memcmp(p, "MTrk", 4) == 0;
+        uint32_t tick = 0;
+        uint8_t running = 0;
+        
+        p = track_end;
+        if (!is_track) continue;
+        
+        while (q < track_end) {
+            tick += smf_read_vlq(&q, track_end);
+            if (q >= track_end) break;
+            uint8_t status = *q;
+            
+            if (status == 0xFF) {
+                // Meta event: type, length, data. Only tempo matters here.
+                if (q + 2 >= track_end) break;
+                uint8_t type = q[1];
+                q += 2;
+                uint32_t len = smf_read_vlq(&q, track_end);
+                if (type == 0x51 && len == 3 && q + 3 <= track_end) {
+                    raw[count] = (smf_raw_event_t){ tick, count, smf_read_be(q, 3), 0xFF, 0, 0 };
+                    count++;
+                }
+                q += len;
+                continue;
+            }
+            if (status == 0xF0 || status == 0xF7) {
+                q++;
+                q += smf_read_vlq(&q, track_end);
+                continue;
+            }
+            
+            if (status & 0x80) {
+                running = status;
+                q++;
+            }
+            if (!running) break;
+            int bytes = ((running & 0xE0) == 0xC0) ? 1 : 2;
+            if (q + bytes > track_end) break;
+            raw[count] = (smf_raw_event_t){ tick, count, 0, running, q[0],
+                                            (uint8_t)((bytes == 2) ? q[1] : 0) };
+            count++;
+            q += bytes;
+        }
+    }
+    free(data);
+    
+    // Merge tracks, then convert ticks to samples through the tempo map
+    qsort(raw, count, sizeof(smf_raw_event_t), smf_compare);
+    seq->events = malloc(sizeof(midi_event_t) * (count + 1));
+    if (!seq->events) {
+        free(raw);
+        return -1;
+    }
+    seq->count = 0;
+    double samples_per_tick = 500000.0 * SAMPLE_RATE / (1e6 * division);
+    double base_samples = 0.0;
+    uint32_t base_tick = 0;
+    
+    for (uint32_t i = 0; i < count; i++) {
+        double at = base_samples + (raw[i].tick - base_tick) * samples_per_tick;
+        if (raw[i].status == 0xFF) {
+            base_samples = at;
+            base_tick = raw[i].tick;
+            samples_per_tick = (double)raw[i].tempo * SAMPLE_RATE / (1e6 * division);
+            continue;
+        }
+        seq->events[seq->count++] = (midi_event_t){
+            (uint32_t)at, raw[i].status, raw[i].data1, raw[i].data2
+        };
+    }
+    free(raw);
+    return 0;
+}
+
+/**
+ * @brief Deterministic dense test pattern: 8-note chords every 10ms
+ * 
+ * Notes overlap for 20-120ms, so far more notes sound than MAX_VOICES and
+ * every steal path is exercised.
+ * @return 0 on success, -1 if the events cannot be allocated
+ */
+static int midi_generate_dense(midi_sequence_t* seq, uint32_t seconds) {
+    #define DENSE_CHORD 8
+    #define DENSE_STEP (SAMPLE_RATE / 100)
+    uint32_t chords = seconds * (SAMPLE_RATE / DENSE_STEP);
+    uint32_t seed = 2024;
+    
+    seq->events = malloc(sizeof(midi_event_t) * chords * DENSE_CHORD * 2);
+    if (!seq->events) return -1;
+    seq->count = 0;
+    for (uint32_t c = 0; c < chords; c++) {
+        for (int k = 0; k < DENSE_CHORD; k++) {
+            seed = seed * 1664525u + 1013904223u;
+            uint8_t note = (uint8_t)(24 + (seed >> 8) % 84);
+            uint32_t length = SAMPLE_RATE / 50 + (seed >> 16) % (SAMPLE_RATE / 10);
+            seq->events[seq->count++] = (midi_event_t){
+                c * DENSE_STEP, 0x90, note, (uint8_t)(40 + (seed >> 24) % 88) };
+            seq->events[seq->count++] = (midi_event_t){
+                c * DENSE_STEP + length, 0x80, note, 0 };
+        }
+    }
+    
+    // Insertion sort keeps same-time events in generation order
+    for (uint32_t i = 1; i < seq->count; i++) {
+        midi_event_t ev = seq->events[i];
+        uint32_t j = i;
+        while (j > 0 && seq->events[j - 1].timestamp > ev.timestamp) {
+            seq->events[j] = seq->events[j - 1];
+            j--;
+        }
+        seq->events[j] = ev;
+    }
+    return 0;
+}
+
+/**
+ * @brief Host stress test: replay a dense MIDI stream under each steal policy
+ * 
+ * Renders the voices between events so envelopes run and voices retire as
+ * they would on the target, and times every note-on. Allocation is O(1), so
+ * the worst case should stay flat however many voices are sounding.
+ * @param midi_path Standard MIDI File to replay, or NULL for a generated pattern
+ */
+void stress_test_voice_allocator(const char* midi_path) {
+    static const char* policy_names[] = { "oldest", "quietest", "released-first" };
+    midi_sequence_t seq;
+    
+    if (!midi_path || midi_file_load(midi_path, &seq) != 0) {
+        if (midi_path) printf("Cannot load %s, using generated pattern\n", midi_path);
+        if (midi_generate_dense(&seq, 10) != 0) {
+            printf("Voice allocator stress test: out of memory\n");
+            return;
+        }
+    }
+    
+    printf("Voice allocator stress test (%lu events)\n", (unsigned long)seq.count);
+    for (int policy = VOICE_STEAL_OLDEST; policy <= VOICE_STEAL_RELEASED_FIRST; policy++) {
+        uint64_t total_cycles = 0;
+        uint32_t worst_cycles = 0;
+        uint32_t note_ons = 0;
+        uint32_t now = 0;
+        
+        init_audio_synthesizer();
+        set_voice_steal_policy((voice_steal_policy_t)policy);
+        
+        for (uint32_t i = 0; i < seq.count; i++) {
+            const midi_event_t* ev = &seq.events[i];
+            
+            while (now < ev->timestamp) {
+                uint32_t frames = ev->timestamp - now;
+                if (frames > AUDIO_BUFFER_SIZE) frames = AUDIO_BUFFER_SIZE;
+                render_voices(voice_mix, frames);
+                now += frames;
+            }
+            
+            if ((ev->status & 0xF0) == 0x90 && ev->data2 > 0) {
+                uint32_t start = audio_cycle_count();
+                handle_midi_note_on(ev->data1, ev->data2);
+                uint32_t cycles = audio_cycle_count() - start;
+                total_cycles += cycles;
+                if (cycles > worst_cycles) worst_cycles = cycles;
+                note_ons++;
+            } else {
+                midi_apply_event(ev);
+            }
+        }
+        
+        printf("  %-15s %6lu note-ons, %6lu steals, avg %.0f / worst %lu cycles\n",
+               policy_names[policy], (unsigned long)note_ons,
+               (unsigned long)voice_store.steal_count,
+               note_ons ? (double)total_cycles / note_ons : 0.0,
+               (unsigned long)worst_cycles);
+    }
+    free(seq.events);
+}
+
+/**
+ * @brief Host golden-vector check: fixed-point stages against the float path
+ * 
+ * Drives each stage pair with the same deterministic input and compares the
+ * Q15 output with the float output scaled to Q15. Tolerances cover rounding
+ * differences; a larger error means the fixed-point stage is wrong.
+ * @return Number of stages outside tolerance
+ */
+int check_fixed_point_against_float(void) {
+    #define GOLDEN_SAMPLES 24000
+    static reverb_f32_t reverb_f;
+    static reverb_q15_t reverb_q;
+    float block_f[AUDIO_BUFFER_SIZE];
+    int32_t block_q[AUDIO_BUFFER_SIZE];
+    svf_f32_t svf_f = {0};
+    svf_q15_t svf_q = {0};
+    distortion_f32_t dist_f;
+    distortion_q15_t dist_q;
+    envelope_f32_t env_f = { ENV_ATTACK, 0.0f };
+    envelope_q31_t env_q = { ENV_ATTACK, 0 };
+    int32_t max_err[5] = {0};
+    static const char* stage_names[5] = {
+        "envelope", "filter", "distortion", "reverb", "dac"
+    };
+    static const int32_t tolerance[5] = {
+        4,                       // Envelope: same ticks, so only Q31 step rounding
+        8, 4,
+        32,                      // Reverb: 16-bit lines recirculate rounding (-60dBFS)
+        1                        // DAC codes
+    };
+    uint32_t noise = 12345;
+    int failures = 0;
+    
+    envelope_configure(0.005f, 0.1f, 0.7f, 0.2f);
+    svf_set_f32(&svf_f, 1000.0f, 0.5f);
+    svf_set_q15(&svf_q, 1000.0f, 0.5f);
+    distortion_set_f32(&dist_f, 3.0f);
+    distortion_set_q15(&dist_q, 3.0f);
+    memset(&reverb_f, 0, sizeof(reverb_f));
+    memset(&reverb_q, 0, sizeof(reverb_q));
+    reverb_set_f32(&reverb_f, 0.5f, 0.3f);
+    reverb_set_q15(&reverb_q, 0.5f, 0.3f);
+    
+    for (int n = 0; n < GOLDEN_SAMPLES; n++) {
+        // Input: sine sweep plus a little noise, quantized to Q15 for both
+        // paths. Level leaves headroom so the reverb delay line never saturates.
+        noise = noise * 1664525u + 1013904223u;
+        float t = (float)n / SAMPLE_RATE;
+        float x = 0.4f * sinf(2.0f * (float)M_PI * (100.0f + 4000.0f * t) * t) +
+                  0.05f * ((int32_t)noise >> 16) / 32768.0f;
+        int32_t xq = (int32_t)(x * 32768.0f);
+        x = xq / 32768.0f;
+        int32_t err[5];
+        
+        // Release half way through
+        if (n == GOLDEN_SAMPLES / 2) {
+            env_f.stage = ENV_RELEASE;
+            env_q.stage = ENV_RELEASE;
+        }
+        // Envelopes advance once per control tick, as in the voice loop
+        err[0] = 0;
+        if (n % CONTROL_BLOCK == 0) {
+            float ef = envelope_process_f32(&env_f);
+            int32_t eq = envelope_process_q31(&env_q) >> 16;
+            err[0] = eq - (int32_t)(ef * 32767.0f);
+        }
+        
+        err[1] = svf_process_q15(&svf_q, xq) - (int32_t)(svf_process_f32(&svf_f, x) * 32768.0f);
+        err[2] = distortion_process_q15(&dist_q, xq) -
+                 (int32_t)(distortion_process_f32(&dist_f, x) * 32768.0f);
+        err[4] = q15_to_dac(xq) - sample_to_dac(x);
+        
+        // Reverb runs on whole blocks
+        uint32_t k = n % AUDIO_BUFFER_SIZE;
+        block_f[k] = x;
+        block_q[k] = xq;
+        err[3] = 0;
+        if (k == AUDIO_BUFFER_SIZE - 1) {
+            reverb_process_block_f32(&reverb_f, block_f, AUDIO_BUFFER_SIZE);
+            reverb_process_block_q15(&reverb_q, block_q, AUDIO_BUFFER_SIZE);
+            for (uint32_t i = 0; i < AUDIO_BUFFER_SIZE; i++) {
+                int32_t e = block_q[i] - (int32_t)(block_f[i] * 32768.0f);
+                if (e < 0) e = -e;
+                if (e > err[3]) err[3] = e;
+            }
+        }
+        
+        for (int i = 0; i < 5; i++) {
+            int32_t e = (err[i] < 0) ? -err[i] : err[i];
+            if (e > max_err[i]) max_err[i] = e;
+        }
+    }
+    
+    printf("Fixed-point vs float golden vectors (%d samples)\n", GOLDEN_SAMPLES);
+    for (int i = 0; i < 5; i++) {
+        bool pass = max_err[i] <= tolerance[i];
+        printf("  %-10s max error %5ld LSB (limit %ld) %s\n", stage_names[i],
+               (long)max_err[i], (long)tolerance[i], pass ? "PASS" : "FAIL");
+        if (!pass) failures++;
+    }
+    return failures;
+}
+
+/**
+ * @brief Host check: Q15 reverb output stays correct with saturated combs
+ * 
+ * A slow full-scale square wave at the longest reverb time drives the comb
+ * lines to the rail, so the wet sum is several times full scale. Two reverbs see
+ * the same input: one at 10% mix never overflows and serves as the
+ * reference, one at 100% mix must saturate to the reference's sign rather
+ * than wrap. Only the silent tail is compared, where both are pure wet.
+ * @return 1 if the check fails, 0 otherwise
+ */
+int check_reverb_saturation_q15(void) {
+    #define SATURATION_DRIVE_SAMPLES (4 * SAMPLE_RATE)
+    #define SATURATION_TAIL_SAMPLES SAMPLE_RATE
+    static reverb_q15_t reverb_ref, reverb_full;
+    int32_t block_ref[AUDIO_BUFFER_SIZE];
+    int32_t block_full[AUDIO_BUFFER_SIZE];
+    int32_t max_err = 0;
+    uint32_t railed = 0, beyond_int32 = 0;
+    bool comb_at_rail = false;
+    
+    memset(&reverb_ref, 0, sizeof(reverb_ref));
+    memset(&reverb_full, 0, sizeof(reverb_full));
+    reverb_set_q15(&reverb_ref, 1.0f, 0.1f);
+    reverb_set_q15(&reverb_full, 1.0f, 1.0f);
+    
+    for (uint32_t n = 0; n < SATURATION_DRIVE_SAMPLES + SATURATION_TAIL_SAMPLES;
+         n += AUDIO_BUFFER_SIZE) {
+        for (uint32_t k = 0; k < AUDIO_BUFFER_SIZE; k++) {
+            // 0.25Hz square wave (one cycle), then silence. Each half is
+            // long enough for the combs' 1.5x DC gain to reach the rail.
+            int32_t x = ((n + k) / (2 * SAMPLE_RATE)) & 1 ? -Q15_ONE : Q15_ONE;
+            if (n >= SATURATION_DRIVE_SAMPLES) x = 0;
+            block_ref[k] = x;
+            block_full[k] = x;
+        }
+        reverb_process_block_q15(&reverb_ref, block_ref, AUDIO_BUFFER_SIZE);
+        reverb_process_block_q15(&reverb_full, block_full, AUDIO_BUFFER_SIZE);
+        
+        if (n < SATURATION_DRIVE_SAMPLES) {
+            for (int c = 0; c < REVERB_COMBS; c++) {
+                for (uint32_t k = 0; k < AUDIO_BUFFER_SIZE; k++) {
+                    int32_t v = reverb_full.comb[c][(reverb_full.pos - 1 - k) & REVERB_COMB_MASK];
+                    if (v >= Q15_ONE || v < -Q15_ONE) comb_at_rail = true;
+                }
+            }
+            continue;
+        }
+        for (uint32_t k = 0; k < AUDIO_BUFFER_SIZE; k++) {
+            // Scale the reference back to 100% mix; its truncation leaves
+            // up to mix_full / mix_ref LSB of uncertainty
+            int64_t scaled = (int64_t)block_ref[k] * reverb_full.mix / reverb_ref.mix;
+            int32_t expected = sat_q15((int32_t)scaled);
+            int32_t e = block_full[k] - expected;
+            if (e < 0) e = -e;
+            if (e > max_err) max_err = e;
+            if (expected >= Q15_ONE || expected < -Q15_ONE) railed++;
+            // Wet past 2x full scale overflows an int32 product at 100% mix
+            if (scaled > 65537 || scaled < -65537) beyond_int32++;
+        }
+    }
+    
+    bool pass = max_err <= 11 && beyond_int32 > 0 && comb_at_rail;
+    printf("Q15 reverb saturation (full-scale drive, %d sample tail)\n",
+           SATURATION_TAIL_SAMPLES);
+    printf("  %lu samples railed, %lu beyond int32 mix range, comb at rail: %s\n",
+           (unsigned long)railed, (unsigned long)beyond_int32,
+           comb_at_rail ? "yes" : "no");
+    printf("  max error %ld LSB (limit 11) %s\n", (long)max_err, pass ? "PASS" : "FAIL");
+    return pass ? 0 : 1;
+}
+#endif
@@ -0,0 +1,785 @@
+/*
+ * Code Example 47 - Host Render Harness
+ * Language: C
+ * Chapter: Chapter_11_Capstone_Projects_Advanced_System_Integration
+ *
+ * Runs the synthesizer from code_example_47.c on a PC: the same voice,
+ * envelope and effects code renders a MIDI file or event script into a WAV
+ * file, so audio engine changes can be heard, timed and regression-checked
+ * without a board. The STM32 HAL is replaced by the small stand-ins below.
+ *
+ * Usage:
+ * 1. gcc -O2 -o synth_render code_example_47_host_render.c -lm
+ *    (add -DAUDIO_FIXED_POINT=1 for the Q15 pipeline)
+ * 2. ./synth_render [options] <song.mid | events.txt>
+ *      -o out.wav      Write the rendered audio (default synth_render.wav)
+ *      -g golden.wav   Compare against a reference render, exit 1 on mismatch
+ *      -t lsb          Allowed per-sample difference for -g (default 0)
+ *      -s seconds      Extra render time after the last event (default 1)
+ *      -l              Let the load governor shed voices; the load is host
+ *                      time, so the output then depends on scheduling
+ * 3. ./synth_render --selftest runs the benchmarks and checks built into
+ *    code_example_47.c, checks the xrun counters and load governor, and
+ *    round-trips a built-in golden render through the -g comparison
+ *
+ * Event script: one event per line, '#' starts a comment. Times in seconds.
+ *    0.00 on 60 100        note on (note, velocity)
+ *    0.50 off 60           note off
+ *    1.00 cutoff 2000      effect parameter: cutoff, resonance, drive,
+ *                          reverb_time or reverb_mix
+ *
+ * Timing uses the TSC (or nanoseconds on non-x86 hosts) for cycles and the
+ * process CPU clock for time, so compare runs on the same machine. Denormals
+ * are flushed to zero on SSE hosts so reverb tails don't time as FPU assists.
+ */
+
+#define HOST_BUILD
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#if defined(__SSE2__)
+#include <xmmintrin.h>
+#include <pmmintrin.h>
+#endif
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// Host stand-ins for the STM32 HAL and the book's helper functions
+typedef enum { HAL_OK, HAL_ERROR } HAL_StatusTypeDef;
+typedef struct { uint32_t NDTR; } DMA_Stream_TypeDef;
+typedef struct { DMA_Stream_TypeDef* Instance; } DMA_HandleTypeDef;
+typedef struct { void* Instance; } TIM_HandleTypeDef;
+typedef struct { void* Instance; DMA_HandleTypeDef* DMA_Handle1; } DAC_HandleTypeDef;
+typedef struct { void* Instance; } UART_HandleTypeDef;
+typedef struct { uint32_t DEMCR; } CoreDebug_Type;
+typedef struct { uint32_t CTRL; uint32_t CYCCNT; } DWT_Type;
+
+typedef enum {
+    WAVEFORM_SINE,
+    WAVEFORM_SQUARE,
+    WAVEFORM_TRIANGLE,
+    WAVEFORM_SAWTOOTH
+} waveform_t;
+
+#define TIM_AUDIO ((void*)1)
+#define USART_MIDI ((void*)2)
+#define DAC_CHANNEL_1 0
+#define DAC_ALIGN_12B_R 0
+#define CoreDebug_DEMCR_TRCENA_Msk 1
+#define DWT_CTRL_CYCCNTENA_Msk 1
+#define __HAL_DMA_GET_COUNTER(h) sim_dma_counter(h)
+
+// DAC DMA: reads return the scripted counter values first, so a check can
+// move the DMA between the two position reads around a refill
+static uint32_t dma_script[2];
+static uint32_t dma_script_length, dma_script_reads;
+
+static uint32_t sim_dma_counter(DMA_HandleTypeDef* hdma) {
+    if (dma_script_reads < dma_script_length) {
+        return dma_script[dma_script_reads++];
+    }
+    return hdma->Instance->NDTR;
+}
+
+static TIM_HandleTypeDef htim_audio;
+static DMA_Stream_TypeDef dac_dma_stream;
+static DMA_HandleTypeDef hdma_dac = { &dac_dma_stream };
+static DAC_HandleTypeDef hdac1 = { NULL, &hdma_dac };
+static UART_HandleTypeDef huart_midi;
+static CoreDebug_Type core_debug;
+static DWT_Type dwt;
+static CoreDebug_Type* CoreDebug = &core_debug;
+static DWT_Type* DWT = &dwt;
+static uint32_t SystemCoreClock = 168000000;   // Set to the host tick rate in main()
+
+HAL_StatusTypeDef HAL_TIM_Base_Start(TIM_HandleTypeDef* htim) {
+    (void)htim;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_TIM_Base_Start_IT(TIM_HandleTypeDef* htim) {
+    (void)htim;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_DAC_Start_DMA(DAC_HandleTypeDef* hdac, uint32_t channel,
+                                    uint32_t* data, uint32_t length, uint32_t align) {
+    (void)hdac; (void)channel; (void)data; (void)length; (void)align;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_UART_Receive_IT(UART_HandleTypeDef* huart, uint8_t* data,
+                                      uint16_t size) {
+    (void)huart; (void)data; (void)size;
+    return HAL_OK;
+}
+
+static void configure_audio_timer(uint32_t sample_rate) {
+    (void)sample_rate;
+}
+
+static float midi_note_to_frequency(uint8_t note) {
+    return 440.0f * powf(2.0f, (note - 69) / 12.0f);
+}
+
+#include "code_example_47.c"
+
+// One entry of the merged event list: a MIDI message or an effect change
+typedef struct {
+    midi_event_t midi;
+    int param;                   // -1 for MIDI, else index into param_names
+    float value;
+} render_event_t;
+
+static const char* param_names[] = {
+    "cutoff", "resonance", "drive", "reverb_time", "reverb_mix"
+};
+
+/**
+ * @brief Point an effect parameter index at its field in effects
+ */
+static float* effect_param(int param) {
+    switch (param) {
+        case 0: return &effects.filter_cutoff;
+        case 1: return &effects.filter_resonance;
+        case 2: return &effects.distortion_drive;
+        case 3: return &effects.reverb_time;
+        default: return &effects.reverb_mix;
+    }
+}
+
+/**
+ * @brief Load an event script (see file header), sorted by time
+ * @return Number of events, or -1 if the file cannot be read or held in memory
+ */
+static int load_event_script(const char* path, render_event_t** out) {
+    FILE* f = fopen(path, "r");
+    if (!f) return -1;
+
+    int capacity = 256;
+    int count = 0;
+    render_event_t* events = malloc(sizeof(render_event_t) * capacity);
+    if (!events) {
+        fclose(f);
+        return -1;
+    }
+    char line[256];
+    int line_no = 0;
+
+    while (fgets(line, sizeof(line), f)) {
+        char* comment = strchr(line, '#');
+        char name[32];
+        double t;
+        float a = 0.0f, b = 0.0f;
+        line_no++;
+
+        if (comment) *comment = '\0';
+        int fields = sscanf(line, "%lf %31s %f %f", &t, name, &a, &b);
+        if (fields <= 0) continue;
+        if (fields < 3 || t < 0.0) {
+            fprintf(stderr, "%s:%d: malformed event\n", path, line_no);
+            continue;
+        }
+
+        render_event_t ev = { { (uint32_t)(t * SAMPLE_RATE + 0.5), 0, 0, 0 }, -1, a };
+        if (strcmp(name, "on") == 0 && fields == 4) {
+            ev.midi.status = 0x90;
+            ev.midi.data1 = (uint8_t)a;
+            ev.midi.data2 = (uint8_t)b;
+        } else if (strcmp(name, "off") == 0) {
+            ev.midi.status = 0x80;
+            ev.midi.data1 = (uint8_t)a;
+        } else {
+            for (int p = 0; p < (int)(sizeof(param_names) / sizeof(param_names[0])); p++) {
+                if (strcmp(name, param_names[p]) == 0) ev.param = p;
+            }
+            if (ev.param < 0) {
+                fprintf(stderr, "%s:%d: unknown event '%s'\n", path, line_no, name);
+                continue;
+            }
+        }
+
+        if (count == capacity) {
+            render_event_t* grown = realloc(events, sizeof(render_event_t) * capacity * 2);
+            if (!grown) {
+                fprintf(stderr, "%s:%d: out of memory\n", path, line_no);
+                free(events);
+                fclose(f);
+                return -1;
+            }
+            events = grown;
+            capacity *= 2;
+        }
+        events[count++] = ev;
+    }
+    fclose(f);
+
+    // Insertion sort keeps same-time events in file order
+    for (int i = 1; i < count; i++) {
+        render_event_t ev = events[i];
+        int j = i;
+        while (j > 0 && events[j - 1].midi.timestamp > ev.midi.timestamp) {
+            events[j] = events[j - 1];
+            j--;
+        }
+        events[j] = ev;
+    }
+
+    *out = events;
+    return count;
+}
+
+/**
+ * @brief Load a .mid file or an event script into render events
+ */
+static int load_events(const char* path, render_event_t** out) {
+    size_t len = strlen(path);
+    if (len < 4 || strcmp(path + len - 4, ".mid") != 0) {
+        return load_event_script(path, out);
+    }
+
+    midi_sequence_t seq;
+    if (midi_file_load(path, &seq) != 0) return -1;
+    *out = malloc(sizeof(render_event_t) * (seq.count + 1));
+    if (!*out) {
+        free(seq.events);
+        return -1;
+    }
+    for (uint32_t i = 0; i < seq.count; i++) {
+        (*out)[i] = (render_event_t){ seq.events[i], -1, 0.0f };
+    }
+    free(seq.events);
+    return (int)seq.count;
+}
+
+static void write_le(FILE* f, uint32_t value, int bytes) {
+    for (int i = 0; i < bytes; i++) {
+        fputc((value >> (8 * i)) & 0xFF, f);
+    }
+}
+
+/**
+ * @brief Write 16-bit mono PCM at SAMPLE_RATE
+ */
+static int wav_write(const char* path, const int16_t* samples, uint32_t count) {
+    FILE* f = fopen(path, "wb");
+    if (!f) return -1;
+
+    fwrite("RIFF", 1, 4, f);
+    write_le(f, 36 + count * 2, 4);
+    fwrite("WAVEfmt ", 1, 8, f);
+    write_le(f, 16, 4);
+    write_le(f, 1, 2);                   // PCM
+    write_le(f, 1, 2);                   // Mono
+    write_le(f, SAMPLE_RATE, 4);
+    write_le(f, SAMPLE_RATE * 2, 4);
+    write_le(f, 2, 2);
+    write_le(f, 16, 2);
+    fwrite("data", 1, 4, f);
+    write_le(f, count * 2, 4);
+    for (uint32_t i = 0; i < count; i++) {
+        write_le(f, (uint16_t)samples[i], 2);
+    }
+    fclose(f);
+    return 0;
+}
+
+/**
+ * @brief Read a 16-bit mono WAV written by wav_write (or any tool)
+ * @return Sample count, or -1 if the file is missing, not 16-bit mono PCM or
+ *         too large to hold in memory
+ */
+static long wav_read(const char* path, int16_t** samples) {
+    FILE* f = fopen(path, "rb");
+    uint8_t header[12], chunk[8], fmt[16];
+    bool have_fmt = false;
+
+    if (!f) return -1;
+    if (fread(header, 1, 12, f) != 12 || memcmp(header, "RIFF", 4) != 0 ||
+        memcmp(header + 8, "WAVE", 4) != 0) {
+        fclose(f);
+        return -1;
+    }
+
+    while (fread(chunk, 1, 8, f) == 8) {
+        uint32_t size = chunk[4] | (chunk[5] << 8) | (chunk[6] << 16) | ((uint32_t)chunk[7] << 24);
+
+        if (memcmp(chunk, "fmt ", 4) == 0 && size >= 16) {
+            if (fread(fmt, 1, 16, f) != 16) break;
+            fseek(f, (long)(size - 16 + (size & 1)), SEEK_CUR);
+            // PCM, one channel, 16 bits per sample
+            have_fmt = fmt[0] == 1 && fmt[2] == 1 && fmt[14] == 16;
+        } else if (memcmp(chunk, "data", 4) == 0 && have_fmt) {
+            long count = size / 2;
+            uint8_t* raw = malloc(size);
+            *samples = malloc(sizeof(int16_t) * (count + 1));
+            if (!raw || !*samples) {
+                free(raw);
+                free(*samples);
+                break;
+            }
+            long got = (long)fread(raw, 1, size, f) / 2;
+            for (long i = 0; i < got; i++) {
+                (*samples)[i] = (int16_t)(raw[2 * i] | (raw[2 * i + 1] << 8));
+            }
+            free(raw);
+            fclose(f);
+            return got;
+        } else {
+            fseek(f, (long)(size + (size & 1)), SEEK_CUR);
+        }
+    }
+    fclose(f);
+    return -1;
+}
+
+/**
+ * @brief Measure audio_cycle_count() ticks per second against the wall clock
+ * 
+ * Used as SystemCoreClock so the load meter reports host load correctly.
+ */
+static uint32_t calibrate_cycle_counter(void) {
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    uint32_t start = audio_cycle_count();
+    do {
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+    } while ((t1.tv_sec - t0.tv_sec) * 1e9 + (t1.tv_nsec - t0.tv_nsec) < 20e6);
+    uint32_t ticks = audio_cycle_count() - start;
+    double seconds = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) * 1e-9;
+    return (uint32_t)(ticks / seconds);
+}
+
+static double cpu_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/**
+ * @brief Flush denormal float operands and results to zero
+ * 
+ * x86 FPUs take a slow assist on every denormal, so a decaying tail that
+ * slips into the denormal range would dominate the cycle counts. Hosts
+ * without SSE keep IEEE denormals and get a warning instead.
+ */
+static void host_flush_denormals(void) {
+#if defined(__SSE2__)
+    _MM_SET_FLUSH_ZERO_MODE(_MM_FLUSH_ZERO_ON);
+    _MM_SET_DENORMALS_ZERO_MODE(_MM_DENORMALS_ZERO_ON);
+#else
+    fprintf(stderr, "warning: denormals not flushed on this host, cycle counts "
+                    "may include denormal stalls\n");
+#endif
+}
+
+// Host timing of one render
+typedef struct {
+    uint64_t voice_samples;
+    uint64_t ticks;
+    uint32_t peak_block_ticks;
+    double peak_block_seconds;
+} render_timing_t;
+
+/**
+ * @brief Render events into blocks * AUDIO_BUFFER_SIZE samples of 16-bit PCM
+ * 
+ * Event times count from the render clock at the call, so a render after a
+ * fresh init_audio_synthesizer() lines up with the first one.
+ */
+static void render_events(const render_event_t* events, int event_count, uint32_t blocks,
+                          int16_t* pcm, render_timing_t* timing) {
+    uint16_t dac[AUDIO_BUFFER_SIZE];
+    uint32_t base = render_clock;
+    int next = 0;
+
+    memset(timing, 0, sizeof(*timing));
+    for (uint32_t b = 0; b < blocks; b++) {
+        uint32_t block_end = render_clock + AUDIO_BUFFER_SIZE;
+
+        // Hand this block's events to the renderer the way the UART ISR
+        // would; effect changes take effect from the block they fall in
+        while (next < event_count &&
+               (int32_t)(base + events[next].midi.timestamp - block_end) < 0) {
+            const render_event_t* ev = &events[next];
+            if (ev->param >= 0) {
+                *effect_param(ev->param) = ev->value;
+            } else if (!midi_event_schedule(base + ev->midi.timestamp, ev->midi.status,
+                                            ev->midi.data1, ev->midi.data2)) {
+                break;               // Queue full: finish the block first
+            }
+            next++;
+        }
+
+        timing->voice_samples += (uint64_t)voice_store.active_count * AUDIO_BUFFER_SIZE;
+        double block_start = cpu_seconds();
+        uint32_t start = audio_cycle_count();
+        render_audio_block(dac, AUDIO_BUFFER_SIZE);
+        uint32_t ticks = audio_cycle_count() - start;
+        double block_seconds = cpu_seconds() - block_start;
+
+        timing->ticks += ticks;
+        if (ticks > timing->peak_block_ticks) timing->peak_block_ticks = ticks;
+        if (block_seconds > timing->peak_block_seconds) timing->peak_block_seconds = block_seconds;
+
+        // 12-bit unsigned DAC codes to 16-bit signed PCM
+        for (uint32_t n = 0; n < AUDIO_BUFFER_SIZE; n++) {
+            pcm[b * AUDIO_BUFFER_SIZE + n] = (int16_t)(((int32_t)dac[n] - 2048) * 16);
+        }
+    }
+}
+
+/**
+ * @brief Compare a render against a reference WAV and print the result
+ * @return 0 if every sample is within tolerance, 1 on a mismatch, 2 if the
+ *         reference cannot be read
+ */
+static int compare_golden(const int16_t* pcm, uint32_t total, const char* golden,
+                          long tolerance) {
+    int16_t* ref;
+    long ref_count = wav_read(golden, &ref);
+    if (ref_count < 0) {
+        fprintf(stderr, "cannot read golden file %s\n", golden);
+        return 2;
+    }
+
+    long max_diff = 0, first = -1, differing = 0;
+    long n_max = (ref_count > (long)total) ? ref_count : (long)total;
+    for (long i = 0; i < n_max; i++) {
+        long a = (i < (long)total) ? pcm[i] : 0;
+        long r = (i < ref_count) ? ref[i] : 0;
+        long d = labs(a - r);
+        if (d > tolerance) {
+            differing++;
+            if (first < 0) first = i;
+        }
+        if (d > max_diff) max_diff = d;
+    }
+
+    int result = (differing > 0 || ref_count != (long)total) ? 1 : 0;
+    printf("Golden %s: %s (max diff %ld LSB, %ld samples over %ld",
+           golden, result ? "FAIL" : "PASS", max_diff, differing, tolerance);
+    if (first >= 0) printf(", first at %.4fs", (double)first / SAMPLE_RATE);
+    if (ref_count != (long)total) printf(", length %ld vs %lu", ref_count, (unsigned long)total);
+    printf(")\n");
+    free(ref);
+    return result;
+}
+
+/**
+ * @brief DMA counter value with the DAC reading the middle of a half
+ */
+static uint32_t dma_counter_in_half(uint32_t half) {
+    return 2 * AUDIO_BUFFER_SIZE - (half * AUDIO_BUFFER_SIZE + AUDIO_BUFFER_SIZE / 2);
+}
+
+/**
+ * @brief Refill xrun counting against a scripted DMA position
+ *
+ * Runs each DAC DMA callback with the DMA placed, before and after the
+ * render, in the other half (on time), already in the target half (a late
+ * start: overrun) and reaching the target half during the render (too
+ * slow: underrun).
+ * @return Number of failed checks
+ */
+static int check_refill_xruns(void) {
+    static const struct {
+        uint32_t before, after;        // DMA half at the two reads, relative to the target
+        uint32_t overruns, underruns;
+        const char* name;
+    } cases[] = {
+        { 1, 1, 0, 0, "on time" },
+        { 0, 1, 1, 0, "late start" },
+        { 1, 0, 0, 1, "slow render" },
+    };
+    int failures = 0;
+
+    init_audio_synthesizer();
+    printf("Refill xrun counters\n");
+    for (uint32_t target = 0; target < 2; target++) {
+        for (size_t c = 0; c < sizeof(cases) / sizeof(cases[0]); c++) {
+            audio_reset_render_stats();
+            dma_script[0] = dma_counter_in_half(target ^ cases[c].before);
+            dma_script[1] = dma_counter_in_half(target ^ cases[c].after);
+            dma_script_length = 2;
+            dma_script_reads = 0;
+            if (target == 0) {
+                HAL_DAC_ConvHalfCpltCallbackCh1(&hdac1);
+            } else {
+                HAL_DAC_ConvCpltCallbackCh1(&hdac1);
+            }
+            dma_script_length = 0;
+
+            audio_load_stats_t stats;
+            audio_get_load_stats(&stats);
+            printf("  half %u %-12s %lu overruns, %lu underruns\n", (unsigned)target,
+                   cases[c].name, (unsigned long)stats.overruns,
+                   (unsigned long)stats.underruns);
+            if (stats.overruns != cases[c].overruns || stats.underruns != cases[c].underruns ||
+                dma_script_reads != 2) {
+                printf("  FAILED\n");
+                failures++;
+            }
+        }
+    }
+    return failures;
+}
+
+/**
+ * @brief Run the load governor for a number of blocks at a fixed load
+ * @return Blocks after which a voice was shed, in order (up to max_sheds)
+ */
+static uint32_t run_governor(float load_percent, uint32_t blocks,
+                             uint32_t* shed_at, uint32_t max_sheds) {
+    int32_t mix[AUDIO_BUFFER_SIZE];
+    uint32_t cycles = (uint32_t)(audio_budget_cycles(AUDIO_BUFFER_SIZE) * load_percent / 100.0f);
+    uint32_t sheds = 0;
+
+    for (uint32_t b = 0; b < blocks; b++) {
+        uint32_t before = render_stats.voices_shed;
+        audio_update_load(cycles, AUDIO_BUFFER_SIZE);
+        if (render_stats.voices_shed != before && sheds < max_sheds) {
+            shed_at[sheds++] = b;
+        }
+        render_voices(mix, AUDIO_BUFFER_SIZE);   // Retires the shed voice
+    }
+    return sheds;
+}
+
+/**
+ * @brief Shed and restore hysteresis of the polyphony governor
+ *
+ * Holds 16 notes and feeds the governor fixed block costs in place of the
+ * cycle counter. At 200% load the first voice goes once the average passes
+ * AUDIO_LOAD_SHED_PERCENT, then one every AUDIO_SHED_HOLDOFF + 1 blocks
+ * down to AUDIO_MIN_VOICES. Between the thresholds nothing changes; below
+ * AUDIO_LOAD_RESTORE_PERCENT the limit climbs back one voice per block. With
+ * shedding off the same overload must leave every voice sounding.
+ * @return Number of failed checks
+ */
+static int check_load_governor(void) {
+    uint32_t shed_at[MAX_VOICES];
+    int failures = 0;
+
+    init_audio_synthesizer();
+    audio_reset_render_stats();
+    render_stats.load_percent = 0.0f;
+    render_stats.shed_holdoff = 0;
+    audio_set_load_shedding(true);
+    for (uint8_t n = 0; n < 16; n++) {
+        handle_midi_note_on((uint8_t)(48 + n), 100);
+    }
+
+    // Block at which the 1/8 average first exceeds the shed threshold
+    uint32_t first = 0;
+    for (float avg = 0.0f; (avg += (200.0f - avg) * AUDIO_LOAD_SMOOTHING) <=
+                           AUDIO_LOAD_SHED_PERCENT; ) {
+        first++;
+    }
+    uint32_t sheds = run_governor(200.0f, 200, shed_at, MAX_VOICES);
+    bool spaced = sheds == 16 - AUDIO_MIN_VOICES && shed_at[0] == first;
+    for (uint32_t i = 1; i < sheds; i++) {
+        spaced = spaced && shed_at[i] - shed_at[i - 1] == AUDIO_SHED_HOLDOFF + 1;
+    }
+    uint32_t shed_active = voice_store.active_count;
+    uint32_t shed_limit = voice_store.voice_limit;
+
+    // Between the thresholds: the limit holds
+    run_governor(0.5f * (AUDIO_LOAD_SHED_PERCENT + AUDIO_LOAD_RESTORE_PERCENT), 100, NULL, 0);
+    uint32_t held_limit = voice_store.voice_limit;
+
+    // Below the restore threshold: back to full polyphony one voice per block
+    uint32_t restore_blocks = 0;
+    while (voice_store.voice_limit < MAX_VOICES && restore_blocks < 1000) {
+        run_governor(AUDIO_LOAD_RESTORE_PERCENT - 20.0f, 1, NULL, 0);
+        restore_blocks++;
+    }
+
+    printf("Load governor (16 notes held)\n");
+    printf("  200%% load: %u voices shed, first after block %u (expected %u), "
+           "%u active, limit %u\n", (unsigned)sheds, (unsigned)(sheds ? shed_at[0] : 0),
+           (unsigned)first, (unsigned)shed_active, (unsigned)shed_limit);
+    printf("  between thresholds: limit %u; restored to %d in %u blocks\n",
+           (unsigned)held_limit, MAX_VOICES, (unsigned)restore_blocks);
+    if (!spaced || shed_active != AUDIO_MIN_VOICES || shed_limit != AUDIO_MIN_VOICES ||
+        held_limit != shed_limit || voice_store.voice_limit != MAX_VOICES ||
+        restore_blocks > 16 + MAX_VOICES - AUDIO_MIN_VOICES) {
+        printf("  FAILED\n");
+        failures++;
+    }
+
+    // Shedding off: the meter still reads the overload, no voice goes
+    init_audio_synthesizer();
+    audio_reset_render_stats();
+    render_stats.load_percent = 0.0f;
+    render_stats.shed_holdoff = 0;
+    audio_set_load_shedding(false);
+    for (uint8_t n = 0; n < 16; n++) {
+        handle_midi_note_on((uint8_t)(48 + n), 100);
+    }
+    sheds = run_governor(200.0f, 200, shed_at, MAX_VOICES);
+    printf("  shedding off: %u shed, %u active, load %.0f%%\n", (unsigned)sheds,
+           (unsigned)voice_store.active_count, render_stats.load_percent);
+    if (sheds != 0 || voice_store.active_count != 16 || voice_store.voice_limit != MAX_VOICES ||
+        render_stats.load_percent < AUDIO_LOAD_SHED_PERCENT) {
+        printf("  FAILED\n");
+        failures++;
+    }
+    return failures;
+}
+
+/**
+ * @brief Golden render round trip through wav_write, wav_read and -g
+ * 
+ * Renders a built-in phrase that moves every effect parameter, writes it as
+ * the reference, then renders it again from a fresh init and compares with
+ * zero tolerance. A mismatch means state survives init (so renders are not
+ * repeatable and -g references go stale) or the WAV path is broken.
+ * @return Number of failed checks
+ */
+static int check_golden_render(void) {
+    #define GOLDEN_BLOCKS (SAMPLE_RATE / AUDIO_BUFFER_SIZE)   // About 1s
+    static const render_event_t phrase[] = {
+        { { 0, 0x90, 60, 100 }, -1, 0.0f },
+        { { 0, 0x90, 64, 90 }, -1, 0.0f },
+        { { SAMPLE_RATE / 10, 0, 0, 0 }, 0, 1200.0f },        // cutoff
+        { { SAMPLE_RATE / 10, 0, 0, 0 }, 1, 0.7f },           // resonance
+        { { SAMPLE_RATE / 5, 0x90, 67, 80 }, -1, 0.0f },
+        { { SAMPLE_RATE / 5, 0, 0, 0 }, 2, 4.0f },            // drive
+        { { SAMPLE_RATE / 4, 0, 0, 0 }, 3, 0.8f },            // reverb_time
+        { { SAMPLE_RATE / 4, 0, 0, 0 }, 4, 0.5f },            // reverb_mix
+        { { SAMPLE_RATE * 2 / 5, 0x80, 60, 0 }, -1, 0.0f },
+        { { SAMPLE_RATE / 2, 0x80, 64, 0 }, -1, 0.0f },
+        { { SAMPLE_RATE / 2, 0x80, 67, 0 }, -1, 0.0f },
+    };
+    static const char* path = "synth_selftest_golden.wav";
+    static int16_t pcm[2][GOLDEN_BLOCKS * AUDIO_BUFFER_SIZE];
+    uint32_t total = GOLDEN_BLOCKS * AUDIO_BUFFER_SIZE;
+    int count = (int)(sizeof(phrase) / sizeof(phrase[0]));
+    render_timing_t timing;
+    bool silent = true;
+
+    for (int run = 0; run < 2; run++) {
+        init_audio_synthesizer();
+        audio_set_load_shedding(false);
+        render_events(phrase, count, GOLDEN_BLOCKS, pcm[run], &timing);
+    }
+    for (uint32_t i = 0; i < total; i++) {
+        if (pcm[0][i] != 0) silent = false;
+    }
+
+    printf("Golden render round trip (%.2fs)\n", (double)total / SAMPLE_RATE);
+    if (silent || wav_write(path, pcm[0], total) != 0) {
+        printf("  %s FAIL\n", silent ? "reference render is silent" : "cannot write reference");
+        return 1;
+    }
+    printf("  ");
+    int result = compare_golden(pcm[1], total, path, 0);
+    remove(path);
+    return result ? 1 : 0;
+}
+
+int main(int argc, char** argv) {
+    const char* input = NULL;
+    const char* output = "synth_render.wav";
+    const char* golden = NULL;
+    long tolerance = 0;
+    double tail_seconds = 1.0;
+    bool shed_voices = false;
+
+    host_flush_denormals();
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--selftest") == 0) {
+            benchmark_oscillator_paths();
+            benchmark_voice_scaling();
+            stress_test_voice_allocator(NULL);
+            int failures = check_fixed_point_against_float();
+            failures += check_reverb_saturation_q15();
+            failures += check_refill_xruns();
+            failures += check_load_governor();
+            failures += check_golden_render();
+            return failures ? 1 : 0;
+        } else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            output = argv[++i];
+        } else if (strcmp(argv[i], "-g") == 0 && i + 1 < argc) {
+            golden = argv[++i];
+        } else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+            tolerance = atol(argv[++i]);
+        } else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+            tail_seconds = atof(argv[++i]);
+        } else if (strcmp(argv[i], "-l") == 0) {
+            shed_voices = true;
+        } else {
+            input = argv[i];
+        }
+    }
+    if (!input) {
+        fprintf(stderr, "usage: %s [-o out.wav] [-g golden.wav] [-t lsb] [-s seconds] [-l] "
+                        "<song.mid | events.txt>\n       %s --selftest\n", argv[0], argv[0]);
+        return 2;
+    }
+
+    render_event_t* events;
+    int event_count = load_events(input, &events);
+    if (event_count < 0) {
+        fprintf(stderr, "cannot load %s\n", input);
+        return 2;
+    }
+
+    uint32_t last = event_count ? events[event_count - 1].midi.timestamp : 0;
+    uint32_t blocks = (last + (uint32_t)(tail_seconds * SAMPLE_RATE)) / AUDIO_BUFFER_SIZE + 1;
+    uint32_t total = blocks * AUDIO_BUFFER_SIZE;
+    int16_t* pcm = malloc(sizeof(int16_t) * total);
+    if (!pcm) {
+        fprintf(stderr, "cannot allocate %u samples for %s\n", (unsigned)total, input);
+        return 2;
+    }
+    render_timing_t timing;
+
+    SystemCoreClock = calibrate_cycle_counter();
+    init_audio_synthesizer();
+    audio_set_load_shedding(shed_voices);
+    audio_reset_render_stats();
+    double cpu_start = cpu_seconds();
+    render_events(events, event_count, blocks, pcm, &timing);
+
+    double cpu_ms = (cpu_seconds() - cpu_start) * 1000.0;
+    double audio_ms = total * 1000.0 / SAMPLE_RATE;
+    double block_budget_us = AUDIO_BUFFER_SIZE * 1e6 / SAMPLE_RATE;
+
+    printf("Rendered %s: %.2fs audio, %d events, %s pipeline\n", input, audio_ms / 1000.0,
+           event_count, AUDIO_FIXED_POINT ? "Q15" : "float");
+    printf("  cycles/sample:      %.1f\n", (double)timing.ticks / total);
+    printf("  CPU time:           %.1fms (%.1fx real time)\n", cpu_ms, audio_ms / cpu_ms);
+    printf("  average voices:     %.1f\n", (double)timing.voice_samples / total);
+    printf("  voices per ms CPU:  %.1f (voice-ms rendered per CPU ms)\n",
+           timing.voice_samples * 1000.0 / SAMPLE_RATE / cpu_ms);
+    printf("  peak block:         %lu cycles, %.1fus (budget %.0fus)\n",
+           (unsigned long)timing.peak_block_ticks, timing.peak_block_seconds * 1e6,
+           block_budget_us);
+
+    audio_load_stats_t load;
+    audio_get_load_stats(&load);
+    printf("  host load:          %.2f%% running, %.2f%% peak, %lu voices shed\n",
+           load.load_percent, load.peak_load_percent, (unsigned long)load.voices_shed);
+
+    if (wav_write(output, pcm, total) != 0) {
+        fprintf(stderr, "cannot write %s\n", output);
+        return 2;
+    }
+    printf("  wrote %s\n", output);
+
+    int result = golden ? compare_golden(pcm, total, golden, tolerance) : 0;
+
+    free(pcm);
+    free(events);
+    return result;
+}
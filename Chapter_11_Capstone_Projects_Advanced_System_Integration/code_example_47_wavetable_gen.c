@@ -0,0 +1,150 @@
+/*
+ * Code Example 47 - Wavetable Generator
+ * Language: C
+ * Chapter: Chapter_11_Capstone_Projects_Advanced_System_Integration
+ *
+ * Host tool that generates the band-limited oscillator tables used by
+ * code_example_47.c. The tables are emitted as const arrays so the linker
+ * places them in flash on the STM32.
+ *
+ * Usage:
+ * 1. gcc -O2 -o wavetable_gen code_example_47_wavetable_gen.c -lm
+ * 2. ./wavetable_gen > code_example_47_wavetables.h
+ *
+ * Each band covers one octave. A band only contains harmonics that stay
+ * below Nyquist (SAMPLE_RATE / 2) for the highest note in that band, so
+ * notes never alias no matter which band they are played from.
+ */
+
+#include <math.h>
+#include <stdio.h>
+
+#define SAMPLE_RATE 48000
+#define WAVETABLE_SIZE 256          // Must be a power of two
+#define WAVETABLE_BANDS 9
+#define BAND0_TOP_HZ 80.0           // Band k covers notes up to 80Hz * 2^k
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+typedef enum {
+    SHAPE_SQUARE,
+    SHAPE_TRIANGLE,
+    SHAPE_SAWTOOTH
+} shape_t;
+
+/**
+ * @brief Amplitude of harmonic k for a shape (0 if the harmonic is absent)
+ *
+ * Series match the naive waveforms in code_example_47.c: square is +1 in the
+ * first half period, triangle starts at -1, sawtooth rises from -1 to +1.
+ */
+static double harmonic_amplitude(shape_t shape, int k) {
+    switch (shape) {
+        case SHAPE_SQUARE:
+            return (k % 2) ? 4.0 / (M_PI * k) : 0.0;
+        case SHAPE_TRIANGLE:
+            return (k % 2) ? -8.0 / (M_PI * M_PI * k * k) : 0.0;
+        case SHAPE_SAWTOOTH:
+            return -2.0 / (M_PI * k);
+    }
+    return 0.0;
+}
+
+/**
+ * @brief Build one band-limited table with Lanczos sigma smoothing
+ */
+static void build_table(shape_t shape, int harmonics, double* table) {
+    double peak = 0.0;
+
+    for (int i = 0; i < WAVETABLE_SIZE; i++) {
+        double phase = 2.0 * M_PI * i / WAVETABLE_SIZE;
+        double value = 0.0;
+
+        for (int k = 1; k <= harmonics; k++) {
+            double amplitude = harmonic_amplitude(shape, k);
+            if (amplitude == 0.0) continue;
+
+            // Sigma factor tames Gibbs ringing from the truncated series
+            double x = M_PI * k / (harmonics + 1);
+            amplitude *= sin(x) / x;
+
+            // Triangle is a cosine series, square and sawtooth are sine series
+            value += amplitude * ((shape == SHAPE_TRIANGLE) ? cos(k * phase)
+                                                            : sin(k * phase));
+        }
+
+        table[i] = value;
+        if (fabs(value) > peak) peak = fabs(value);
+    }
+
+    // Normalize every band to the same peak level
+    for (int i = 0; i < WAVETABLE_SIZE; i++) {
+        table[i] /= peak;
+    }
+}
+
+/**
+ * @brief Print a table as Q15 with a guard point for interpolation
+ */
+static void print_table(const double* table, const char* indent) {
+    for (int i = 0; i <= WAVETABLE_SIZE; i++) {
+        long q15 = lround(table[i % WAVETABLE_SIZE] * 32767.0);
+        if (i % 12 == 0) printf("%s", indent);
+        printf("%6ld,", q15);
+        if (i % 12 == 11 || i == WAVETABLE_SIZE) printf("\n");
+    }
+}
+
+int main(void) {
+    static const char* names[] = { "square", "triangle", "sawtooth" };
+    double table[WAVETABLE_SIZE];
+
+    printf("/*\n");
+    printf(" * Band-limited wavetables for Code Example 47\n");
+    printf(" * Generated by code_example_47_wavetable_gen.c - do not edit\n");
+    printf(" * \n");
+    printf(" * Q15 samples, WAVETABLE_SIZE entries plus one guard point so linear\n");
+    printf(" * interpolation never needs to wrap the index.\n");
+    printf(" */\n\n");
+    printf("#ifndef CODE_EXAMPLE_47_WAVETABLES_H\n");
+    printf("#define CODE_EXAMPLE_47_WAVETABLES_H\n\n");
+    printf("#define WAVETABLE_SIZE %d\n", WAVETABLE_SIZE);
+    printf("#define WAVETABLE_BANDS %d\n", WAVETABLE_BANDS);
+    printf("#define WAVETABLE_BAND0_TOP_HZ %.1ff\n\n", BAND0_TOP_HZ);
+
+    // Sine has a single harmonic and needs only one band
+    for (int i = 0; i < WAVETABLE_SIZE; i++) {
+        table[i] = sin(2.0 * M_PI * i / WAVETABLE_SIZE);
+    }
+    printf("static const int16_t wavetable_sine[WAVETABLE_SIZE + 1] = {\n");
+    print_table(table, "    ");
+    printf("};\n");
+
+    for (int shape = SHAPE_SQUARE; shape <= SHAPE_SAWTOOTH; shape++) {
+        printf("\nstatic const int16_t wavetable_%s[WAVETABLE_BANDS][WAVETABLE_SIZE + 1] = {\n",
+               names[shape]);
+
+        for (int band = 0; band < WAVETABLE_BANDS; band++) {
+            double top_hz = BAND0_TOP_HZ * (1 << band);
+            int harmonics = (int)((SAMPLE_RATE / 2) / top_hz);
+
+            // The table itself can only hold harmonics below its own Nyquist
+            if (harmonics > WAVETABLE_SIZE / 2 - 1) {
+                harmonics = WAVETABLE_SIZE / 2 - 1;
+            }
+
+            build_table((shape_t)shape, harmonics, table);
+            printf("    // Band %d: notes up to %.0fHz, %d harmonics\n",
+                   band, top_hz, harmonics);
+            printf("    {\n");
+            print_table(table, "        ");
+            printf("    },\n");
+        }
+        printf("};\n");
+    }
+
+    printf("\n#endif /* CODE_EXAMPLE_47_WAVETABLES_H */\n");
+    return 0;
+}
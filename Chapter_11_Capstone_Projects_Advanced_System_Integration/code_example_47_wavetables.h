@@ -0,0 +1,725 @@
+/*
+ * Band-limited wavetables for Code Example 47
+ * Generated by code_example_47_wavetable_gen.c - do not edit
+ * 
+ * Q15 samples, WAVETABLE_SIZE entries plus one guard point so linear
+ * interpolation never needs to wrap the index.
+ */
+
+#ifndef CODE_EXAMPLE_47_WAVETABLES_H
+#define CODE_EXAMPLE_47_WAVETABLES_H
+
+#define WAVETABLE_SIZE 256
+#define WAVETABLE_BANDS 9
+#define WAVETABLE_BAND0_TOP_HZ 80.0f
+
+static const int16_t wavetable_sine[WAVETABLE_SIZE + 1] = {
+         0,   804,  1608,  2410,  3212,  4011,  4808,  5602,  6393,  7179,  7962,  8739,
+      9512, 10278, 11039, 11793, 12539, 13279, 14010, 14732, 15446, 16151, 16846, 17530,
+     18204, 18868, 19519, 20159, 20787, 21403, 22005, 22594, 23170, 23731, 24279, 24811,
+     25329, 25832, 26319, 26790, 27245, 27683, 28105, 28510, 28898, 29268, 29621, 29956,
+     30273, 30571, 30852, 31113, 31356, 31580, 31785, 31971, 32137, 32285, 32412, 32521,
+     32609, 32678, 32728, 32757, 32767, 32757, 32728, 32678, 32609, 32521, 32412, 32285,
+     32137, 31971, 31785, 31580, 31356, 31113, 30852, 30571, 30273, 29956, 29621, 29268,
+     28898, 28510, 28105, 27683, 27245, 26790, 26319, 25832, 25329, 24811, 24279, 23731,
+     23170, 22594, 22005, 21403, 20787, 20159, 19519, 18868, 18204, 17530, 16846, 16151,
+     15446, 14732, 14010, 13279, 12539, 11793, 11039, 10278,  9512,  8739,  7962,  7179,
+      6393,  5602,  4808,  4011,  3212,  2410,  1608,   804,     0,  -804, -1608, -2410,
+     -3212, -4011, -4808, -5602, -6393, -7179, -7962, -8739, -9512,-10278,-11039,-11793,
+    -12539,-13279,-14010,-14732,-15446,-16151,-16846,-17530,-18204,-18868,-19519,-20159,
+    -20787,-21403,-22005,-22594,-23170,-23731,-24279,-24811,-25329,-25832,-26319,-26790,
+    -27245,-27683,-28105,-28510,-28898,-29268,-29621,-29956,-30273,-30571,-30852,-31113,
+    -31356,-31580,-31785,-31971,-32137,-32285,-32412,-32521,-32609,-32678,-32728,-32757,
+    -32767,-32757,-32728,-32678,-32609,-32521,-32412,-32285,-32137,-31971,-31785,-31580,
+    -31356,-31113,-30852,-30571,-30273,-29956,-29621,-29268,-28898,-28510,-28105,-27683,
+    -27245,-26790,-26319,-25832,-25329,-24811,-24279,-23731,-23170,-22594,-22005,-21403,
+    -20787,-20159,-19519,-18868,-18204,-17530,-16846,-16151,-15446,-14732,-14010,-13279,
+    -12539,-11793,-11039,-10278, -9512, -8739, -7962, -7179, -6393, -5602, -4808, -4011,
+     -3212, -2410, -1608,  -804,     0,
+};
+
+static const int16_t wavetable_square[WAVETABLE_BANDS][WAVETABLE_SIZE + 1] = {
+    // Band 0: notes up to 80Hz, 127 harmonics
+    {
+             0, 29296, 32767, 32354, 32490, 32428, 32462, 32442, 32454, 32446, 32452, 32447,
+         32451, 32448, 32450, 32449, 32450, 32449, 32450, 32449, 32450, 32449, 32450, 32449,
+         32450, 32449, 32449, 32449, 32449, 32449, 32449, 32449, 32449, 32449, 32449, 32449,
+         32449, 32449, 32449, 32449, 32449, 32449, 32449, 32449, 32449, 32449, 32449, 32449,
+         32449, 32449, 32449, 32449, 32449, 32449, 32449, 32449, 32449, 32449, 32449, 32449,
+         32449, 32449, 32449, 32449, 32449, 32449, 32449, 32449, 32449, 32449, 32449, 32449,
+         32449, 32449, 32449, 32449, 32449, 32449, 32449, 32449, 32449, 32449, 32449, 32449,
+         32449, 32449, 32449, 32449, 32449, 32449, 32449, 32449, 32449, 32449, 32449, 32449,
+         32449, 32449, 32449, 32449, 32449, 32449, 32449, 32449, 32450, 32449, 32450, 32449,
+         32450, 32449, 32450, 32449, 32450, 32449, 32450, 32448, 32451, 32447, 32452, 32446,
+         32454, 32442, 32462, 32428, 32490, 32354, 32767, 29296,     0,-29296,-32767,-32354,
+        -32490,-32428,-32462,-32442,-32454,-32446,-32452,-32447,-32451,-32448,-32450,-32449,
+        -32450,-32449,-32450,-32449,-32450,-32449,-32450,-32449,-32450,-32449,-32449,-32449,
+        -32449,-32449,-32449,-32449,-32449,-32449,-32449,-32449,-32449,-32449,-32449,-32449,
+        -32449,-32449,-32449,-32449,-32449,-32449,-32449,-32449,-32449,-32449,-32449,-32449,
+        -32449,-32449,-32449,-32449,-32449,-32449,-32449,-32449,-32449,-32449,-32449,-32449,
+        -32449,-32449,-32449,-32449,-32449,-32449,-32449,-32449,-32449,-32449,-32449,-32449,
+        -32449,-32449,-32449,-32449,-32449,-32449,-32449,-32449,-32449,-32449,-32449,-32449,
+        -32449,-32449,-32449,-32449,-32449,-32449,-32449,-32449,-32449,-32449,-32449,-32449,
+        -32449,-32449,-32449,-32449,-32450,-32449,-32450,-32449,-32450,-32449,-32450,-32449,
+        -32450,-32449,-32450,-32448,-32451,-32447,-32452,-32446,-32454,-32442,-32462,-32428,
+        -32490,-32354,-32767,-29296,     0,
+    },
+    // Band 1: notes up to 160Hz, 127 harmonics
+    {
+             0, 29296, 32767, 32354, 32490, 32428, 32462, 32442, 32454, 32446, 32452, 32447,
+         32451, 32448, 32450, 32449, 32450, 32449, 32450, 32449, 32450, 32449, 32450, 32449,
+         32450, 32449, 32449, 32449, 32449, 32449, 32449, 32449, 32449, 32449, 32449, 32449,
+         32449, 32449, 32449, 32449, 32449, 32449, 32449, 32449, 32449, 32449, 32449, 32449,
+         32449, 32449, 32449, 32449, 32449, 32449, 32449, 32449, 32449, 32449, 32449, 32449,
+         32449, 32449, 32449, 32449, 32449, 32449, 32449, 32449, 32449, 32449, 32449, 32449,
+         32449, 32449, 32449, 32449, 32449, 32449, 32449, 32449, 32449, 32449, 32449, 32449,
+         32449, 32449, 32449, 32449, 32449, 32449, 32449, 32449, 32449, 32449, 32449, 32449,
+         32449, 32449, 32449, 32449, 32449, 32449, 32449, 32449, 32450, 32449, 32450, 32449,
+         32450, 32449, 32450, 32449, 32450, 32449, 32450, 32448, 32451, 32447, 32452, 32446,
+         32454, 32442, 32462, 32428, 32490, 32354, 32767, 29296,     0,-29296,-32767,-32354,
+        -32490,-32428,-32462,-32442,-32454,-32446,-32452,-32447,-32451,-32448,-32450,-32449,
+        -32450,-32449,-32450,-32449,-32450,-32449,-32450,-32449,-32450,-32449,-32449,-32449,
+        -32449,-32449,-32449,-32449,-32449,-32449,-32449,-32449,-32449,-32449,-32449,-32449,
+        -32449,-32449,-32449,-32449,-32449,-32449,-32449,-32449,-32449,-32449,-32449,-32449,
+        -32449,-32449,-32449,-32449,-32449,-32449,-32449,-32449,-32449,-32449,-32449,-32449,
+        -32449,-32449,-32449,-32449,-32449,-32449,-32449,-32449,-32449,-32449,-32449,-32449,
+        -32449,-32449,-32449,-32449,-32449,-32449,-32449,-32449,-32449,-32449,-32449,-32449,
+        -32449,-32449,-32449,-32449,-32449,-32449,-32449,-32449,-32449,-32449,-32449,-32449,
+        -32449,-32449,-32449,-32449,-32450,-32449,-32450,-32449,-32450,-32449,-32450,-32449,
+        -32450,-32449,-32450,-32448,-32451,-32447,-32452,-32446,-32454,-32442,-32462,-32428,
+        -32490,-32354,-32767,-29296,     0,
+    },
+    // Band 2: notes up to 320Hz, 75 harmonics
+    {
+             0, 20378, 31155, 32767, 31876, 31982, 32261, 32078, 32020, 32153, 32123, 32052,
+         32108, 32129, 32078, 32089, 32122, 32097, 32084, 32111, 32107, 32087, 32101, 32109,
+         32094, 32095, 32107, 32100, 32093, 32103, 32103, 32095, 32099, 32104, 32098, 32097,
+         32103, 32100, 32096, 32101, 32102, 32097, 32099, 32102, 32099, 32098, 32101, 32100,
+         32098, 32100, 32101, 32099, 32099, 32101, 32100, 32099, 32100, 32100, 32099, 32100,
+         32100, 32100, 32100, 32100, 32100, 32100, 32100, 32100, 32100, 32100, 32099, 32100,
+         32100, 32099, 32100, 32101, 32099, 32099, 32101, 32100, 32098, 32100, 32101, 32098,
+         32099, 32102, 32099, 32097, 32102, 32101, 32096, 32100, 32103, 32097, 32098, 32104,
+         32099, 32095, 32103, 32103, 32093, 32100, 32107, 32095, 32094, 32109, 32101, 32087,
+         32107, 32111, 32084, 32097, 32122, 32089, 32078, 32129, 32108, 32052, 32123, 32153,
+         32020, 32078, 32261, 31982, 31876, 32767, 31155, 20378,     0,-20378,-31155,-32767,
+        -31876,-31982,-32261,-32078,-32020,-32153,-32123,-32052,-32108,-32129,-32078,-32089,
+        -32122,-32097,-32084,-32111,-32107,-32087,-32101,-32109,-32094,-32095,-32107,-32100,
+        -32093,-32103,-32103,-32095,-32099,-32104,-32098,-32097,-32103,-32100,-32096,-32101,
+        -32102,-32097,-32099,-32102,-32099,-32098,-32101,-32100,-32098,-32100,-32101,-32099,
+        -32099,-32101,-32100,-32099,-32100,-32100,-32099,-32100,-32100,-32100,-32100,-32100,
+        -32100,-32100,-32100,-32100,-32100,-32100,-32099,-32100,-32100,-32099,-32100,-32101,
+        -32099,-32099,-32101,-32100,-32098,-32100,-32101,-32098,-32099,-32102,-32099,-32097,
+        -32102,-32101,-32096,-32100,-32103,-32097,-32098,-32104,-32099,-32095,-32103,-32103,
+        -32093,-32100,-32107,-32095,-32094,-32109,-32101,-32087,-32107,-32111,-32084,-32097,
+        -32122,-32089,-32078,-32129,-32108,-32052,-32123,-32153,-32020,-32078,-32261,-31982,
+        -31876,-32767,-31155,-20378,     0,
+    },
+    // Band 3: notes up to 640Hz, 37 harmonics
+    {
+             0, 10962, 20380, 27202, 31155, 32707, 32767, 32276, 31879, 31811, 31983, 32183,
+         32260, 32197, 32080, 32008, 32023, 32092, 32153, 32162, 32124, 32076, 32055, 32073,
+         32108, 32133, 32129, 32105, 32081, 32076, 32091, 32111, 32121, 32114, 32098, 32087,
+         32087, 32098, 32110, 32113, 32107, 32097, 32091, 32094, 32101, 32107, 32108, 32103,
+         32097, 32095, 32097, 32102, 32105, 32104, 32101, 32098, 32098, 32099, 32102, 32103,
+         32102, 32101, 32100, 32100, 32100, 32100, 32100, 32101, 32102, 32103, 32102, 32099,
+         32098, 32098, 32101, 32104, 32105, 32102, 32097, 32095, 32097, 32103, 32108, 32107,
+         32101, 32094, 32091, 32097, 32107, 32113, 32110, 32098, 32087, 32087, 32098, 32114,
+         32121, 32111, 32091, 32076, 32081, 32105, 32129, 32133, 32108, 32073, 32055, 32076,
+         32124, 32162, 32153, 32092, 32023, 32008, 32080, 32197, 32260, 32183, 31983, 31811,
+         31879, 32276, 32767, 32707, 31155, 27202, 20380, 10962,     0,-10962,-20380,-27202,
+        -31155,-32707,-32767,-32276,-31879,-31811,-31983,-32183,-32260,-32197,-32080,-32008,
+        -32023,-32092,-32153,-32162,-32124,-32076,-32055,-32073,-32108,-32133,-32129,-32105,
+        -32081,-32076,-32091,-32111,-32121,-32114,-32098,-32087,-32087,-32098,-32110,-32113,
+        -32107,-32097,-32091,-32094,-32101,-32107,-32108,-32103,-32097,-32095,-32097,-32102,
+        -32105,-32104,-32101,-32098,-32098,-32099,-32102,-32103,-32102,-32101,-32100,-32100,
+        -32100,-32100,-32100,-32101,-32102,-32103,-32102,-32099,-32098,-32098,-32101,-32104,
+        -32105,-32102,-32097,-32095,-32097,-32103,-32108,-32107,-32101,-32094,-32091,-32097,
+        -32107,-32113,-32110,-32098,-32087,-32087,-32098,-32114,-32121,-32111,-32091,-32076,
+        -32081,-32105,-32129,-32133,-32108,-32073,-32055,-32076,-32124,-32162,-32153,-32092,
+        -32023,-32008,-32080,-32197,-32260,-32183,-31983,-31811,-31879,-32276,-32767,-32707,
+        -31155,-27202,-20380,-10962,     0,
+    },
+    // Band 4: notes up to 1280Hz, 18 harmonics
+    {
+             0,  5555, 10908, 15870, 20290, 24054, 27102, 29424, 31060, 32087, 32615, 32767,
+         32668, 32433, 32159, 31917, 31749, 31673, 31683, 31759, 31871, 31990, 32089, 32152,
+         32171, 32148, 32095, 32026, 31958, 31904, 31875, 31873, 31896, 31937, 31986, 32031,
+         32064, 32079, 32074, 32051, 32017, 31980, 31947, 31925, 31918, 31927, 31949, 31979,
+         32010, 32036, 32050, 32052, 32040, 32018, 31991, 31964, 31943, 31933, 31936, 31950,
+         31973, 31999, 32023, 32040, 32046, 32040, 32023, 31999, 31973, 31950, 31936, 31933,
+         31943, 31964, 31991, 32018, 32040, 32052, 32050, 32036, 32010, 31979, 31949, 31927,
+         31918, 31925, 31947, 31980, 32017, 32051, 32074, 32079, 32064, 32031, 31986, 31937,
+         31896, 31873, 31875, 31904, 31958, 32026, 32095, 32148, 32171, 32152, 32089, 31990,
+         31871, 31759, 31683, 31673, 31749, 31917, 32159, 32433, 32668, 32767, 32615, 32087,
+         31060, 29424, 27102, 24054, 20290, 15870, 10908,  5555,     0, -5555,-10908,-15870,
+        -20290,-24054,-27102,-29424,-31060,-32087,-32615,-32767,-32668,-32433,-32159,-31917,
+        -31749,-31673,-31683,-31759,-31871,-31990,-32089,-32152,-32171,-32148,-32095,-32026,
+        -31958,-31904,-31875,-31873,-31896,-31937,-31986,-32031,-32064,-32079,-32074,-32051,
+        -32017,-31980,-31947,-31925,-31918,-31927,-31949,-31979,-32010,-32036,-32050,-32052,
+        -32040,-32018,-31991,-31964,-31943,-31933,-31936,-31950,-31973,-31999,-32023,-32040,
+        -32046,-32040,-32023,-31999,-31973,-31950,-31936,-31933,-31943,-31964,-31991,-32018,
+        -32040,-32052,-32050,-32036,-32010,-31979,-31949,-31927,-31918,-31925,-31947,-31980,
+        -32017,-32051,-32074,-32079,-32064,-32031,-31986,-31937,-31896,-31873,-31875,-31904,
+        -31958,-32026,-32095,-32148,-32171,-32152,-32089,-31990,-31871,-31759,-31683,-31673,
+        -31749,-31917,-32159,-32433,-32668,-32767,-32615,-32087,-31060,-29424,-27102,-24054,
+        -20290,-15870,-10908, -5555,     0,
+    },
+    // Band 5: notes up to 2560Hz, 9 harmonics
+    {
+             0,  2954,  5878,  8740, 11513, 14169, 16685, 19041, 21220, 23208, 24997, 26582,
+         27964, 29144, 30131, 30935, 31568, 32047, 32388, 32609, 32729, 32767, 32740, 32666,
+         32559, 32434, 32303, 32176, 32059, 31960, 31880, 31823, 31788, 31774, 31779, 31799,
+         31832, 31873, 31919, 31967, 32012, 32053, 32089, 32116, 32136, 32147, 32151, 32148,
+         32139, 32126, 32111, 32093, 32075, 32059, 32043, 32030, 32020, 32012, 32006, 32002,
+         32000, 31999, 31999, 31998, 31998, 31998, 31999, 31999, 32000, 32002, 32006, 32012,
+         32020, 32030, 32043, 32059, 32075, 32093, 32111, 32126, 32139, 32148, 32151, 32147,
+         32136, 32116, 32089, 32053, 32012, 31967, 31919, 31873, 31832, 31799, 31779, 31774,
+         31788, 31823, 31880, 31960, 32059, 32176, 32303, 32434, 32559, 32666, 32740, 32767,
+         32729, 32609, 32388, 32047, 31568, 30935, 30131, 29144, 27964, 26582, 24997, 23208,
+         21220, 19041, 16685, 14169, 11513,  8740,  5878,  2954,     0, -2954, -5878, -8740,
+        -11513,-14169,-16685,-19041,-21220,-23208,-24997,-26582,-27964,-29144,-30131,-30935,
+        -31568,-32047,-32388,-32609,-32729,-32767,-32740,-32666,-32559,-32434,-32303,-32176,
+        -32059,-31960,-31880,-31823,-31788,-31774,-31779,-31799,-31832,-31873,-31919,-31967,
+        -32012,-32053,-32089,-32116,-32136,-32147,-32151,-32148,-32139,-32126,-32111,-32093,
+        -32075,-32059,-32043,-32030,-32020,-32012,-32006,-32002,-32000,-31999,-31999,-31998,
+        -31998,-31998,-31999,-31999,-32000,-32002,-32006,-32012,-32020,-32030,-32043,-32059,
+        -32075,-32093,-32111,-32126,-32139,-32148,-32151,-32147,-32136,-32116,-32089,-32053,
+        -32012,-31967,-31919,-31873,-31832,-31799,-31779,-31774,-31788,-31823,-31880,-31960,
+        -32059,-32176,-32303,-32434,-32559,-32666,-32740,-32767,-32729,-32609,-32388,-32047,
+        -31568,-30935,-30131,-29144,-27964,-26582,-24997,-23208,-21220,-19041,-16685,-14169,
+        -11513, -8740, -5878, -2954,     0,
+    },
+    // Band 6: notes up to 5120Hz, 4 harmonics
+    {
+             0,  1428,  2852,  4270,  5678,  7073,  8452,  9812, 11150, 12463, 13748, 15003,
+         16226, 17413, 18563, 19674, 20744, 21771, 22753, 23691, 24582, 25425, 26220, 26967,
+         27665, 28315, 28916, 29468, 29973, 30431, 30843, 31210, 31534, 31815, 32056, 32258,
+         32423, 32553, 32650, 32717, 32755, 32767, 32755, 32722, 32670, 32602, 32519, 32425,
+         32322, 32211, 32096, 31979, 31861, 31744, 31632, 31524, 31423, 31330, 31247, 31175,
+         31115, 31067, 31032, 31011, 31004, 31011, 31032, 31067, 31115, 31175, 31247, 31330,
+         31423, 31524, 31632, 31744, 31861, 31979, 32096, 32211, 32322, 32425, 32519, 32602,
+         32670, 32722, 32755, 32767, 32755, 32717, 32650, 32553, 32423, 32258, 32056, 31815,
+         31534, 31210, 30843, 30431, 29973, 29468, 28916, 28315, 27665, 26967, 26220, 25425,
+         24582, 23691, 22753, 21771, 20744, 19674, 18563, 17413, 16226, 15003, 13748, 12463,
+         11150,  9812,  8452,  7073,  5678,  4270,  2852,  1428,     0, -1428, -2852, -4270,
+         -5678, -7073, -8452, -9812,-11150,-12463,-13748,-15003,-16226,-17413,-18563,-19674,
+        -20744,-21771,-22753,-23691,-24582,-25425,-26220,-26967,-27665,-28315,-28916,-29468,
+        -29973,-30431,-30843,-31210,-31534,-31815,-32056,-32258,-32423,-32553,-32650,-32717,
+        -32755,-32767,-32755,-32722,-32670,-32602,-32519,-32425,-32322,-32211,-32096,-31979,
+        -31861,-31744,-31632,-31524,-31423,-31330,-31247,-31175,-31115,-31067,-31032,-31011,
+        -31004,-31011,-31032,-31067,-31115,-31175,-31247,-31330,-31423,-31524,-31632,-31744,
+        -31861,-31979,-32096,-32211,-32322,-32425,-32519,-32602,-32670,-32722,-32755,-32767,
+        -32755,-32717,-32650,-32553,-32423,-32258,-32056,-31815,-31534,-31210,-30843,-30431,
+        -29973,-29468,-28916,-28315,-27665,-26967,-26220,-25425,-24582,-23691,-22753,-21771,
+        -20744,-19674,-18563,-17413,-16226,-15003,-13748,-12463,-11150, -9812, -8452, -7073,
+         -5678, -4270, -2852, -1428,     0,
+    },
+    // Band 7: notes up to 10240Hz, 2 harmonics
+    {
+             0,   804,  1608,  2410,  3212,  4011,  4808,  5602,  6393,  7179,  7962,  8739,
+          9512, 10278, 11039, 11793, 12539, 13279, 14010, 14732, 15446, 16151, 16846, 17530,
+         18204, 18868, 19519, 20159, 20787, 21403, 22005, 22594, 23170, 23731, 24279, 24811,
+         25329, 25832, 26319, 26790, 27245, 27683, 28105, 28510, 28898, 29268, 29621, 29956,
+         30273, 30571, 30852, 31113, 31356, 31580, 31785, 31971, 32137, 32285, 32412, 32521,
+         32609, 32678, 32728, 32757, 32767, 32757, 32728, 32678, 32609, 32521, 32412, 32285,
+         32137, 31971, 31785, 31580, 31356, 31113, 30852, 30571, 30273, 29956, 29621, 29268,
+         28898, 28510, 28105, 27683, 27245, 26790, 26319, 25832, 25329, 24811, 24279, 23731,
+         23170, 22594, 22005, 21403, 20787, 20159, 19519, 18868, 18204, 17530, 16846, 16151,
+         15446, 14732, 14010, 13279, 12539, 11793, 11039, 10278,  9512,  8739,  7962,  7179,
+          6393,  5602,  4808,  4011,  3212,  2410,  1608,   804,     0,  -804, -1608, -2410,
+         -3212, -4011, -4808, -5602, -6393, -7179, -7962, -8739, -9512,-10278,-11039,-11793,
+        -12539,-13279,-14010,-14732,-15446,-16151,-16846,-17530,-18204,-18868,-19519,-20159,
+        -20787,-21403,-22005,-22594,-23170,-23731,-24279,-24811,-25329,-25832,-26319,-26790,
+        -27245,-27683,-28105,-28510,-28898,-29268,-29621,-29956,-30273,-30571,-30852,-31113,
+        -31356,-31580,-31785,-31971,-32137,-32285,-32412,-32521,-32609,-32678,-32728,-32757,
+        -32767,-32757,-32728,-32678,-32609,-32521,-32412,-32285,-32137,-31971,-31785,-31580,
+        -31356,-31113,-30852,-30571,-30273,-29956,-29621,-29268,-28898,-28510,-28105,-27683,
+        -27245,-26790,-26319,-25832,-25329,-24811,-24279,-23731,-23170,-22594,-22005,-21403,
+        -20787,-20159,-19519,-18868,-18204,-17530,-16846,-16151,-15446,-14732,-14010,-13279,
+        -12539,-11793,-11039,-10278, -9512, -8739, -7962, -7179, -6393, -5602, -4808, -4011,
+         -3212, -2410, -1608,  -804,     0,
+    },
+    // Band 8: notes up to 20480Hz, 1 harmonics
+    {
+             0,   804,  1608,  2410,  3212,  4011,  4808,  5602,  6393,  7179,  7962,  8739,
+          9512, 10278, 11039, 11793, 12539, 13279, 14010, 14732, 15446, 16151, 16846, 17530,
+         18204, 18868, 19519, 20159, 20787, 21403, 22005, 22594, 23170, 23731, 24279, 24811,
+         25329, 25832, 26319, 26790, 27245, 27683, 28105, 28510, 28898, 29268, 29621, 29956,
+         30273, 30571, 30852, 31113, 31356, 31580, 31785, 31971, 32137, 32285, 32412, 32521,
+         32609, 32678, 32728, 32757, 32767, 32757, 32728, 32678, 32609, 32521, 32412, 32285,
+         32137, 31971, 31785, 31580, 31356, 31113, 30852, 30571, 30273, 29956, 29621, 29268,
+         28898, 28510, 28105, 27683, 27245, 26790, 26319, 25832, 25329, 24811, 24279, 23731,
+         23170, 22594, 22005, 21403, 20787, 20159, 19519, 18868, 18204, 17530, 16846, 16151,
+         15446, 14732, 14010, 13279, 12539, 11793, 11039, 10278,  9512,  8739,  7962,  7179,
+          6393,  5602,  4808,  4011,  3212,  2410,  1608,   804,     0,  -804, -1608, -2410,
+         -3212, -4011, -4808, -5602, -6393, -7179, -7962, -8739, -9512,-10278,-11039,-11793,
+        -12539,-13279,-14010,-14732,-15446,-16151,-16846,-17530,-18204,-18868,-19519,-20159,
+        -20787,-21403,-22005,-22594,-23170,-23731,-24279,-24811,-25329,-25832,-26319,-26790,
+        -27245,-27683,-28105,-28510,-28898,-29268,-29621,-29956,-30273,-30571,-30852,-31113,
+        -31356,-31580,-31785,-31971,-32137,-32285,-32412,-32521,-32609,-32678,-32728,-32757,
+        -32767,-32757,-32728,-32678,-32609,-32521,-32412,-32285,-32137,-31971,-31785,-31580,
+        -31356,-31113,-30852,-30571,-30273,-29956,-29621,-29268,-28898,-28510,-28105,-27683,
+        -27245,-26790,-26319,-25832,-25329,-24811,-24279,-23731,-23170,-22594,-22005,-21403,
+        -20787,-20159,-19519,-18868,-18204,-17530,-16846,-16151,-15446,-14732,-14010,-13279,
+        -12539,-11793,-11039,-10278, -9512, -8739, -7962, -7179, -6393, -5602, -4808, -4011,
+         -3212, -2410, -1608,  -804,     0,
+    },
+};
+
+static const int16_t wavetable_triangle[WAVETABLE_BANDS][WAVETABLE_SIZE + 1] = {
+    // Band 0: notes up to 80Hz, 127 harmonics
+    {
+        -32767,-32501,-31986,-31472,-30955,-30440,-29923,-29408,-28891,-28376,-27860,-27344,
+        -26828,-26312,-25796,-25280,-24764,-24248,-23732,-23216,-22700,-22185,-21669,-21153,
+        -20637,-20121,-19605,-19089,-18573,-18057,-17541,-17025,-16509,-15994,-15478,-14962,
+        -14446,-13930,-13414,-12898,-12382,-11866,-11350,-10834,-10318, -9802, -9287, -8771,
+         -8255, -7739, -7223, -6707, -6191, -5675, -5159, -4643, -4127, -3611, -3096, -2580,
+         -2064, -1548, -1032,  -516,     0,   516,  1032,  1548,  2064,  2580,  3096,  3611,
+          4127,  4643,  5159,  5675,  6191,  6707,  7223,  7739,  8255,  8771,  9287,  9802,
+         10318, 10834, 11350, 11866, 12382, 12898, 13414, 13930, 14446, 14962, 15478, 15994,
+         16509, 17025, 17541, 18057, 18573, 19089, 19605, 20121, 20637, 21153, 21669, 22185,
+         22700, 23216, 23732, 24248, 24764, 25280, 25796, 26312, 26828, 27344, 27860, 28376,
+         28891, 29408, 29923, 30440, 30955, 31472, 31986, 32501, 32767, 32501, 31986, 31472,
+         30955, 30440, 29923, 29408, 28891, 28376, 27860, 27344, 26828, 26312, 25796, 25280,
+         24764, 24248, 23732, 23216, 22700, 22185, 21669, 21153, 20637, 20121, 19605, 19089,
+         18573, 18057, 17541, 17025, 16509, 15994, 15478, 14962, 14446, 13930, 13414, 12898,
+         12382, 11866, 11350, 10834, 10318,  9802,  9287,  8771,  8255,  7739,  7223,  6707,
+          6191,  5675,  5159,  4643,  4127,  3611,  3096,  2580,  2064,  1548,  1032,   516,
+             0,  -516, -1032, -1548, -2064, -2580, -3096, -3611, -4127, -4643, -5159, -5675,
+         -6191, -6707, -7223, -7739, -8255, -8771, -9287, -9802,-10318,-10834,-11350,-11866,
+        -12382,-12898,-13414,-13930,-14446,-14962,-15478,-15994,-16509,-17025,-17541,-18057,
+        -18573,-19089,-19605,-20121,-20637,-21153,-21669,-22185,-22700,-23216,-23732,-24248,
+        -24764,-25280,-25796,-26312,-26828,-27344,-27860,-28376,-28891,-29408,-29923,-30440,
+        -30955,-31472,-31986,-32501,-32767,
+    },
+    // Band 1: notes up to 160Hz, 127 harmonics
+    {
+        -32767,-32501,-31986,-31472,-30955,-30440,-29923,-29408,-28891,-28376,-27860,-27344,
+        -26828,-26312,-25796,-25280,-24764,-24248,-23732,-23216,-22700,-22185,-21669,-21153,
+        -20637,-20121,-19605,-19089,-18573,-18057,-17541,-17025,-16509,-15994,-15478,-14962,
+        -14446,-13930,-13414,-12898,-12382,-11866,-11350,-10834,-10318, -9802, -9287, -8771,
+         -8255, -7739, -7223, -6707, -6191, -5675, -5159, -4643, -4127, -3611, -3096, -2580,
+         -2064, -1548, -1032,  -516,     0,   516,  1032,  1548,  2064,  2580,  3096,  3611,
+          4127,  4643,  5159,  5675,  6191,  6707,  7223,  7739,  8255,  8771,  9287,  9802,
+         10318, 10834, 11350, 11866, 12382, 12898, 13414, 13930, 14446, 14962, 15478, 15994,
+         16509, 17025, 17541, 18057, 18573, 19089, 19605, 20121, 20637, 21153, 21669, 22185,
+         22700, 23216, 23732, 24248, 24764, 25280, 25796, 26312, 26828, 27344, 27860, 28376,
+         28891, 29408, 29923, 30440, 30955, 31472, 31986, 32501, 32767, 32501, 31986, 31472,
+         30955, 30440, 29923, 29408, 28891, 28376, 27860, 27344, 26828, 26312, 25796, 25280,
+         24764, 24248, 23732, 23216, 22700, 22185, 21669, 21153, 20637, 20121, 19605, 19089,
+         18573, 18057, 17541, 17025, 16509, 15994, 15478, 14962, 14446, 13930, 13414, 12898,
+         12382, 11866, 11350, 10834, 10318,  9802,  9287,  8771,  8255,  7739,  7223,  6707,
+          6191,  5675,  5159,  4643,  4127,  3611,  3096,  2580,  2064,  1548,  1032,   516,
+             0,  -516, -1032, -1548, -2064, -2580, -3096, -3611, -4127, -4643, -5159, -5675,
+         -6191, -6707, -7223, -7739, -8255, -8771, -9287, -9802,-10318,-10834,-11350,-11866,
+        -12382,-12898,-13414,-13930,-14446,-14962,-15478,-15994,-16509,-17025,-17541,-18057,
+        -18573,-19089,-19605,-20121,-20637,-21153,-21669,-22185,-22700,-23216,-23732,-24248,
+        -24764,-25280,-25796,-26312,-26828,-27344,-27860,-28376,-28891,-29408,-29923,-30440,
+        -30955,-31472,-31986,-32501,-32767,
+    },
+    // Band 2: notes up to 320Hz, 75 harmonics
+    {
+        -32767,-32594,-32162,-31638,-31116,-30602,-30082,-29562,-29045,-28526,-28007,-27488,
+        -26970,-26451,-25932,-25414,-24895,-24376,-23858,-23339,-22820,-22302,-21783,-21265,
+        -20746,-20227,-19709,-19190,-18671,-18153,-17634,-17115,-16597,-16078,-15559,-15041,
+        -14522,-14003,-13485,-12966,-12448,-11929,-11410,-10892,-10373, -9854, -9336, -8817,
+         -8298, -7780, -7261, -6742, -6224, -5705, -5186, -4668, -4149, -3631, -3112, -2593,
+         -2075, -1556, -1037,  -519,     0,   519,  1037,  1556,  2075,  2593,  3112,  3631,
+          4149,  4668,  5186,  5705,  6224,  6742,  7261,  7780,  8298,  8817,  9336,  9854,
+         10373, 10892, 11410, 11929, 12448, 12966, 13485, 14003, 14522, 15041, 15559, 16078,
+         16597, 17115, 17634, 18153, 18671, 19190, 19709, 20227, 20746, 21265, 21783, 22302,
+         22820, 23339, 23858, 24376, 24895, 25414, 25932, 26451, 26970, 27488, 28007, 28526,
+         29045, 29562, 30082, 30602, 31116, 31638, 32162, 32594, 32767, 32594, 32162, 31638,
+         31116, 30602, 30082, 29562, 29045, 28526, 28007, 27488, 26970, 26451, 25932, 25414,
+         24895, 24376, 23858, 23339, 22820, 22302, 21783, 21265, 20746, 20227, 19709, 19190,
+         18671, 18153, 17634, 17115, 16597, 16078, 15559, 15041, 14522, 14003, 13485, 12966,
+         12448, 11929, 11410, 10892, 10373,  9854,  9336,  8817,  8298,  7780,  7261,  6742,
+          6224,  5705,  5186,  4668,  4149,  3631,  3112,  2593,  2075,  1556,  1037,   519,
+             0,  -519, -1037, -1556, -2075, -2593, -3112, -3631, -4149, -4668, -5186, -5705,
+         -6224, -6742, -7261, -7780, -8298, -8817, -9336, -9854,-10373,-10892,-11410,-11929,
+        -12448,-12966,-13485,-14003,-14522,-15041,-15559,-16078,-16597,-17115,-17634,-18153,
+        -18671,-19190,-19709,-20227,-20746,-21265,-21783,-22302,-22820,-23339,-23858,-24376,
+        -24895,-25414,-25932,-26451,-26970,-27488,-28007,-28526,-29045,-29562,-30082,-30602,
+        -31116,-31638,-32162,-32594,-32767,
+    },
+    // Band 3: notes up to 640Hz, 37 harmonics
+    {
+        -32767,-32676,-32417,-32023,-31542,-31016,-30479,-29947,-29422,-28901,-28379,-27854,
+        -27326,-26798,-26272,-25748,-25224,-24699,-24173,-23647,-23121,-22595,-22070,-21545,
+        -21020,-20494,-19968,-19442,-18917,-18392,-17867,-17341,-16816,-16290,-15764,-15239,
+        -14714,-14188,-13663,-13137,-12611,-12086,-11561,-11035,-10510, -9984, -9459, -8933,
+         -8408, -7882, -7357, -6831, -6306, -5780, -5255, -4729, -4204, -3678, -3153, -2627,
+         -2102, -1576, -1051,  -525,     0,   525,  1051,  1576,  2102,  2627,  3153,  3678,
+          4204,  4729,  5255,  5780,  6306,  6831,  7357,  7882,  8408,  8933,  9459,  9984,
+         10510, 11035, 11561, 12086, 12611, 13137, 13663, 14188, 14714, 15239, 15764, 16290,
+         16816, 17341, 17867, 18392, 18917, 19442, 19968, 20494, 21020, 21545, 22070, 22595,
+         23121, 23647, 24173, 24699, 25224, 25748, 26272, 26798, 27326, 27854, 28379, 28901,
+         29422, 29947, 30479, 31016, 31542, 32023, 32417, 32676, 32767, 32676, 32417, 32023,
+         31542, 31016, 30479, 29947, 29422, 28901, 28379, 27854, 27326, 26798, 26272, 25748,
+         25224, 24699, 24173, 23647, 23121, 22595, 22070, 21545, 21020, 20494, 19968, 19442,
+         18917, 18392, 17867, 17341, 16816, 16290, 15764, 15239, 14714, 14188, 13663, 13137,
+         12611, 12086, 11561, 11035, 10510,  9984,  9459,  8933,  8408,  7882,  7357,  6831,
+          6306,  5780,  5255,  4729,  4204,  3678,  3153,  2627,  2102,  1576,  1051,   525,
+             0,  -525, -1051, -1576, -2102, -2627, -3153, -3678, -4204, -4729, -5255, -5780,
+         -6306, -6831, -7357, -7882, -8408, -8933, -9459, -9984,-10510,-11035,-11561,-12086,
+        -12611,-13137,-13663,-14188,-14714,-15239,-15764,-16290,-16816,-17341,-17867,-18392,
+        -18917,-19442,-19968,-20494,-21020,-21545,-22070,-22595,-23121,-23647,-24173,-24699,
+        -25224,-25748,-26272,-26798,-27326,-27854,-28379,-28901,-29422,-29947,-30479,-31016,
+        -31542,-32023,-32417,-32676,-32767,
+    },
+    // Band 4: notes up to 1280Hz, 18 harmonics
+    {
+        -32767,-32720,-32581,-32354,-32048,-31673,-31241,-30763,-30252,-29718,-29172,-28620,
+        -28067,-27518,-26973,-26433,-25896,-25361,-24827,-24292,-23755,-23216,-22675,-22133,
+        -21591,-21048,-20506,-19965,-19425,-18887,-18349,-17811,-17273,-16735,-16195,-15655,
+        -15115,-14574,-14032,-13491,-12951,-12411,-11872,-11333,-10794,-10256, -9717, -9178,
+         -8638, -8098, -7557, -7016, -6476, -5935, -5395, -4856, -4317, -3778, -3239, -2700,
+         -2161, -1621, -1081,  -541,     0,   541,  1081,  1621,  2161,  2700,  3239,  3778,
+          4317,  4856,  5395,  5935,  6476,  7016,  7557,  8098,  8638,  9178,  9717, 10256,
+         10794, 11333, 11872, 12411, 12951, 13491, 14032, 14574, 15115, 15655, 16195, 16735,
+         17273, 17811, 18349, 18887, 19425, 19965, 20506, 21048, 21591, 22133, 22675, 23216,
+         23755, 24292, 24827, 25361, 25896, 26433, 26973, 27518, 28067, 28620, 29172, 29718,
+         30252, 30763, 31241, 31673, 32048, 32354, 32581, 32720, 32767, 32720, 32581, 32354,
+         32048, 31673, 31241, 30763, 30252, 29718, 29172, 28620, 28067, 27518, 26973, 26433,
+         25896, 25361, 24827, 24292, 23755, 23216, 22675, 22133, 21591, 21048, 20506, 19965,
+         19425, 18887, 18349, 17811, 17273, 16735, 16195, 15655, 15115, 14574, 14032, 13491,
+         12951, 12411, 11872, 11333, 10794, 10256,  9717,  9178,  8638,  8098,  7557,  7016,
+          6476,  5935,  5395,  4856,  4317,  3778,  3239,  2700,  2161,  1621,  1081,   541,
+             0,  -541, -1081, -1621, -2161, -2700, -3239, -3778, -4317, -4856, -5395, -5935,
+         -6476, -7016, -7557, -8098, -8638, -9178, -9717,-10256,-10794,-11333,-11872,-12411,
+        -12951,-13491,-14032,-14574,-15115,-15655,-16195,-16735,-17273,-17811,-18349,-18887,
+        -19425,-19965,-20506,-21048,-21591,-22133,-22675,-23216,-23755,-24292,-24827,-25361,
+        -25896,-26433,-26973,-27518,-28067,-28620,-29172,-29718,-30252,-30763,-31241,-31673,
+        -32048,-32354,-32581,-32720,-32767,
+    },
+    // Band 5: notes up to 2560Hz, 9 harmonics
+    {
+        -32767,-32741,-32663,-32533,-32354,-32126,-31853,-31536,-31179,-30786,-30359,-29902,
+        -29418,-28912,-28387,-27846,-27293,-26729,-26159,-25583,-25004,-24424,-23844,-23265,
+        -22687,-22112,-21539,-20968,-20399,-19832,-19267,-18703,-18140,-17577,-17015,-16452,
+        -15888,-15324,-14760,-14194,-13627,-13060,-12492,-11924,-11355,-10786,-10216, -9647,
+         -9078, -8509, -7940, -7372, -6803, -6236, -5668, -5101, -4534, -3967, -3400, -2833,
+         -2267, -1700, -1133,  -567,     0,   567,  1133,  1700,  2267,  2833,  3400,  3967,
+          4534,  5101,  5668,  6236,  6803,  7372,  7940,  8509,  9078,  9647, 10216, 10786,
+         11355, 11924, 12492, 13060, 13627, 14194, 14760, 15324, 15888, 16452, 17015, 17577,
+         18140, 18703, 19267, 19832, 20399, 20968, 21539, 22112, 22687, 23265, 23844, 24424,
+         25004, 25583, 26159, 26729, 27293, 27846, 28387, 28912, 29418, 29902, 30359, 30786,
+         31179, 31536, 31853, 32126, 32354, 32533, 32663, 32741, 32767, 32741, 32663, 32533,
+         32354, 32126, 31853, 31536, 31179, 30786, 30359, 29902, 29418, 28912, 28387, 27846,
+         27293, 26729, 26159, 25583, 25004, 24424, 23844, 23265, 22687, 22112, 21539, 20968,
+         20399, 19832, 19267, 18703, 18140, 17577, 17015, 16452, 15888, 15324, 14760, 14194,
+         13627, 13060, 12492, 11924, 11355, 10786, 10216,  9647,  9078,  8509,  7940,  7372,
+          6803,  6236,  5668,  5101,  4534,  3967,  3400,  2833,  2267,  1700,  1133,   567,
+             0,  -567, -1133, -1700, -2267, -2833, -3400, -3967, -4534, -5101, -5668, -6236,
+         -6803, -7372, -7940, -8509, -9078, -9647,-10216,-10786,-11355,-11924,-12492,-13060,
+        -13627,-14194,-14760,-15324,-15888,-16452,-17015,-17577,-18140,-18703,-19267,-19832,
+        -20399,-20968,-21539,-22112,-22687,-23265,-23844,-24424,-25004,-25583,-26159,-26729,
+        -27293,-27846,-28387,-28912,-29418,-29902,-30359,-30786,-31179,-31536,-31853,-32126,
+        -32354,-32533,-32663,-32741,-32767,
+    },
+    // Band 6: notes up to 5120Hz, 4 harmonics
+    {
+        -32767,-32753,-32710,-32638,-32538,-32410,-32255,-32071,-31861,-31624,-31361,-31072,
+        -30759,-30421,-30060,-29676,-29270,-28843,-28396,-27930,-27446,-26944,-26425,-25891,
+        -25343,-24781,-24207,-23620,-23024,-22418,-21802,-21180,-20550,-19914,-19273,-18627,
+        -17978,-17326,-16671,-16015,-15358,-14700,-14043,-13386,-12729,-12074,-11421,-10769,
+        -10119, -9471, -8826, -8183, -7542, -6904, -6267, -5634, -5002, -4372, -3744, -3118,
+         -2492, -1868, -1245,  -622,     0,   622,  1245,  1868,  2492,  3118,  3744,  4372,
+          5002,  5634,  6267,  6904,  7542,  8183,  8826,  9471, 10119, 10769, 11421, 12074,
+         12729, 13386, 14043, 14700, 15358, 16015, 16671, 17326, 17978, 18627, 19273, 19914,
+         20550, 21180, 21802, 22418, 23024, 23620, 24207, 24781, 25343, 25891, 26425, 26944,
+         27446, 27930, 28396, 28843, 29270, 29676, 30060, 30421, 30759, 31072, 31361, 31624,
+         31861, 32071, 32255, 32410, 32538, 32638, 32710, 32753, 32767, 32753, 32710, 32638,
+         32538, 32410, 32255, 32071, 31861, 31624, 31361, 31072, 30759, 30421, 30060, 29676,
+         29270, 28843, 28396, 27930, 27446, 26944, 26425, 25891, 25343, 24781, 24207, 23620,
+         23024, 22418, 21802, 21180, 20550, 19914, 19273, 18627, 17978, 17326, 16671, 16015,
+         15358, 14700, 14043, 13386, 12729, 12074, 11421, 10769, 10119,  9471,  8826,  8183,
+          7542,  6904,  6267,  5634,  5002,  4372,  3744,  3118,  2492,  1868,  1245,   622,
+             0,  -622, -1245, -1868, -2492, -3118, -3744, -4372, -5002, -5634, -6267, -6904,
+         -7542, -8183, -8826, -9471,-10119,-10769,-11421,-12074,-12729,-13386,-14043,-14700,
+        -15358,-16015,-16671,-17326,-17978,-18627,-19273,-19914,-20550,-21180,-21802,-22418,
+        -23024,-23620,-24207,-24781,-25343,-25891,-26425,-26944,-27446,-27930,-28396,-28843,
+        -29270,-29676,-30060,-30421,-30759,-31072,-31361,-31624,-31861,-32071,-32255,-32410,
+        -32538,-32638,-32710,-32753,-32767,
+    },
+    // Band 7: notes up to 10240Hz, 2 harmonics
+    {
+        -32767,-32757,-32728,-32678,-32609,-32521,-32412,-32285,-32137,-31971,-31785,-31580,
+        -31356,-31113,-30852,-30571,-30273,-29956,-29621,-29268,-28898,-28510,-28105,-27683,
+        -27245,-26790,-26319,-25832,-25329,-24811,-24279,-23731,-23170,-22594,-22005,-21403,
+        -20787,-20159,-19519,-18868,-18204,-17530,-16846,-16151,-15446,-14732,-14010,-13279,
+        -12539,-11793,-11039,-10278, -9512, -8739, -7962, -7179, -6393, -5602, -4808, -4011,
+         -3212, -2410, -1608,  -804,     0,   804,  1608,  2410,  3212,  4011,  4808,  5602,
+          6393,  7179,  7962,  8739,  9512, 10278, 11039, 11793, 12539, 13279, 14010, 14732,
+         15446, 16151, 16846, 17530, 18204, 18868, 19519, 20159, 20787, 21403, 22005, 22594,
+         23170, 23731, 24279, 24811, 25329, 25832, 26319, 26790, 27245, 27683, 28105, 28510,
+         28898, 29268, 29621, 29956, 30273, 30571, 30852, 31113, 31356, 31580, 31785, 31971,
+         32137, 32285, 32412, 32521, 32609, 32678, 32728, 32757, 32767, 32757, 32728, 32678,
+         32609, 32521, 32412, 32285, 32137, 31971, 31785, 31580, 31356, 31113, 30852, 30571,
+         30273, 29956, 29621, 29268, 28898, 28510, 28105, 27683, 27245, 26790, 26319, 25832,
+         25329, 24811, 24279, 23731, 23170, 22594, 22005, 21403, 20787, 20159, 19519, 18868,
+         18204, 17530, 16846, 16151, 15446, 14732, 14010, 13279, 12539, 11793, 11039, 10278,
+          9512,  8739,  7962,  7179,  6393,  5602,  4808,  4011,  3212,  2410,  1608,   804,
+             0,  -804, -1608, -2410, -3212, -4011, -4808, -5602, -6393, -7179, -7962, -8739,
+         -9512,-10278,-11039,-11793,-12539,-13279,-14010,-14732,-15446,-16151,-16846,-17530,
+        -18204,-18868,-19519,-20159,-20787,-21403,-22005,-22594,-23170,-23731,-24279,-24811,
+        -25329,-25832,-26319,-26790,-27245,-27683,-28105,-28510,-28898,-29268,-29621,-29956,
+        -30273,-30571,-30852,-31113,-31356,-31580,-31785,-31971,-32137,-32285,-32412,-32521,
+        -32609,-32678,-32728,-32757,-32767,
+    },
+    // Band 8: notes up to 20480Hz, 1 harmonics
+    {
+        -32767,-32757,-32728,-32678,-32609,-32521,-32412,-32285,-32137,-31971,-31785,-31580,
+        -31356,-31113,-30852,-30571,-30273,-29956,-29621,-29268,-28898,-28510,-28105,-27683,
+        -27245,-26790,-26319,-25832,-25329,-24811,-24279,-23731,-23170,-22594,-22005,-21403,
+        -20787,-20159,-19519,-18868,-18204,-17530,-16846,-16151,-15446,-14732,-14010,-13279,
+        -12539,-11793,-11039,-10278, -9512, -8739, -7962, -7179, -6393, -5602, -4808, -4011,
+         -3212, -2410, -1608,  -804,     0,   804,  1608,  2410,  3212,  4011,  4808,  5602,
+          6393,  7179,  7962,  8739,  9512, 10278, 11039, 11793, 12539, 13279, 14010, 14732,
+         15446, 16151, 16846, 17530, 18204, 18868, 19519, 20159, 20787, 21403, 22005, 22594,
+         23170, 23731, 24279, 24811, 25329, 25832, 26319, 26790, 27245, 27683, 28105, 28510,
+         28898, 29268, 29621, 29956, 30273, 30571, 30852, 31113, 31356, 31580, 31785, 31971,
+         32137, 32285, 32412, 32521, 32609, 32678, 32728, 32757, 32767, 32757, 32728, 32678,
+         32609, 32521, 32412, 32285, 32137, 31971, 31785, 31580, 31356, 31113, 30852, 30571,
+         30273, 29956, 29621, 29268, 28898, 28510, 28105, 27683, 27245, 26790, 26319, 25832,
+         25329, 24811, 24279, 23731, 23170, 22594, 22005, 21403, 20787, 20159, 19519, 18868,
+         18204, 17530, 16846, 16151, 15446, 14732, 14010, 13279, 12539, 11793, 11039, 10278,
+          9512,  8739,  7962,  7179,  6393,  5602,  4808,  4011,  3212,  2410,  1608,   804,
+             0,  -804, -1608, -2410, -3212, -4011, -4808, -5602, -6393, -7179, -7962, -8739,
+         -9512,-10278,-11039,-11793,-12539,-13279,-14010,-14732,-15446,-16151,-16846,-17530,
+        -18204,-18868,-19519,-20159,-20787,-21403,-22005,-22594,-23170,-23731,-24279,-24811,
+        -25329,-25832,-26319,-26790,-27245,-27683,-28105,-28510,-28898,-29268,-29621,-29956,
+        -30273,-30571,-30852,-31113,-31356,-31580,-31785,-31971,-32137,-32285,-32412,-32521,
+        -32609,-32678,-32728,-32757,-32767,
+    },
+};
+
+static const int16_t wavetable_sawtooth[WAVETABLE_BANDS][WAVETABLE_SIZE + 1] = {
+    // Band 0: notes up to 80Hz, 127 harmonics
+    {
+             0,-29499,-32767,-32090,-31971,-31651,-31427,-31149,-30905,-30638,-30387,-30125,
+        -29871,-29611,-29355,-29096,-28840,-28581,-28325,-28067,-27810,-27552,-27295,-27037,
+        -26780,-26522,-26265,-26007,-25750,-25492,-25235,-24977,-24720,-24462,-24205,-23947,
+        -23690,-23432,-23175,-22917,-22660,-22402,-22145,-21887,-21630,-21372,-21115,-20857,
+        -20600,-20342,-20085,-19827,-19570,-19312,-19055,-18797,-18540,-18282,-18025,-17767,
+        -17510,-17252,-16995,-16737,-16480,-16222,-15965,-15707,-15450,-15192,-14935,-14677,
+        -14420,-14162,-13905,-13647,-13390,-13132,-12875,-12617,-12360,-12102,-11845,-11587,
+        -11330,-11072,-10815,-10557,-10300,-10042, -9785, -9527, -9270, -9012, -8755, -8497,
+         -8240, -7982, -7725, -7467, -7210, -6952, -6695, -6437, -6180, -5922, -5665, -5407,
+         -5150, -4892, -4635, -4377, -4120, -3862, -3605, -3347, -3090, -2832, -2575, -2317,
+         -2060, -1802, -1545, -1287, -1030,  -772,  -515,  -257,     0,   257,   515,   772,
+          1030,  1287,  1545,  1802,  2060,  2317,  2575,  2832,  3090,  3347,  3605,  3862,
+          4120,  4377,  4635,  4892,  5150,  5407,  5665,  5922,  6180,  6437,  6695,  6952,
+          7210,  7467,  7725,  7982,  8240,  8497,  8755,  9012,  9270,  9527,  9785, 10042,
+         10300, 10557, 10815, 11072, 11330, 11587, 11845, 12102, 12360, 12617, 12875, 13132,
+         13390, 13647, 13905, 14162, 14420, 14677, 14935, 15192, 15450, 15707, 15965, 16222,
+         16480, 16737, 16995, 17252, 17510, 17767, 18025, 18282, 18540, 18797, 19055, 19312,
+         19570, 19827, 20085, 20342, 20600, 20857, 21115, 21372, 21630, 21887, 22145, 22402,
+         22660, 22917, 23175, 23432, 23690, 23947, 24205, 24462, 24720, 24977, 25235, 25492,
+         25750, 26007, 26265, 26522, 26780, 27037, 27295, 27552, 27810, 28067, 28325, 28581,
+         28840, 29096, 29355, 29611, 29871, 30125, 30387, 30638, 30905, 31149, 31427, 31651,
+         31971, 32090, 32767, 29499,     0,
+    },
+    // Band 1: notes up to 160Hz, 127 harmonics
+    {
+             0,-29499,-32767,-32090,-31971,-31651,-31427,-31149,-30905,-30638,-30387,-30125,
+        -29871,-29611,-29355,-29096,-28840,-28581,-28325,-28067,-27810,-27552,-27295,-27037,
+        -26780,-26522,-26265,-26007,-25750,-25492,-25235,-24977,-24720,-24462,-24205,-23947,
+        -23690,-23432,-23175,-22917,-22660,-22402,-22145,-21887,-21630,-21372,-21115,-20857,
+        -20600,-20342,-20085,-19827,-19570,-19312,-19055,-18797,-18540,-18282,-18025,-17767,
+        -17510,-17252,-16995,-16737,-16480,-16222,-15965,-15707,-15450,-15192,-14935,-14677,
+        -14420,-14162,-13905,-13647,-13390,-13132,-12875,-12617,-12360,-12102,-11845,-11587,
+        -11330,-11072,-10815,-10557,-10300,-10042, -9785, -9527, -9270, -9012, -8755, -8497,
+         -8240, -7982, -7725, -7467, -7210, -6952, -6695, -6437, -6180, -5922, -5665, -5407,
+         -5150, -4892, -4635, -4377, -4120, -3862, -3605, -3347, -3090, -2832, -2575, -2317,
+         -2060, -1802, -1545, -1287, -1030,  -772,  -515,  -257,     0,   257,   515,   772,
+          1030,  1287,  1545,  1802,  2060,  2317,  2575,  2832,  3090,  3347,  3605,  3862,
+          4120,  4377,  4635,  4892,  5150,  5407,  5665,  5922,  6180,  6437,  6695,  6952,
+          7210,  7467,  7725,  7982,  8240,  8497,  8755,  9012,  9270,  9527,  9785, 10042,
+         10300, 10557, 10815, 11072, 11330, 11587, 11845, 12102, 12360, 12617, 12875, 13132,
+         13390, 13647, 13905, 14162, 14420, 14677, 14935, 15192, 15450, 15707, 15965, 16222,
+         16480, 16737, 16995, 17252, 17510, 17767, 18025, 18282, 18540, 18797, 19055, 19312,
+         19570, 19827, 20085, 20342, 20600, 20857, 21115, 21372, 21630, 21887, 22145, 22402,
+         22660, 22917, 23175, 23432, 23690, 23947, 24205, 24462, 24720, 24977, 25235, 25492,
+         25750, 26007, 26265, 26522, 26780, 27037, 27295, 27552, 27810, 28067, 28325, 28581,
+         28840, 29096, 29355, 29611, 29871, 30125, 30387, 30638, 30905, 31149, 31427, 31651,
+         31971, 32090, 32767, 29499,     0,
+    },
+    // Band 2: notes up to 320Hz, 75 harmonics
+    {
+             0,-20599,-31373,-32767,-31597,-31449,-31479,-31034,-30718,-30599,-30311,-29980,
+        -29782,-29548,-29237,-28992,-28770,-28487,-28217,-27989,-27727,-27450,-27208,-26961,
+        -26687,-26431,-26189,-25923,-25659,-25414,-25158,-24891,-24640,-24389,-24124,-23867,
+        -23618,-23357,-23096,-22845,-22590,-22327,-22073,-21820,-21559,-21301,-21049,-20791,
+        -20531,-20277,-20022,-19761,-19506,-19253,-18993,-18735,-18482,-18225,-17965,-17710,
+        -17455,-17196,-16939,-16685,-16427,-16168,-15914,-15658,-15399,-15143,-14888,-14629,
+        -14372,-14118,-13860,-13602,-13347,-13091,-12832,-12576,-12321,-12063,-11806,-11551,
+        -11294,-11036,-10780,-10524,-10266,-10009, -9754, -9497, -9239, -8984, -8727, -8469,
+         -8213, -7958, -7699, -7443, -7188, -6930, -6672, -6417, -6161, -5902, -5646, -5391,
+         -5133, -4876, -4621, -4364, -4106, -3850, -3594, -3336, -3080, -2824, -2567, -2309,
+         -2054, -1797, -1539, -1283, -1028,  -769,  -513,  -258,     0,   258,   513,   769,
+          1028,  1283,  1539,  1797,  2054,  2309,  2567,  2824,  3080,  3336,  3594,  3850,
+          4106,  4364,  4621,  4876,  5133,  5391,  5646,  5902,  6161,  6417,  6672,  6930,
+          7188,  7443,  7699,  7958,  8213,  8469,  8727,  8984,  9239,  9497,  9754, 10009,
+         10266, 10524, 10780, 11036, 11294, 11551, 11806, 12063, 12321, 12576, 12832, 13091,
+         13347, 13602, 13860, 14118, 14372, 14629, 14888, 15143, 15399, 15658, 15914, 16168,
+         16427, 16685, 16939, 17196, 17455, 17710, 17965, 18225, 18482, 18735, 18993, 19253,
+         19506, 19761, 20022, 20277, 20531, 20791, 21049, 21301, 21559, 21820, 22073, 22327,
+         22590, 22845, 23096, 23357, 23618, 23867, 24124, 24389, 24640, 24891, 25158, 25414,
+         25659, 25923, 26189, 26431, 26687, 26961, 27208, 27450, 27727, 27989, 28217, 28487,
+         28770, 28992, 29237, 29548, 29782, 29980, 30311, 30599, 30718, 31034, 31479, 31449,
+         31597, 32767, 31373, 20599,     0,
+    },
+    // Band 3: notes up to 640Hz, 37 harmonics
+    {
+             0,-11155,-20703,-27551,-31410,-32767,-32567,-31791,-31114,-30782,-30703,-30654,
+        -30473,-30144,-29757,-29420,-29175,-28989,-28794,-28542,-28238,-27923,-27640,-27399,
+        -27178,-26945,-26679,-26389,-26100,-25833,-25589,-25353,-25104,-24834,-24552,-24276,
+        -24016,-23770,-23524,-23267,-22997,-22721,-22452,-22195,-21946,-21694,-21433,-21163,
+        -20891,-20626,-20371,-20119,-19864,-19601,-19331,-19063,-18800,-18545,-18292,-18034,
+        -17769,-17501,-17234,-16974,-16719,-16464,-16204,-15938,-15671,-15407,-15148,-14892,
+        -14635,-14373,-14108,-13841,-13579,-13321,-13064,-12806,-12543,-12278,-12012,-11751,
+        -11493,-11236,-10977,-10713,-10448,-10184, -9923, -9666, -9408, -9148, -8883, -8618,
+         -8355, -8096, -7838, -7580, -7318, -7054, -6789, -6527, -6268, -6010, -5751, -5489,
+         -5224, -4960, -4699, -4440, -4182, -3922, -3659, -3395, -3131, -2871, -2613, -2354,
+         -2093, -1830, -1565, -1302, -1043,  -785,  -526,  -264,     0,   264,   526,   785,
+          1043,  1302,  1565,  1830,  2093,  2354,  2613,  2871,  3131,  3395,  3659,  3922,
+          4182,  4440,  4699,  4960,  5224,  5489,  5751,  6010,  6268,  6527,  6789,  7054,
+          7318,  7580,  7838,  8096,  8355,  8618,  8883,  9148,  9408,  9666,  9923, 10184,
+         10448, 10713, 10977, 11236, 11493, 11751, 12012, 12278, 12543, 12806, 13064, 13321,
+         13579, 13841, 14108, 14373, 14635, 14892, 15148, 15407, 15671, 15938, 16204, 16464,
+         16719, 16974, 17234, 17501, 17769, 18034, 18292, 18545, 18800, 19063, 19331, 19601,
+         19864, 20119, 20371, 20626, 20891, 21163, 21433, 21694, 21946, 22195, 22452, 22721,
+         22997, 23267, 23524, 23770, 24016, 24276, 24552, 24834, 25104, 25353, 25589, 25833,
+         26100, 26389, 26679, 26945, 27178, 27399, 27640, 27923, 28238, 28542, 28794, 28989,
+         29175, 29420, 29757, 30144, 30473, 30654, 30703, 30782, 31114, 31791, 32567, 32767,
+         31410, 27551, 20703, 11155,     0,
+    },
+    // Band 4: notes up to 1280Hz, 18 harmonics
+    {
+             0, -5782,-11341,-16475,-21013,-24834,-27874,-30123,-31624,-32466,-32767,-32661,
+        -32286,-31765,-31202,-30673,-30222,-29868,-29605,-29410,-29253,-29103,-28933,-28726,
+        -28474,-28181,-27857,-27517,-27179,-26854,-26553,-26278,-26027,-25792,-25565,-25334,
+        -25092,-24834,-24558,-24268,-23967,-23663,-23363,-23073,-22795,-22529,-22274,-22024,
+        -21776,-21523,-21263,-20993,-20713,-20426,-20135,-19845,-19559,-19280,-19009,-18745,
+        -18486,-18229,-17972,-17710,-17442,-17167,-16887,-16603,-16318,-16034,-15755,-15481,
+        -15212,-14949,-14688,-14427,-14164,-13897,-13625,-13349,-13068,-12786,-12505,-12225,
+        -11950,-11679,-11412,-11148,-10885,-10621,-10355,-10085, -9811, -9533, -9253, -8973,
+         -8694, -8417, -8144, -7875, -7609, -7344, -7080, -6814, -6546, -6273, -5998, -5719,
+         -5440, -5161, -4883, -4609, -4338, -4070, -3805, -3540, -3274, -3007, -2736, -2462,
+         -2185, -1906, -1627, -1349, -1074,  -801,  -532,  -265,     0,   265,   532,   801,
+          1074,  1349,  1627,  1906,  2185,  2462,  2736,  3007,  3274,  3540,  3805,  4070,
+          4338,  4609,  4883,  5161,  5440,  5719,  5998,  6273,  6546,  6814,  7080,  7344,
+          7609,  7875,  8144,  8417,  8694,  8973,  9253,  9533,  9811, 10085, 10355, 10621,
+         10885, 11148, 11412, 11679, 11950, 12225, 12505, 12786, 13068, 13349, 13625, 13897,
+         14164, 14427, 14688, 14949, 15212, 15481, 15755, 16034, 16318, 16603, 16887, 17167,
+         17442, 17710, 17972, 18229, 18486, 18745, 19009, 19280, 19559, 19845, 20135, 20426,
+         20713, 20993, 21263, 21523, 21776, 22024, 22274, 22529, 22795, 23073, 23363, 23663,
+         23967, 24268, 24558, 24834, 25092, 25334, 25565, 25792, 26027, 26278, 26553, 26854,
+         27179, 27517, 27857, 28181, 28474, 28726, 28933, 29103, 29253, 29410, 29605, 29868,
+         30222, 30673, 31202, 31765, 32286, 32661, 32767, 32466, 31624, 30123, 27874, 24834,
+         21013, 16475, 11341,  5782,     0,
+    },
+    // Band 5: notes up to 2560Hz, 9 harmonics
+    {
+             0, -3157, -6279, -9331,-12280,-15096,-17751,-20221,-22487,-24533,-26349,-27927,
+        -29268,-30374,-31253,-31916,-32378,-32655,-32767,-32735,-32581,-32326,-31992,-31599,
+        -31167,-30711,-30247,-29788,-29344,-28921,-28525,-28159,-27823,-27516,-27235,-26976,
+        -26735,-26506,-26285,-26065,-25843,-25614,-25375,-25123,-24858,-24578,-24284,-23977,
+        -23659,-23332,-22999,-22663,-22326,-21991,-21661,-21337,-21021,-20713,-20414,-20124,
+        -19842,-19567,-19297,-19031,-18767,-18503,-18237,-17968,-17694,-17415,-17129,-16837,
+        -16539,-16235,-15926,-15614,-15299,-14983,-14667,-14352,-14041,-13733,-13430,-13132,
+        -12838,-12550,-12266,-11985,-11708,-11432,-11157,-10881,-10604,-10325,-10042, -9756,
+         -9465, -9170, -8871, -8568, -8262, -7954, -7645, -7335, -7025, -6718, -6412, -6110,
+         -5811, -5516, -5224, -4937, -4652, -4371, -4091, -3812, -3533, -3254, -2973, -2690,
+         -2404, -2114, -1821, -1524, -1224,  -921,  -615,  -308,     0,   308,   615,   921,
+          1224,  1524,  1821,  2114,  2404,  2690,  2973,  3254,  3533,  3812,  4091,  4371,
+          4652,  4937,  5224,  5516,  5811,  6110,  6412,  6718,  7025,  7335,  7645,  7954,
+          8262,  8568,  8871,  9170,  9465,  9756, 10042, 10325, 10604, 10881, 11157, 11432,
+         11708, 11985, 12266, 12550, 12838, 13132, 13430, 13733, 14041, 14352, 14667, 14983,
+         15299, 15614, 15926, 16235, 16539, 16837, 17129, 17415, 17694, 17968, 18237, 18503,
+         18767, 19031, 19297, 19567, 19842, 20124, 20414, 20713, 21021, 21337, 21661, 21991,
+         22326, 22663, 22999, 23332, 23659, 23977, 24284, 24578, 24858, 25123, 25375, 25614,
+         25843, 26065, 26285, 26506, 26735, 26976, 27235, 27516, 27823, 28159, 28525, 28921,
+         29344, 29788, 30247, 30711, 31167, 31599, 31992, 32326, 32581, 32735, 32767, 32655,
+         32378, 31916, 31253, 30374, 29268, 27927, 26349, 24533, 22487, 20221, 17751, 15096,
+         12280,  9331,  6279,  3157,     0,
+    },
+    // Band 6: notes up to 5120Hz, 4 harmonics
+    {
+             0, -1685, -3365, -5034, -6689, -8323, -9932,-11512,-13058,-14564,-16029,-17446,
+        -18814,-20128,-21385,-22584,-23720,-24792,-25798,-26737,-27608,-28409,-29140,-29802,
+        -30394,-30917,-31372,-31759,-32080,-32338,-32533,-32668,-32745,-32767,-32736,-32656,
+        -32529,-32359,-32148,-31899,-31617,-31304,-30963,-30598,-30211,-29807,-29387,-28954,
+        -28512,-28063,-27609,-27152,-26695,-26240,-25788,-25340,-24899,-24464,-24038,-23621,
+        -23213,-22815,-22427,-22049,-21682,-21324,-20976,-20636,-20305,-19982,-19666,-19356,
+        -19051,-18751,-18454,-18159,-17867,-17575,-17283,-16989,-16694,-16397,-16096,-15792,
+        -15483,-15169,-14850,-14526,-14196,-13860,-13519,-13172,-12819,-12461,-12098,-11731,
+        -11359,-10984,-10606,-10224, -9841, -9457, -9071, -8685, -8300, -7916, -7533, -7152,
+         -6773, -6398, -6026, -5658, -5293, -4933, -4578, -4227, -3880, -3538, -3200, -2867,
+         -2537, -2211, -1889, -1569, -1252,  -937,  -624,  -312,     0,   312,   624,   937,
+          1252,  1569,  1889,  2211,  2537,  2867,  3200,  3538,  3880,  4227,  4578,  4933,
+          5293,  5658,  6026,  6398,  6773,  7152,  7533,  7916,  8300,  8685,  9071,  9457,
+          9841, 10224, 10606, 10984, 11359, 11731, 12098, 12461, 12819, 13172, 13519, 13860,
+         14196, 14526, 14850, 15169, 15483, 15792, 16096, 16397, 16694, 16989, 17283, 17575,
+         17867, 18159, 18454, 18751, 19051, 19356, 19666, 19982, 20305, 20636, 20976, 21324,
+         21682, 22049, 22427, 22815, 23213, 23621, 24038, 24464, 24899, 25340, 25788, 26240,
+         26695, 27152, 27609, 28063, 28512, 28954, 29387, 29807, 30211, 30598, 30963, 31304,
+         31617, 31899, 32148, 32359, 32529, 32656, 32736, 32767, 32745, 32668, 32533, 32338,
+         32080, 31759, 31372, 30917, 30394, 29802, 29140, 28409, 27608, 26737, 25798, 24792,
+         23720, 22584, 21385, 20128, 18814, 17446, 16029, 14564, 13058, 11512,  9932,  8323,
+          6689,  5034,  3365,  1685,     0,
+    },
+    // Band 7: notes up to 10240Hz, 2 harmonics
+    {
+             0, -1096, -2190, -3281, -4369, -5452, -6527, -7595, -8654, -9703,-10740,-11764,
+        -12774,-13769,-14748,-15709,-16652,-17575,-18478,-19359,-20218,-21053,-21864,-22650,
+        -23411,-24145,-24851,-25530,-26180,-26802,-27394,-27956,-28488,-28989,-29459,-29898,
+        -30306,-30683,-31028,-31341,-31623,-31873,-32092,-32280,-32437,-32563,-32659,-32724,
+        -32760,-32767,-32745,-32695,-32617,-32512,-32380,-32223,-32040,-31833,-31602,-31348,
+        -31073,-30775,-30458,-30120,-29764,-29390,-28999,-28592,-28169,-27732,-27282,-26819,
+        -26345,-25860,-25365,-24861,-24349,-23829,-23304,-22773,-22237,-21697,-21155,-20609,
+        -20063,-19515,-18967,-18420,-17873,-17329,-16786,-16247,-15710,-15177,-14649,-14125,
+        -13605,-13092,-12583,-12081,-11584,-11094,-10610,-10132, -9662, -9197, -8739, -8288,
+         -7844, -7406, -6974, -6548, -6129, -5715, -5307, -4904, -4506, -4113, -3724, -3340,
+         -2959, -2582, -2207, -1835, -1466, -1098,  -731,  -365,     0,   365,   731,  1098,
+          1466,  1835,  2207,  2582,  2959,  3340,  3724,  4113,  4506,  4904,  5307,  5715,
+          6129,  6548,  6974,  7406,  7844,  8288,  8739,  9197,  9662, 10132, 10610, 11094,
+         11584, 12081, 12583, 13092, 13605, 14125, 14649, 15177, 15710, 16247, 16786, 17329,
+         17873, 18420, 18967, 19515, 20063, 20609, 21155, 21697, 22237, 22773, 23304, 23829,
+         24349, 24861, 25365, 25860, 26345, 26819, 27282, 27732, 28169, 28592, 28999, 29390,
+         29764, 30120, 30458, 30775, 31073, 31348, 31602, 31833, 32040, 32223, 32380, 32512,
+         32617, 32695, 32745, 32767, 32760, 32724, 32659, 32563, 32437, 32280, 32092, 31873,
+         31623, 31341, 31028, 30683, 30306, 29898, 29459, 28989, 28488, 27956, 27394, 26802,
+         26180, 25530, 24851, 24145, 23411, 22650, 21864, 21053, 20218, 19359, 18478, 17575,
+         16652, 15709, 14748, 13769, 12774, 11764, 10740,  9703,  8654,  7595,  6527,  5452,
+          4369,  3281,  2190,  1096,     0,
+    },
+    // Band 8: notes up to 20480Hz, 1 harmonics
+    {
+             0,  -804, -1608, -2410, -3212, -4011, -4808, -5602, -6393, -7179, -7962, -8739,
+         -9512,-10278,-11039,-11793,-12539,-13279,-14010,-14732,-15446,-16151,-16846,-17530,
+        -18204,-18868,-19519,-20159,-20787,-21403,-22005,-22594,-23170,-23731,-24279,-24811,
+        -25329,-25832,-26319,-26790,-27245,-27683,-28105,-28510,-28898,-29268,-29621,-29956,
+        -30273,-30571,-30852,-31113,-31356,-31580,-31785,-31971,-32137,-32285,-32412,-32521,
+        -32609,-32678,-32728,-32757,-32767,-32757,-32728,-32678,-32609,-32521,-32412,-32285,
+        -32137,-31971,-31785,-31580,-31356,-31113,-30852,-30571,-30273,-29956,-29621,-29268,
+        -28898,-28510,-28105,-27683,-27245,-26790,-26319,-25832,-25329,-24811,-24279,-23731,
+        -23170,-22594,-22005,-21403,-20787,-20159,-19519,-18868,-18204,-17530,-16846,-16151,
+        -15446,-14732,-14010,-13279,-12539,-11793,-11039,-10278, -9512, -8739, -7962, -7179,
+         -6393, -5602, -4808, -4011, -3212, -2410, -1608,  -804,     0,   804,  1608,  2410,
+          3212,  4011,  4808,  5602,  6393,  7179,  7962,  8739,  9512, 10278, 11039, 11793,
+         12539, 13279, 14010, 14732, 15446, 16151, 16846, 17530, 18204, 18868, 19519, 20159,
+         20787, 21403, 22005, 22594, 23170, 23731, 24279, 24811, 25329, 25832, 26319, 26790,
+         27245, 27683, 28105, 28510, 28898, 29268, 29621, 29956, 30273, 30571, 30852, 31113,
+         31356, 31580, 31785, 31971, 32137, 32285, 32412, 32521, 32609, 32678, 32728, 32757,
+         32767, 32757, 32728, 32678, 32609, 32521, 32412, 32285, 32137, 31971, 31785, 31580,
+         31356, 31113, 30852, 30571, 30273, 29956, 29621, 29268, 28898, 28510, 28105, 27683,
+         27245, 26790, 26319, 25832, 25329, 24811, 24279, 23731, 23170, 22594, 22005, 21403,
+         20787, 20159, 19519, 18868, 18204, 17530, 16846, 16151, 15446, 14732, 14010, 13279,
+         12539, 11793, 11039, 10278,  9512,  8739,  7962,  7179,  6393,  5602,  4808,  4011,
+          3212,  2410,  1608,   804,     0,
+    },
+};
+
+#endif /* CODE_EXAMPLE_47_WAVETABLES_H */
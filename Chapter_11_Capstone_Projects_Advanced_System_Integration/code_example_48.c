@@ -23,9 +23,270 @@
  * 4. Build and flash to your development board
  */
 
-#define CONTROL_FREQUENCY 10000  // 10kHz control loop
-#define PWM_FREQUENCY 20000      // 20kHz PWM switching
+#ifndef PWM_FREQUENCY
+#define PWM_FREQUENCY 20000      // 20kHz PWM switching = current loop rate
+#endif
+
+// Axes driven by this MCU. Every axis's current loop runs in one interrupt,
+// batched over per-axis state kept as structure-of-arrays (foc_batch_t).
+#ifndef MOTOR_AXIS_COUNT
+#define MOTOR_AXIS_COUNT 4
+#endif
+
+// Multi-rate schedule: outer loops run every N current-loop ticks. Divisors
+// must be powers of two; phases are assigned at startup so outer tasks
+// never share a tick.
+#define VELOCITY_LOOP_DIVISOR 2      // 10kHz
+#define POSITION_LOOP_DIVISOR 8      // 2.5kHz, with feedforward
+#define SUPERVISOR_DIVISOR 16        // 1.25kHz safety checks
+#define CONTROL_FREQUENCY (PWM_FREQUENCY / VELOCITY_LOOP_DIVISOR)
+#define POSITION_LOOP_FREQUENCY (PWM_FREQUENCY / POSITION_LOOP_DIVISOR)
+#define SCHEDULE_MAX_PERIOD 64       // Largest divisor allowed
 #define ENCODER_PPR 4096         // Pulses per revolution
+#define ENCODER_COUNTS_PER_REV (4 * ENCODER_PPR)  // Quadrature counts
+#define ENCODER_PLL_BANDWIDTH_HZ 400.0f   // Velocity observer natural frequency
+#define MOTOR_POLE_PAIRS 4
+
+// Angles are unsigned 32-bit fractions of a turn (2^32 = 360 degrees), so
+// they wrap for free. With a power-of-two count per revolution the
+// encoder-to-angle conversion is exact.
+#define ENCODER_ANGLE_SCALE ((uint32_t)(4294967296ull / ENCODER_COUNTS_PER_REV))
+#define ANGLE_QUARTER_TURN 0x40000000u
+
+// Quarter-wave sine table: 256 steps over 0-90 degrees plus guard entries
+#define TRIG_QUARTER_BITS 8
+#define TRIG_QUARTER_SIZE (1 << TRIG_QUARTER_BITS)
+#define TRIG_INDEX_SHIFT (30 - TRIG_QUARTER_BITS)
+
+// Cycle counter for control-loop timing (TSC ticks or ns on the host build)
+#ifdef HOST_BUILD
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define control_cycle_count() ((uint32_t)__rdtsc())
+#else
+#include <time.h>
+static inline uint32_t control_cycle_count(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)(ts.tv_sec * 1000000000ull + ts.tv_nsec);
+}
+#endif
+#else
+#define control_cycle_count() (DWT->CYCCNT)
+#endif
+
+// Barrier between writing a queue slot and publishing its index
+#ifdef HOST_BUILD
+#define control_memory_barrier() __atomic_thread_fence(__ATOMIC_SEQ_CST)
+#else
+#define control_memory_barrier() __DMB()
+#endif
+
+#define FOC_VOLTAGE_LIMIT 0.57735027f // SVPWM linear range as a fraction of Vdc (1/sqrt(3))
+
+// Motor and power stage, used to tune the current loop
+#define MOTOR_RS 0.5f               // Phase resistance (ohm)
+#define MOTOR_LS 0.0005f            // Phase inductance (H)
+#define DC_BUS_VOLTAGE 24.0f        // (V)
+#define CURRENT_LOOP_BANDWIDTH_HZ 1000.0f
+
+// Mechanics, used to turn the trajectory's acceleration into a current
+// feedforward
+#define MOTOR_TORQUE_CONSTANT 0.048f   // Nm/A (1.5 * pole pairs * flux linkage)
+#define MOTOR_INERTIA 0.00005f         // Rotor plus load (kg m^2)
+#define MOTOR_FLUX_LINKAGE (MOTOR_TORQUE_CONSTANT / (1.5f * MOTOR_POLE_PAIRS))  // Magnet (Wb)
+
+// Sensorless rotor angle: flux observer and PLL, run beside every current loop
+#define OBSERVER_FLUX_SHIFT 24               // Flux is Q24 of MOTOR_FLUX_LINKAGE
+#define OBSERVER_FLUX_ONE (1 << OBSERVER_FLUX_SHIFT)
+#define OBSERVER_GAIN 1000.0f               // Pull of the flux onto the magnet circle (1/s)
+#define OBSERVER_PLL_BANDWIDTH_HZ 150.0f
+#define OBSERVER_LOCK_RPM 150.0f             // Estimate used above this speed...
+#define OBSERVER_UNLOCK_RPM 75.0f            // ...until it falls below this one
+
+// Trajectory generator: jerk-limited (S-curve) rest-to-rest moves
+#define TRAJECTORY_QUEUE_DEPTH 8       // Planned moves waiting; power of two
+#define TRAJECTORY_SEGMENTS 7          // Jerk, hold, jerk / cruise / jerk, hold, jerk
+
+// Fast fault protection. On each axis an overcurrent comparator drives the
+// PWM timer's break input (BKIN), which forces that axis's outputs off in
+// hardware; the ADC analog watchdog checks every phase-current sample and
+// trips from its interrupt. Slower limits are checked by the supervisor task
+// and the main loop.
+#define OVERCURRENT_TRIP_AMPS 7.0f      // Analog watchdog window, either phase
+#define BREAK_TRIP_AMPS 8.0f            // Comparator reference on BKIN (hardware)
+#define TRIP_ALL_AXES 0xFFu             // Trip axis when the source cannot tell
+#define PWM_TIMER_CLOCK 168000000       // PWM timer kernel clock, for trip latency
+#define PWM_DEAD_TIME_TICKS 84          // 500ns; shares BDTR with the break setup
+#define THERMAL_CHECK_PERIOD_MS 100
+
+// Fault black box: a snapshot of every axis each velocity-loop tick in a RAM
+// ring, frozen a few snapshots after the first trip, then copied for the
+// tripped axis into backup SRAM, which keeps it through reset
+#define BLACKBOX_DEPTH 256              // Snapshots per axis (power of two), 25.6ms at 10kHz
+#define BLACKBOX_DIVISOR VELOCITY_LOOP_DIVISOR
+#define BLACKBOX_POST_TRIP 32           // Snapshots kept after the trip
+#define BLACKBOX_BACKUP_BYTES 4096      // Backup SRAM (BKPSRAM) size
+#define BLACKBOX_MAGIC 0x424B5831u      // "BKX1"
+
+// Telemetry ("scope mode"): selected signals captured into a RAM ring from
+// the current-loop interrupt, frozen around a trigger, then streamed out
+// over UART DMA from the main loop
+#define TELEMETRY_BUFFER_WORDS 8192      // int16 ring shared by all channels (16KB)
+#define TELEMETRY_MAX_CHANNELS 8
+#define TELEMETRY_FRAME_PAYLOAD 240
+#define TELEMETRY_BAUD_RATE 2000000
+#define TELEMETRY_SYNC_0 0xA5
+#define TELEMETRY_SYNC_1 0x5A
+
+// Low-side shunt current sense: 12-bit ADC, 3.3V, 10mohm shunt, gain 20
+#define ADC_CURRENT_OFFSET 2048     // Zero-current reading (mid-rail bias)
+#define CURRENT_AMPS_PER_COUNT (3.3f / 4096.0f / (0.01f * 20.0f))
+
+// Current samples arrive by DMA, a phase A/B pair per axis in axis order.
+// Consumed samples are overwritten with a value the 12-bit ADC never
+// produces, so the loop can tell when each pair has landed.
+#define ADC_SAMPLE_PENDING 0xFFFFu
+#define ADC_SAMPLE_WAIT_LIMIT 1000   // Polls before an axis is skipped (far beyond the scan time)
+
+// Q31 PID gains are Q8.24 (range +/-128)
+#define PID_GAIN_SHIFT 24
+
+// Fixed-rate PID. pid_configure folds the sample time into the gains, so
+// pid_compute is multiply-adds only. Integral and derivative are kept in
+// output units; the derivative is filtered, Kd*s / (1 + s*Tf), discretized
+// by backward Euler.
+typedef struct {
+    // Coefficients
+    float kp;
+    float ki_ts;                 // Ki * Ts
+    float kaw_ts;                // Back-calculation gain * Ts
+    float kd_a;                  // Derivative filter pole: Tf / (Tf + Ts)
+    float kd_b;                  // Kd / (Tf + Ts)
+    float out_min, out_max;
+    
+    // State
+    float integral;
+    float derivative;
+    float last_error;
+} pid_controller_t;
+
+// Q31 variant: error, output and state are Q31 fractions of full scale
+typedef struct {
+    int32_t kp, ki_ts, kaw_ts, kd_b;  // Q8.24
+    int32_t kd_a;                     // Q31
+    int32_t out_min, out_max;
+    
+    int32_t integral;
+    int32_t derivative;
+    int32_t last_error;
+} pid_q31_t;
+
+// Encoder: the 16-bit hardware counter extended to 64 bits, plus a
+// tracking-loop (type-2 PLL) observer that locks an estimated position onto
+// the count. The observer's integrator is the velocity estimate; it moves a
+// little every tick instead of in whole counts, so it stays smooth at low
+// speed without the lag of a heavy low-pass filter.
+typedef struct {
+    uint16_t last_hw;            // Counter value at the last extension
+    int64_t count;               // Extended count
+    int64_t position_est;        // Observer position (counts, Q16)
+    float velocity_est;          // Observer velocity (counts/s)
+    float kp, ki_ts;             // Observer gains, Ts folded into ki
+    float ts_q16;                // Ts * 2^16, advances position_est
+} encoder_state_t;
+
+// One planned move: the state at the start of each segment and the jerk
+// held through it. Everything the control loop needs is worked out when the
+// move is queued, so each tick is a short polynomial in time.
+typedef struct {
+    float duration[TRAJECTORY_SEGMENTS];   // (s)
+    float jerk[TRAJECTORY_SEGMENTS];       // (deg/s^3)
+    float p0[TRAJECTORY_SEGMENTS];         // (deg)
+    float v0[TRAJECTORY_SEGMENTS];         // (deg/s)
+    float a0[TRAJECTORY_SEGMENTS];         // (deg/s^2)
+    float target;                          // Exact end position (deg)
+} trajectory_plan_t;
+
+// Per-axis trajectory generator. Moves are planned into the queue by
+// trajectory_queue_move (main loop) and played back by the position loop;
+// head and tail each have a single writer, so no lock is needed.
+typedef struct {
+    trajectory_plan_t queue[TRAJECTORY_QUEUE_DEPTH];
+    volatile uint32_t head;      // Next free slot (trajectory_queue_move)
+    volatile uint32_t tail;      // Move being played (trajectory_update)
+    float last_target;           // Where the last queued move ends; the next starts there
+    float ts;                    // Update period (s)
+    
+    // Playback
+    bool engaged;                // Has driven the setpoint since trajectory_init
+    bool active;                 // A move is in progress
+    uint32_t segment;
+    float t;                     // Time into the segment (s)
+    
+    // Reference for this tick
+    float position;              // (deg)
+    float velocity;              // (deg/s)
+    float acceleration;          // (deg/s^2)
+} trajectory_t;
+
+// Field-oriented current loops of every axis (rotor d/q frame), run in the
+// PWM interrupt at PWM_FREQUENCY. Structure-of-arrays: each signal is an
+// array indexed by axis, so the batched loop walks the same few arrays for
+// every axis instead of striding through whole per-axis structs.
+typedef struct {
+    float id_ref[MOTOR_AXIS_COUNT];      // Current references (A); iq_ref from the velocity loop
+    float iq_ref[MOTOR_AXIS_COUNT];
+    float id[MOTOR_AXIS_COUNT];          // Measured d/q currents (A)
+    float iq[MOTOR_AXIS_COUNT];
+    float vd[MOTOR_AXIS_COUNT];          // Commanded d/q voltages (fraction of Vdc)
+    float vq[MOTOR_AXIS_COUNT];
+    float v_alpha[MOTOR_AXIS_COUNT];     // The same in the stationary frame, for the flux observer
+    float v_beta[MOTOR_AXIS_COUNT];
+    float id_integral[MOTOR_AXIS_COUNT]; // PI integrators (output units)
+    float iq_integral[MOTOR_AXIS_COUNT];
+    uint32_t theta[MOTOR_AXIS_COUNT];    // Electrical angle used this cycle
+    uint32_t sector[MOTOR_AXIS_COUNT];   // SVPWM sector 0-5
+    float duty[MOTOR_AXIS_COUNT][3];     // Phase A/B/C duties, one timer per axis
+    int32_t adc_offset[2][MOTOR_AXIS_COUNT];  // Zero-current readings, phases A and B
+    
+    // PI coefficients, shared by the d and q loops (see pid_configure)
+    float kp[MOTOR_AXIS_COUNT];
+    float ki_ts[MOTOR_AXIS_COUNT];
+    float kaw_ts[MOTOR_AXIS_COUNT];
+    
+    uint32_t sample_timeouts;            // Axes skipped because their samples never landed
+    uint32_t last_cycles;                // Whole batch, last and worst case
+    uint32_t worst_cycles;
+} foc_batch_t;
+
+// Sensorless rotor angle and speed of every axis, in fixed point. The
+// stator flux is integrated from the applied voltage less the resistive
+// drop; taking away the inductive part L*i leaves the magnet flux, whose
+// angle is the rotor's electrical angle. Integration error is removed by
+// pulling that flux back onto a circle of the known magnet flux (the
+// nonlinear observer of Ortega et al.), and a PLL locks onto it for a
+// clean angle and speed. Flux is Q24 of MOTOR_FLUX_LINKAGE, currents Q16
+// ADC counts, voltages Q31 fractions of Vdc, angles the same 32-bit turn as
+// the encoder's. Structure-of-arrays, like foc_batch_t.
+typedef struct {
+    int32_t flux_alpha[MOTOR_AXIS_COUNT];    // Stator flux (Q24)
+    int32_t flux_beta[MOTOR_AXIS_COUNT];
+    int32_t v_alpha[MOTOR_AXIS_COUNT];       // Command from two cycles back (Q31)
+    int32_t v_beta[MOTOR_AXIS_COUNT];
+    uint32_t theta[MOTOR_AXIS_COUNT];        // PLL angle predicted for the next sample
+    int32_t omega[MOTOR_AXIS_COUNT];         // PLL speed (angle per PWM period)
+    bool locked[MOTOR_AXIS_COUNT];           // Fast enough for the estimate to be used
+    
+    // Coefficients, set by flux_observer_configure
+    int32_t k_v[MOTOR_AXIS_COUNT];           // Flux per Vdc per period (Q0, products >> 31)
+    int32_t k_r[MOTOR_AXIS_COUNT];           // R*Ts, flux per count (Q16, products >> 32)
+    int32_t k_l[MOTOR_AXIS_COUNT];           // L, flux per count (Q16, products >> 32)
+    int32_t k_gamma[MOTOR_AXIS_COUNT];       // OBSERVER_GAIN * Ts (Q24)
+    int32_t pll_kp[MOTOR_AXIS_COUNT];        // Angle per unit error (products >> 24)
+    int32_t pll_ki[MOTOR_AXIS_COUNT];
+    int32_t lock_omega, unlock_omega;        // OBSERVER_LOCK_RPM, OBSERVER_UNLOCK_RPM
+} flux_observer_t;
 
 // Control system state
 typedef struct {
@@ -35,7 +296,7 @@ typedef struct {
     float current_setpoint;
     
     // Feedback
-    int32_t encoder_count;
+    encoder_state_t encoder;
     float position;
     float velocity;
     float current;
@@ -43,12 +304,15 @@ typedef struct {
     // Control outputs
     float position_output;
     float velocity_output;
-    float pwm_duty[3];  // 3-phase PWM
+    float current_feedforward;   // Trajectory acceleration as torque current (A)
     
     // Control parameters
     pid_controller_t position_pid;
     pid_controller_t velocity_pid;
-    pid_controller_t current_pid;
+    trajectory_t trajectory;     // Source of position_setpoint in position control
+    uint32_t axis;               // Index into the current-loop arrays (foc_batch_t)
+    bool sensorless;             // Current-loop angle and velocity from the flux observer
+                                 // while it is locked; the encoder below that speed
     
     // Safety limits
     float max_velocity;
@@ -61,202 +325,2235 @@ typedef struct {
     fault_flags_t faults;
 } motor_control_t;
 
-static motor_control_t motor;
+// Outer-loop task run from the current-loop interrupt every divisor ticks
+typedef struct {
+    void (*run)(motor_control_t* ctrl);
+    uint16_t divisor;
+    uint16_t phase;              // Tick within the period, set by control_schedule_init
+    uint16_t axis;
+    uint32_t worst_cycles;
+} control_task_t;
+
+// Signals the telemetry can capture
+typedef enum {
+    TELEM_POSITION_SETPOINT,
+    TELEM_POSITION,
+    TELEM_VELOCITY_SETPOINT,
+    TELEM_VELOCITY,
+    TELEM_IQ_REF,
+    TELEM_IQ,
+    TELEM_ID,
+    TELEM_VD,
+    TELEM_VQ,
+    TELEM_POSITION_INTEGRAL,     // PID integrator states
+    TELEM_VELOCITY_INTEGRAL,
+    TELEM_IQ_INTEGRAL,
+    TELEM_DUTY_A,
+    TELEM_DUTY_B,
+    TELEM_DUTY_C,
+    TELEM_CHANNEL_COUNT
+} telemetry_channel_t;
+
+typedef enum {
+    TELEMETRY_IDLE,
+    TELEMETRY_ARMED,             // Filling pre-trigger history, then watching
+    TELEMETRY_TRIGGERED,         // Filling post-trigger samples
+    TELEMETRY_COMPLETE           // Ring frozen, streaming out
+} telemetry_state_t;
+
+typedef enum {
+    TELEMETRY_EDGE_RISING,
+    TELEMETRY_EDGE_FALLING,
+    TELEMETRY_EDGE_EITHER
+} telemetry_edge_t;
+
+typedef enum {
+    TELEMETRY_FRAME_HEADER = 1,  // Capture description, sent first
+    TELEMETRY_FRAME_DATA = 2     // Whole samples, channels interleaved
+} telemetry_frame_type_t;
+
+typedef struct {
+    volatile telemetry_state_t state;
+    
+    // Capture set, resolved to pointers and int16 scales by telemetry_configure
+    const float* source[TELEMETRY_MAX_CHANNELS];
+    float scale[TELEMETRY_MAX_CHANNELS];
+    uint8_t channel[TELEMETRY_MAX_CHANNELS];
+    uint32_t channel_count;
+    uint32_t divisor;            // Capture every divisor current-loop ticks
+    uint32_t depth;              // Samples in the ring
+    uint32_t ring_words;         // depth * channel_count
+    
+    // Capture progress (interrupt side)
+    uint32_t decimate_count;
+    uint32_t write_index;
+    uint32_t pre_samples;
+    uint32_t pre_filled;
+    uint32_t post_remaining;
+    const float* trigger_source;
+    float trigger_level;
+    float trigger_prev;
+    telemetry_edge_t trigger_edge;
+    volatile bool force_trigger;
+    uint32_t axis;               // Axis every channel and the trigger are taken from
+    
+    // Streaming progress (main loop side)
+    uint32_t stream_index;       // Next sample to send; depth + 1 before the header
+    uint8_t sequence;
+    volatile bool tx_busy;
+} telemetry_t;
+
+typedef enum {
+    TRIP_NONE,
+    TRIP_BREAK_INPUT,            // Hardware comparator, outputs cut by the axis timer
+    TRIP_ANALOG_WATCHDOG,        // Current sample outside the ADC window
+    TRIP_SUPERVISOR,             // Speed, position or current limit in software
+    TRIP_THERMAL
+} trip_source_t;
+
+typedef struct {
+    trip_source_t source;        // First trip since start
+    uint32_t axis;               // Its axis, or TRIP_ALL_AXES
+    uint32_t count;
+    uint32_t latency_ticks;      // Watchdog path: PWM timer ticks from sample to outputs off
+} fault_trip_t;
+
+// One axis at one instant, in fixed point (16 bytes)
+typedef struct {
+    uint16_t tick;               // Control tick, low 16 bits
+    uint8_t state;               // motor_state_t
+    uint8_t faults;              // fault_flags_t: overcurrent, overspeed, position, thermal (bits 0-3)
+    int16_t position;            // 0.01 deg
+    int16_t velocity_setpoint;   // 0.1 rpm
+    int16_t velocity;            // 0.1 rpm
+    int16_t iq_ref;              // mA
+    int16_t iq;                  // mA
+    int16_t id;                  // mA
+} blackbox_record_t;
+
+typedef enum {
+    BLACKBOX_RECORDING,
+    BLACKBOX_TRIPPED,            // Recording the last BLACKBOX_POST_TRIP snapshots
+    BLACKBOX_FROZEN,             // Waiting for the main loop to save it
+    BLACKBOX_SAVED
+} blackbox_state_t;
+
+typedef struct {
+    volatile blackbox_state_t state;
+    uint32_t decimate_count;
+    uint32_t write_index;        // Next slot in every axis's ring
+    uint32_t recorded;           // Snapshots since start, saturating at BLACKBOX_DEPTH
+    uint32_t post_remaining;
+} blackbox_t;
+
+// Saved image at the start of backup SRAM, followed by the records oldest first
+typedef struct {
+    uint32_t magic;
+    uint8_t source;              // trip_source_t
+    uint8_t axis;                // Tripped axis, TRIP_ALL_AXES if unknown (records: axis 0)
+    uint16_t record_count;
+    uint16_t trip_record;        // First record taken after the trip
+    uint16_t reserved;
+    uint32_t checksum;           // Fletcher-32 over header (checksum 0) and records
+} blackbox_header_t;
+
+#define BLACKBOX_SAVED_DEPTH ((BLACKBOX_BACKUP_BYTES - sizeof(blackbox_header_t)) / \
+                              sizeof(blackbox_record_t))
+
+static motor_control_t motors[MOTOR_AXIS_COUNT];
+static foc_batch_t foc_axes;
+static flux_observer_t flux_observers;
+static volatile uint16_t current_samples[2 * MOTOR_AXIS_COUNT];   // ADC DMA target
 static volatile bool control_update_flag = false;
+static fault_trip_t motor_trip;
+static uint16_t current_window_low, current_window_high;   // Analog watchdog thresholds
+
+static blackbox_t blackbox;
+static blackbox_record_t blackbox_ring[MOTOR_AXIS_COUNT][BLACKBOX_DEPTH];
+
+static telemetry_t telemetry;
+static int16_t telemetry_buffer[TELEMETRY_BUFFER_WORDS];
+static uint8_t telemetry_frame[8 + TELEMETRY_FRAME_PAYLOAD];
+
+// Where each channel lives on axis 0, the distance to the same signal on
+// the next axis, and the value that maps to int16 full scale
+typedef struct {
+    const float* axis0;
+    uint16_t stride;             // Bytes
+} telemetry_source_t;
+
+static const telemetry_source_t telemetry_sources[TELEM_CHANNEL_COUNT] = {
+    { &motors[0].position_setpoint, sizeof(motor_control_t) },
+    { &motors[0].position, sizeof(motor_control_t) },
+    { &motors[0].velocity_setpoint, sizeof(motor_control_t) },
+    { &motors[0].velocity, sizeof(motor_control_t) },
+    { &foc_axes.iq_ref[0], sizeof(float) },
+    { &foc_axes.iq[0], sizeof(float) },
+    { &foc_axes.id[0], sizeof(float) },
+    { &foc_axes.vd[0], sizeof(float) },
+    { &foc_axes.vq[0], sizeof(float) },
+    { &motors[0].position_pid.integral, sizeof(motor_control_t) },
+    { &motors[0].velocity_pid.integral, sizeof(motor_control_t) },
+    { &foc_axes.iq_integral[0], sizeof(float) },
+    { &foc_axes.duty[0][0], sizeof(foc_axes.duty[0]) },
+    { &foc_axes.duty[0][1], sizeof(foc_axes.duty[0]) },
+    { &foc_axes.duty[0][2], sizeof(foc_axes.duty[0]) },
+};
+static const float telemetry_full_scale[TELEM_CHANNEL_COUNT] = {
+    360.0f, 360.0f,              // Degrees
+    2000.0f, 2000.0f,            // RPM
+    10.0f, 10.0f, 10.0f,         // Amperes
+    1.0f, 1.0f,                  // Fraction of Vdc
+    2000.0f, 10.0f, 1.0f,
+    1.0f, 1.0f, 1.0f,
+};
+
+void velocity_loop_task(motor_control_t* ctrl);
+void position_loop_task(motor_control_t* ctrl);
+void supervisor_task(motor_control_t* ctrl);
+static void motor_trip_fault(uint32_t axis, trip_source_t source);
+
+// Fastest first: control_schedule_init makes one task of each type per axis
+// and places them in this order
+static const control_task_t control_task_types[] = {
+    { velocity_loop_task, VELOCITY_LOOP_DIVISOR, 0, 0, 0 },
+    { position_loop_task, POSITION_LOOP_DIVISOR, 0, 0, 0 },
+    { supervisor_task, SUPERVISOR_DIVISOR, 0, 0, 0 },
+};
+#define CONTROL_TASK_TYPES (sizeof(control_task_types) / sizeof(control_task_types[0]))
+#define CONTROL_TASK_COUNT (CONTROL_TASK_TYPES * MOTOR_AXIS_COUNT)
+static control_task_t control_tasks[CONTROL_TASK_COUNT];
+
+static uint32_t control_tick = 0;
+static uint32_t control_tick_worst_cycles = 0;   // Whole ISR: current loop + task
+
+// sin(0..90 degrees) with a guard entry on each side of 90 for interpolation
+static float trig_quarter_table[TRIG_QUARTER_SIZE + 2];
+static int16_t trig_quarter_q15[TRIG_QUARTER_SIZE + 2];   // The same in Q15
+
+uint32_t control_schedule_init(void);
+static void control_scheduler_tick(void);
+void pid_configure(pid_controller_t* pid, float kp, float ki, float kd, float tf,
+                   float rate_hz, float out_min, float out_max);
+float pid_compute(pid_controller_t* pid, float error);
+float pid_compute_ff(pid_controller_t* pid, float error, float feedforward);
+bool check_safety_limits(motor_control_t* ctrl);
+void pid_reset(pid_controller_t* pid);
+void fast_trig_init(void);
+void space_vector_modulation(float voltage_magnitude, uint32_t angle, float* duties);
+uint32_t svpwm_duties(float v_alpha, float v_beta, float* duties);
+void foc_configure(foc_batch_t* foc, uint32_t axis);
+void foc_current_loop_batch(foc_batch_t* foc, uint32_t axis_count);
+void flux_observer_configure(flux_observer_t* obs, uint32_t axis);
+float flux_observer_velocity(const flux_observer_t* obs, uint32_t axis);
+void encoder_configure(encoder_state_t* enc, float bandwidth_hz, float rate_hz, uint16_t hw);
+HAL_StatusTypeDef telemetry_configure(const telemetry_channel_t* channels, uint32_t count,
+                                      uint32_t divisor, uint32_t axis);
+static void telemetry_capture(void);
+static void blackbox_record(void);
+void blackbox_init(void);
+void configure_fault_protection(void);
+float encoder_observer_update(encoder_state_t* enc);
+void trajectory_init(trajectory_t* traj, float position, float rate_hz);
+bool trajectory_update(trajectory_t* traj);
 
 /**
  * @brief Initialize comprehensive motor control system
  */
 HAL_StatusTypeDef init_motor_control_system(void) {
-    // Initialize encoder interface (Timer in encoder mode)
+    // Build the sine table before the control loop can run
+    fast_trig_init();
+    
+    // Initialize encoder interfaces (one timer in encoder mode per axis)
     configure_encoder_interface(ENCODER_PPR);
     
-    // Initialize 3-phase PWM generation
+    // Initialize 3-phase PWM generation: one timer per axis, all
+    // synchronised to the master timer htim_pwm[0] (TIM8)
     configure_3phase_pwm(PWM_FREQUENCY);
     
-    // Initialize control loop timer
-    configure_control_timer(CONTROL_FREQUENCY);
+    memset(&foc_axes, 0, sizeof(foc_axes));
+    for (uint32_t k = 0; k < MOTOR_AXIS_COUNT; k++) {
+        motor_control_t* ctrl = &motors[k];
+        ctrl->axis = k;
+        
+        // Position counts from here; the observer runs in the velocity loop
+        encoder_configure(&ctrl->encoder, ENCODER_PLL_BANDWIDTH_HZ, CONTROL_FREQUENCY,
+                          (uint16_t)__HAL_TIM_GET_COUNTER(&htim_encoder[k]));
+        ctrl->velocity = 0.0f;
+        
+        // Set initial safety limits
+        ctrl->max_velocity = 1000.0f;  // RPM
+        ctrl->max_current = 5.0f;      // Amperes
+        ctrl->position_limit_min = -180.0f;  // Degrees
+        ctrl->position_limit_max = 180.0f;
+        
+        // Initialize PID controllers at their loop rates. Each output is
+        // clamped to 80% of the next loop's trip limit, so ripple on a
+        // saturated loop does not trip the safety checks. Both loops are PI,
+        // tuned on code_example_48_host_sim.c (velocity about 50Hz, position
+        // about 10Hz): one encoder count is a 37rpm velocity step, so
+        // derivative terms only turn quantisation into current noise and kick
+        // on setpoint steps.
+        pid_configure(&ctrl->position_pid, 10.0f, 0.1f, 0.0f, 4.0f / POSITION_LOOP_FREQUENCY,
+                      POSITION_LOOP_FREQUENCY, -0.8f * ctrl->max_velocity,
+                      0.8f * ctrl->max_velocity);
+        pid_configure(&ctrl->velocity_pid, 0.035f, 1.4f, 0.0f, 4.0f / CONTROL_FREQUENCY,
+                      CONTROL_FREQUENCY, -0.8f * ctrl->max_current, 0.8f * ctrl->max_current);
+        foc_configure(&foc_axes, k);
+        flux_observer_configure(&flux_observers, k);
+        trajectory_init(&ctrl->trajectory, 0.0f, POSITION_LOOP_FREQUENCY);
+    }
+    control_schedule_init();
     
-    // Initialize PID controllers
-    init_pid_controller(&motor.position_pid, 10.0f, 0.1f, 0.05f);
-    init_pid_controller(&motor.velocity_pid, 0.5f, 0.05f, 0.01f);
-    init_pid_controller(&motor.current_pid, 2.0f, 20.0f, 0.0f);
+    // Default scope set: the velocity loop of axis 0 at its own rate
+    static const telemetry_channel_t default_channels[] = {
+        TELEM_VELOCITY_SETPOINT, TELEM_VELOCITY, TELEM_IQ_REF, TELEM_IQ,
+    };
+    configure_telemetry_uart(TELEMETRY_BAUD_RATE);
+    telemetry.state = TELEMETRY_IDLE;
+    telemetry.tx_busy = false;
+    telemetry_configure(default_channels, 4, VELOCITY_LOOP_DIVISOR, 0);
     
-    // Set initial safety limits
-    motor.max_velocity = 1000.0f;  // RPM
-    motor.max_current = 5.0f;      // Amperes
-    motor.position_limit_min = -180.0f;  // Degrees
-    motor.position_limit_max = 180.0f;
+    // Phase A/B shunts of every axis on one regular scan, axis by axis,
+    // started by the master timer's OC4REF (on TRGO) at the PWM counter peak,
+    // where all low-side switches conduct. Circular DMA stores each sample
+    // as it converts.
+    for (uint32_t i = 0; i < 2 * MOTOR_AXIS_COUNT; i++) {
+        current_samples[i] = ADC_SAMPLE_PENDING;
+    }
+    configure_current_sense_adc(ADC_EXTERNALTRIGCONV_T8_TRGO);
+    configure_fault_protection();
+    blackbox_init();
+    HAL_ADC_Start_DMA(&hadc_current, (uint32_t*)current_samples, 2 * MOTOR_AXIS_COUNT);
     
-    // Start control system
-    HAL_TIM_Base_Start_IT(&htim_control);
-    motor.state = MOTOR_STATE_READY;
+    // The same compare event interrupts the CPU and drives every loop
+    HAL_TIM_OC_Start_IT(&htim_pwm[0], TIM_CHANNEL_4);
+    for (uint32_t k = 0; k < MOTOR_AXIS_COUNT; k++) {
+        motors[k].state = MOTOR_STATE_READY;
+    }
     
     return HAL_OK;
 }
 
 /**
- * @brief High-frequency control loop interrupt (10kHz)
+ * @brief Fold a 16-bit counter reading into the 64-bit count
+ * 
+ * The signed 16-bit difference is exact as long as the shaft moves less
+ * than 32768 counts (two turns) between calls.
  */
-void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef *htim) {
-    if (htim->Instance == TIM_CONTROL) {
-        // Read encoder position
-        int32_t encoder_raw = __HAL_TIM_GET_COUNTER(&htim_encoder);
-        motor.encoder_count = encoder_raw;
-        motor.position = (float)encoder_raw * 360.0f / (4 * ENCODER_PPR);
-        
-        // Estimate velocity using high-resolution differentiation
-        static int32_t last_encoder_count = 0;
-        static float velocity_filter_state = 0.0f;
-        
-        float velocity_raw = (float)(encoder_raw - last_encoder_count) * 
-                            CONTROL_FREQUENCY * 60.0f / (4 * ENCODER_PPR);
-        
-        // Apply low-pass filter to velocity estimate
-        const float velocity_filter_alpha = 0.1f;
-        velocity_filter_state = velocity_filter_alpha * velocity_raw + 
-                               (1.0f - velocity_filter_alpha) * velocity_filter_state;
-        motor.velocity = velocity_filter_state;
-        last_encoder_count = encoder_raw;
-        
-        // Read current feedback (ADC via DMA)
-        motor.current = read_motor_current();
-        
-        // Safety checks
-        if (check_safety_limits(&motor)) {
-            // Execute control loops
-            execute_cascaded_control(&motor);
-            
-            // Update PWM outputs
-            update_3phase_pwm(motor.pwm_duty);
-        } else {
-            // Safety violation - disable outputs
-            disable_motor_outputs();
-            motor.state = MOTOR_STATE_FAULT;
-        }
-        
-        control_update_flag = true;
+static inline int64_t encoder_extend(encoder_state_t* enc, uint16_t hw) {
+    enc->count += (int16_t)(hw - enc->last_hw);
+    enc->last_hw = hw;
+    return enc->count;
+}
+
+/**
+ * @brief Control interrupt: master PWM timer CC4 at the counter peak (PWM_FREQUENCY)
+ * 
+ * The same compare event starts the current-sense scan, so this runs while
+ * the first axis is still converting; foc_current_loop_batch takes each
+ * axis as its samples land. Samples are taken at the PWM centre, so they
+ * are free of switching noise. The new duties take effect at the next timer
+ * update (preload), one half-period later. After the current loops, the
+ * outer-loop tasks due on this tick run (see control_schedule_init), then
+ * telemetry and the black box take their snapshots.
+ */
+void HAL_TIM_OC_DelayElapsedCallback(TIM_HandleTypeDef* htim) {
+    if (htim != &htim_pwm[0] || htim->Channel != HAL_TIM_ACTIVE_CHANNEL_4) {
+        return;
+    }
+    uint32_t start = control_cycle_count();
+    
+    foc_current_loop_batch(&foc_axes, MOTOR_AXIS_COUNT);
+    
+    uint32_t cycles = control_cycle_count() - start;
+    foc_axes.last_cycles = cycles;
+    if (cycles > foc_axes.worst_cycles) {
+        foc_axes.worst_cycles = cycles;
+    }
+    
+    control_scheduler_tick();
+    telemetry_capture();
+    blackbox_record();
+    
+    cycles = control_cycle_count() - start;
+    if (cycles > control_tick_worst_cycles) {
+        control_tick_worst_cycles = cycles;
     }
 }
 
 /**
- * @brief Execute cascaded position/velocity/current control
+ * @brief Execution time of the current loops of all axes against their
+ *        budget (one PWM period)
+ * @param worst Worst case since start, including any wait for samples
+ * @return Budget in cycles at the current core clock
  */
-void execute_cascaded_control(motor_control_t* ctrl) {
-    // Position loop (outer loop)
-    if (ctrl->state == MOTOR_STATE_POSITION_CONTROL) {
-        float position_error = ctrl->position_setpoint - ctrl->position;
-        ctrl->velocity_setpoint = pid_compute(&ctrl->position_pid, position_error);
-        
-        // Velocity feedforward
-        ctrl->velocity_setpoint += get_velocity_feedforward(ctrl->position_setpoint);
+uint32_t foc_get_timing(uint32_t* last, uint32_t* worst) {
+    *last = foc_axes.last_cycles;
+    *worst = foc_axes.worst_cycles;
+    return SystemCoreClock / PWM_FREQUENCY;
+}
+
+/**
+ * @brief Reset the encoder count to zero and tune the velocity observer
+ * 
+ * Critically damped: Kp = 2*wn and Ki = wn^2. Higher bandwidth tracks
+ * speed changes faster but passes more count quantisation through.
+ * @param rate_hz Rate at which encoder_observer_update will be called
+ * @param hw Current hardware counter value
+ */
+void encoder_configure(encoder_state_t* enc, float bandwidth_hz, float rate_hz, uint16_t hw) {
+    float wn = 2.0f * (float)M_PI * bandwidth_hz;
+    float ts = 1.0f / rate_hz;
+    
+    enc->last_hw = hw;
+    enc->count = 0;
+    enc->position_est = 0;
+    enc->velocity_est = 0.0f;
+    enc->kp = 2.0f * wn;
+    enc->ki_ts = wn * wn * ts;
+    enc->ts_q16 = ts * 65536.0f;
+}
+
+/**
+ * @brief One observer step against the latest extended count
+ * 
+ * The error is formed in integer counts, so it is exact at any distance
+ * from zero; only the small difference is converted to float.
+ * @return Velocity estimate in counts per second
+ */
+float encoder_observer_update(encoder_state_t* enc) {
+    int64_t error_q16 = (enc->count << 16) - enc->position_est;
+    float error = (float)error_q16 * (1.0f / 65536.0f);
+    
+    enc->velocity_est += enc->ki_ts * error;
+    float slew = enc->velocity_est + enc->kp * error;
+    enc->position_est += (int64_t)lrintf(slew * enc->ts_q16);
+    
+    return enc->velocity_est;
+}
+
+/**
+ * @brief Start a trajectory generator at rest at a position
+ * @param rate_hz Rate at which trajectory_update will be called
+ */
+void trajectory_init(trajectory_t* traj, float position, float rate_hz) {
+    traj->head = 0;
+    traj->tail = 0;
+    traj->last_target = position;
+    traj->ts = 1.0f / rate_hz;
+    traj->engaged = false;
+    traj->active = false;
+    traj->position = position;
+    traj->velocity = 0.0f;
+    traj->acceleration = 0.0f;
+}
+
+/**
+ * @brief Plan a jerk-limited move from rest to rest
+ * 
+ * Seven segments: jerk up, constant acceleration, jerk down, cruise, then
+ * the mirror image. Short moves drop the cruise, then the constant
+ * acceleration, reaching a lower peak velocity or acceleration instead.
+ * The state at each segment boundary is integrated here once.
+ * @param vmax, amax, jmax Limits in deg/s, deg/s^2, deg/s^3 (all > 0)
+ */
+static void trajectory_plan(trajectory_plan_t* plan, float start, float target,
+                            float vmax, float amax, float jmax) {
+    float distance = fabsf(target - start);
+    float dir = (target >= start) ? 1.0f : -1.0f;
+    float tj, tc, tv, v;
+    
+    // Reach vmax with peak acceleration amax, or less if vmax comes first
+    if (vmax * jmax >= amax * amax) {
+        tj = amax / jmax;
+        tc = vmax / amax - tj;
+    } else {
+        tj = sqrtf(vmax / jmax);
+        tc = 0.0f;
     }
+    v = vmax;
+    tv = distance / vmax - (2.0f * tj + tc);
     
-    // Velocity loop (middle loop)
-    float velocity_error = ctrl->velocity_setpoint - ctrl->velocity;
-    ctrl->current_setpoint = pid_compute(&ctrl->velocity_pid, velocity_error);
+    if (tv < 0.0f) {
+        // No cruise: the acceleration and deceleration meet at peak velocity
+        // v, which covers v * (2*tj + tc) in total
+        tv = 0.0f;
+        tj = amax / jmax;
+        v = 0.5f * amax * (sqrtf(tj * tj + 4.0f * distance / amax) - tj);
+        tc = v / amax - tj;
+        if (tc < 0.0f) {
+            // Too short to reach amax either: pure jerk, distance = 2*j*tj^3
+            tj = cbrtf(distance / (2.0f * jmax));
+            tc = 0.0f;
+        }
+    }
     
-    // Current loop (inner loop - highest bandwidth)
-    float current_error = ctrl->current_setpoint - ctrl->current;
-    float voltage_command = pid_compute(&ctrl->current_pid, current_error);
+    const float durations[TRAJECTORY_SEGMENTS] = { tj, tc, tj, tv, tj, tc, tj };
+    const float jerks[TRAJECTORY_SEGMENTS] = { jmax, 0.0f, -jmax, 0.0f, -jmax, 0.0f, jmax };
+    float p = start, vel = 0.0f, a = 0.0f;
     
-    // Convert voltage command to PWM duties using space vector modulation
-    space_vector_modulation(voltage_command, ctrl->position, ctrl->pwm_duty);
+    for (int i = 0; i < TRAJECTORY_SEGMENTS; i++) {
+        float dt = durations[i];
+        float j = dir * jerks[i];
+        plan->duration[i] = dt;
+        plan->jerk[i] = j;
+        plan->p0[i] = p;
+        plan->v0[i] = vel;
+        plan->a0[i] = a;
+        p += dt * (vel + dt * (0.5f * a + dt * j * (1.0f / 6.0f)));
+        vel += dt * (a + 0.5f * dt * j);
+        a += dt * j;
+    }
+    plan->target = target;
 }
 
 /**
- * @brief Advanced PID controller with anti-windup
+ * @brief Plan a move to target and queue it (main loop)
+ * 
+ * The move starts, from rest, where the previous queued move ends; queued
+ * moves run back to back.
+ * @return HAL_ERROR if the queue is full or a limit is not positive
  */
-float pid_compute(pid_controller_t* pid, float error) {
-    static uint32_t last_time = 0;
-    uint32_t current_time = HAL_GetTick();
-    float dt = (float)(current_time - last_time) / 1000.0f;
+HAL_StatusTypeDef trajectory_queue_move(trajectory_t* traj, float target,
+                                        float vmax, float amax, float jmax) {
+    if (traj->head - traj->tail >= TRAJECTORY_QUEUE_DEPTH ||
+        !(vmax > 0.0f) || !(amax > 0.0f) || !(jmax > 0.0f)) {
+        return HAL_ERROR;
+    }
     
-    if (dt <= 0.0f) dt = 1.0f / CONTROL_FREQUENCY;
+    trajectory_plan(&traj->queue[traj->head & (TRAJECTORY_QUEUE_DEPTH - 1)],
+                    traj->last_target, target, vmax, amax, jmax);
+    traj->last_target = target;
     
-    // Proportional term
-    float output = pid->kp * error;
+    // Plan contents must be visible before the position loop sees the new head
+    control_memory_barrier();
+    traj->head++;
+    return HAL_OK;
+}
+
+/**
+ * @brief Position, velocity and acceleration for this tick (position loop)
+ * 
+ * Finds the current segment and evaluates its cubic by Horner's rule. At
+ * the end of a move the exact target is held with zero velocity and
+ * acceleration until the next queued move starts.
+ * @return true once the trajectory drives the setpoint
+ */
+bool trajectory_update(trajectory_t* traj) {
+    if (!traj->active) {
+        if (traj->tail == traj->head) {
+            return traj->engaged;
+        }
+        control_memory_barrier();   // Read the plan only after seeing head
+        traj->active = true;
+        traj->engaged = true;
+        traj->segment = 0;
+        traj->t = 0.0f;
+    }
     
-    // Integral term with anti-windup
-    pid->integral += error * dt;
+    const trajectory_plan_t* plan = &traj->queue[traj->tail & (TRAJECTORY_QUEUE_DEPTH - 1)];
+    while (traj->segment < TRAJECTORY_SEGMENTS && traj->t >= plan->duration[traj->segment]) {
+        traj->t -= plan->duration[traj->segment];
+        traj->segment++;
+    }
     
-    // Clamp integral term
-    if (pid->integral > pid->integral_max) {
-        pid->integral = pid->integral_max;
-    } else if (pid->integral < pid->integral_min) {
-        pid->integral = pid->integral_min;
+    if (traj->segment == TRAJECTORY_SEGMENTS) {
+        traj->position = plan->target;
+        traj->velocity = 0.0f;
+        traj->acceleration = 0.0f;
+        traj->active = false;
+        control_memory_barrier();   // Done with the slot before releasing it
+        traj->tail++;
+        return true;
     }
     
-    output += pid->ki * pid->integral;
+    uint32_t i = traj->segment;
+    float dt = traj->t;
+    float j = plan->jerk[i];
+    float a0 = plan->a0[i];
+    traj->acceleration = a0 + dt * j;
+    traj->velocity = plan->v0[i] + dt * (a0 + 0.5f * dt * j);
+    traj->position = plan->p0[i] + dt * (plan->v0[i] + dt * (0.5f * a0 + dt * j * (1.0f / 6.0f)));
+    traj->t += traj->ts;
+    return true;
+}
+
+/**
+ * @brief Build the per-axis tasks and assign phases so outer tasks share as
+ *        few ticks as possible
+ * 
+ * Tasks are placed fastest first, each type for every axis in turn. Each
+ * takes the first phase whose ticks are all still free over the
+ * hyperperiod (the largest divisor); if none is, the phase that adds least
+ * to the busiest tick. With one axis the default divisors fit with one task
+ * per tick; with four, the tasks spread to at most three per tick.
+ * @return Most outer tasks that ever run in one tick (1 when staggered)
+ */
+uint32_t control_schedule_init(void) {
+    uint8_t load[SCHEDULE_MAX_PERIOD] = {0};
+    uint32_t period = 1;
+    uint32_t worst = 0;
+    
+    for (uint32_t i = 0; i < CONTROL_TASK_COUNT; i++) {
+        control_tasks[i] = control_task_types[i / MOTOR_AXIS_COUNT];
+        control_tasks[i].axis = (uint16_t)(i % MOTOR_AXIS_COUNT);
+    }
     
-    // Derivative term with filtering
-    float derivative = (error - pid->last_error) / dt;
-    pid->derivative_filtered = 0.8f * pid->derivative_filtered + 0.2f * derivative;
-    output += pid->kd * pid->derivative_filtered;
+    for (uint32_t i = 0; i < CONTROL_TASK_COUNT; i++) {
+        if (control_tasks[i].divisor > period) period = control_tasks[i].divisor;
+    }
     
-    pid->last_error = error;
-    last_time = current_time;
+    for (uint32_t i = 0; i < CONTROL_TASK_COUNT; i++) {
+        control_task_t* task = &control_tasks[i];
+        uint32_t best_phase = 0;
+        uint32_t best_peak = UINT32_MAX;
+        
+        for (uint32_t phase = 0; phase < task->divisor; phase++) {
+            uint32_t peak = 0;
+            for (uint32_t t = phase; t < period; t += task->divisor) {
+                if (load[t] + 1u > peak) peak = load[t] + 1u;
+            }
+            if (peak < best_peak) {
+                best_peak = peak;
+                best_phase = phase;
+            }
+        }
+        
+        task->phase = (uint16_t)best_phase;
+        task->worst_cycles = 0;
+        for (uint32_t t = best_phase; t < period; t += task->divisor) {
+            load[t]++;
+        }
+        if (best_peak > worst) worst = best_peak;
+    }
     
-    return output;
+    control_tick = 0;
+    control_tick_worst_cycles = 0;
+    return worst;
 }
 
 /**
- * @brief Space Vector Modulation for 3-phase PWM generation
+ * @brief Run the outer-loop tasks due on this current-loop tick
  */
-void space_vector_modulation(float voltage_magnitude, float angle, float* duties) {
-    // Convert to 3-phase voltages
-    float va = voltage_magnitude * cosf(angle);
-    float vb = voltage_magnitude * cosf(angle - 2.0f * M_PI / 3.0f);
-    float vc = voltage_magnitude * cosf(angle + 2.0f * M_PI / 3.0f);
+static void control_scheduler_tick(void) {
+    uint32_t tick = control_tick++;
     
-    // Find min and max for centering
-    float vmin = fminf(fminf(va, vb), vc);
-    float vmax = fmaxf(fmaxf(va, vb), vc);
-    float vcom = (vmin + vmax) / 2.0f;
+    for (uint32_t i = 0; i < CONTROL_TASK_COUNT; i++) {
+        control_task_t* task = &control_tasks[i];
+        if ((tick & (task->divisor - 1u)) == task->phase) {
+            uint32_t start = control_cycle_count();
+            task->run(&motors[task->axis]);
+            uint32_t cycles = control_cycle_count() - start;
+            if (cycles > task->worst_cycles) {
+                task->worst_cycles = cycles;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Worst-case cycles of a whole current-loop tick and of each task
+ * @param task_worst Array of CONTROL_TASK_COUNT entries (type-major: each
+ *                   task type for axes 0 to MOTOR_AXIS_COUNT-1), or NULL
+ * @return Tick budget in cycles (one PWM period)
+ */
+uint32_t control_get_tick_timing(uint32_t* tick_worst, uint32_t* task_worst) {
+    *tick_worst = control_tick_worst_cycles;
+    if (task_worst) {
+        for (uint32_t i = 0; i < CONTROL_TASK_COUNT; i++) {
+            task_worst[i] = control_tasks[i].worst_cycles;
+        }
+    }
+    return SystemCoreClock / PWM_FREQUENCY;
+}
+
+/**
+ * @brief Velocity loop task (CONTROL_FREQUENCY): encoder feedback and speed PID
+ * 
+ * The output is the torque (q-axis) current reference for the current loop.
+ * A sensorless axis takes its speed from the flux observer while it is
+ * locked; the encoder observer keeps running so the handover is smooth.
+ */
+void velocity_loop_task(motor_control_t* ctrl) {
+    // Position from the count extended in the current loop this tick
+    ctrl->position = (float)ctrl->encoder.count * (360.0f / ENCODER_COUNTS_PER_REV);
+    ctrl->velocity = encoder_observer_update(&ctrl->encoder) *
+                     (60.0f / ENCODER_COUNTS_PER_REV);
+    if (ctrl->sensorless && flux_observers.locked[ctrl->axis]) {
+        ctrl->velocity = flux_observer_velocity(&flux_observers, ctrl->axis);
+    }
+    ctrl->current = foc_axes.iq[ctrl->axis];
     
-    // Generate centered PWM duties
-    duties[0] = (va - vcom + 1.0f) / 2.0f;  // Phase A
-    duties[1] = (vb - vcom + 1.0f) / 2.0f;  // Phase B
-    duties[2] = (vc - vcom + 1.0f) / 2.0f;  // Phase C
+    if (ctrl->state == MOTOR_STATE_FAULT) {
+        return;
+    }
     
-    // Clamp to valid range
-    for (int i = 0; i < 3; i++) {
-        if (duties[i] < 0.0f) duties[i] = 0.0f;
-        if (duties[i] > 1.0f) duties[i] = 1.0f;
+    // The torque feedforward goes inside the PID clamp: the reference never
+    // exceeds the velocity loop's current limit, and the integrator does not
+    // wind up while the feedforward holds it there
+    float velocity_error = ctrl->velocity_setpoint - ctrl->velocity;
+    ctrl->current_setpoint = pid_compute_ff(&ctrl->velocity_pid, velocity_error,
+                                            ctrl->current_feedforward);
+    foc_axes.iq_ref[ctrl->axis] = ctrl->current_setpoint;
+    
+    control_update_flag = true;
+}
+
+/**
+ * @brief Position loop task (POSITION_LOOP_FREQUENCY) with trajectory feedforward
+ * 
+ * Once moves have been queued, the trajectory drives the setpoint and its
+ * velocity and acceleration are fed forward to the velocity and current
+ * loops, so the PID only corrects the following error. Without a
+ * trajectory, position_setpoint is used as written, with no feedforward.
+ */
+void position_loop_task(motor_control_t* ctrl) {
+    if (ctrl->state != MOTOR_STATE_POSITION_CONTROL) {
+        ctrl->current_feedforward = 0.0f;
+        return;
+    }
+    
+    float velocity_ff = 0.0f;
+    ctrl->current_feedforward = 0.0f;
+    if (trajectory_update(&ctrl->trajectory)) {
+        ctrl->position_setpoint = ctrl->trajectory.position;
+        velocity_ff = ctrl->trajectory.velocity * (60.0f / 360.0f);          // rpm
+        ctrl->current_feedforward = ctrl->trajectory.acceleration *
+            ((float)M_PI / 180.0f * MOTOR_INERTIA / MOTOR_TORQUE_CONSTANT);
     }
+    
+    float position_error = ctrl->position_setpoint - ctrl->position;
+    ctrl->velocity_setpoint = pid_compute_ff(&ctrl->position_pid, position_error, velocity_ff);
 }
 
 /**
- * @brief Comprehensive safety monitoring
+ * @brief Safety supervisor task: trip the outputs on any limit violation
  */
-bool check_safety_limits(motor_control_t* ctrl) {
-    bool safe = true;
+void supervisor_task(motor_control_t* ctrl) {
+    if (ctrl->state != MOTOR_STATE_FAULT && !check_safety_limits(ctrl)) {
+        // Safety violation - disable outputs
+        disable_motor_outputs(ctrl->axis);
+        motor_trip_fault(ctrl->axis, TRIP_SUPERVISOR);
+    }
+}
+
+/**
+ * @brief Record a trip, latch the fault state and start freezing the black box
+ * 
+ * Runs in the trip interrupts; the main loop calls it with interrupts masked.
+ * @param axis Axis that tripped, or TRIP_ALL_AXES
+ */
+static void motor_trip_fault(uint32_t axis, trip_source_t source) {
+    for (uint32_t k = 0; k < MOTOR_AXIS_COUNT; k++) {
+        if (axis == k || axis == TRIP_ALL_AXES) {
+            motors[k].state = MOTOR_STATE_FAULT;
+        }
+    }
+    if (motor_trip.source == TRIP_NONE) {
+        motor_trip.source = source;
+        motor_trip.axis = axis;
+    }
+    motor_trip.count++;
     
-    // Current limit check
-    if (fabsf(ctrl->current) > ctrl->max_current) {
-        ctrl->faults.overcurrent = true;
-        safe = false;
+    if (blackbox.state == BLACKBOX_RECORDING) {
+        blackbox.post_remaining = BLACKBOX_POST_TRIP;
+        blackbox.state = BLACKBOX_TRIPPED;
+    }
+}
+
+/**
+ * @brief Set up the hardware trip paths (after PWM and current-sense ADC)
+ * 
+ * Break inputs: one per axis's PWM timer, active high; the outputs go to
+ * their off state and stay there (no automatic output enable) until
+ * software sets MOE again. The dead time lives in the same register, so it
+ * is written here too.
+ * Analog watchdog: one window on all regular channels, centred on the
+ * zero-current reading, so any phase of any axis in either direction trips
+ * it.
+ */
+void configure_fault_protection(void) {
+    TIM_BreakDeadTimeConfigTypeDef brk = {0};
+    brk.OffStateRunMode = TIM_OSSR_ENABLE;
+    brk.OffStateIDLEMode = TIM_OSSI_ENABLE;
+    brk.LockLevel = TIM_LOCKLEVEL_OFF;
+    brk.DeadTime = PWM_DEAD_TIME_TICKS;
+    brk.BreakState = TIM_BREAK_ENABLE;
+    brk.BreakPolarity = TIM_BREAKPOLARITY_HIGH;
+    brk.AutomaticOutput = TIM_AUTOMATICOUTPUT_DISABLE;
+    for (uint32_t k = 0; k < MOTOR_AXIS_COUNT; k++) {
+        HAL_TIMEx_ConfigBreakDeadTime(&htim_pwm[k], &brk);
+        __HAL_TIM_ENABLE_IT(&htim_pwm[k], TIM_IT_BREAK);
     }
     
-    // Velocity limit check
-    if (fabsf(ctrl->velocity) > ctrl->max_velocity) {
-        ctrl->faults.overspeed = true;
-        safe = false;
+    uint32_t window = (uint32_t)(OVERCURRENT_TRIP_AMPS / CURRENT_AMPS_PER_COUNT);
+    current_window_low = (uint16_t)(ADC_CURRENT_OFFSET - window);
+    current_window_high = (uint16_t)(ADC_CURRENT_OFFSET + window);
+    ADC_AnalogWDGConfTypeDef awd = {0};
+    awd.WatchdogMode = ADC_ANALOGWATCHDOG_ALL_REG;
+    awd.HighThreshold = current_window_high;
+    awd.LowThreshold = current_window_low;
+    awd.ITMode = ENABLE;
+    HAL_ADC_AnalogWDGConfig(&hadc_current, &awd);
+}
+
+/**
+ * @brief Break input interrupt: the axis's timer has already forced its outputs off
+ */
+void HAL_TIMEx_BreakCallback(TIM_HandleTypeDef* htim) {
+    for (uint32_t k = 0; k < MOTOR_AXIS_COUNT; k++) {
+        if (htim == &htim_pwm[k]) {
+            motors[k].faults.overcurrent = true;
+            motor_trip_fault(k, TRIP_BREAK_INPUT);
+        }
+    }
+}
+
+/**
+ * @brief Analog watchdog: a current sample left the window
+ * 
+ * The watchdog does not say which channel tripped, so every axis's outputs
+ * go off, one register write each, and every axis latches the fault. The
+ * interrupt fires at the end of the offending conversion, whose sample DMA
+ * has stored by the time it is entered, so the DMA position tells how far
+ * the scan has got. Looking back from there for a sample outside the
+ * window finds the offending one even if a later conversion has landed
+ * meanwhile; pairs the current loops have already taken (set back to
+ * ADC_SAMPLE_PENDING) are skipped. If the offending pair has been taken
+ * too, the axis is recorded as unknown. The ADC interrupt is set above the
+ * control interrupt's priority and preempts the current loops. The samples
+ * are taken at the counter peak of the centre-aligned master timer and the
+ * counter has been counting down since, so ARR - CNT is the time from the
+ * sample to here: the scan up to the offending pair and interrupt entry.
+ */
+void HAL_ADC_LevelOutOfWindowCallback(ADC_HandleTypeDef* hadc) {
+    if (hadc->Instance != ADC_CURRENT) {
+        return;
+    }
+    for (uint32_t k = 0; k < MOTOR_AXIS_COUNT; k++) {
+        __HAL_TIM_MOE_DISABLE_UNCONDITIONALLY(&htim_pwm[k]);
     }
+    uint32_t ticks = __HAL_TIM_GET_AUTORELOAD(&htim_pwm[0]) -
+                     __HAL_TIM_GET_COUNTER(&htim_pwm[0]);
     
-    // Position limit check
-    if (ctrl->position < ctrl->position_limit_min || 
-        ctrl->position > ctrl->position_limit_max) {
-        ctrl->faults.position_limit = true;
-        safe = false;
+    if (motor_trip.source == TRIP_NONE) {
+        motor_trip.latency_ticks = ticks;
     }
     
-    // Temperature monitoring (if available)
-    float temperature = read_motor_temperature();
-    if (temperature > MAX_MOTOR_TEMPERATURE) {
-        ctrl->faults.overtemperature = true;
-        safe = false;
+    // A full counter means circular mode has reloaded it after the last sample
+    uint32_t written = 2 * MOTOR_AXIS_COUNT - __HAL_DMA_GET_COUNTER(hadc->DMA_Handle);
+    if (written == 0) {
+        written = 2 * MOTOR_AXIS_COUNT;
+    }
+    uint32_t axis = TRIP_ALL_AXES;
+    for (uint32_t i = written; i-- > 0; ) {
+        uint16_t sample = current_samples[i];
+        if (sample != ADC_SAMPLE_PENDING &&
+            (sample < current_window_low || sample > current_window_high)) {
+            axis = i / 2;
+            break;
+        }
+    }
+    for (uint32_t k = 0; k < MOTOR_AXIS_COUNT; k++) {
+        motors[k].faults.overcurrent = true;
+        motors[k].state = MOTOR_STATE_FAULT;
+    }
+    motor_trip_fault(axis, TRIP_ANALOG_WATCHDOG);
+}
+
+/**
+ * @brief First trip source and, for the watchdog path, its latency
+ * @param axis Axis of the first trip, or TRIP_ALL_AXES
+ * @return Sample-to-outputs-off time in nanoseconds (0 for other sources)
+ */
+uint32_t fault_get_trip(trip_source_t* source, uint32_t* axis, uint32_t* count) {
+    *source = motor_trip.source;
+    *axis = motor_trip.axis;
+    *count = motor_trip.count;
+    if (motor_trip.source != TRIP_ANALOG_WATCHDOG) {
+        return 0;
+    }
+    return (uint32_t)((uint64_t)motor_trip.latency_ticks * 1000000000u / PWM_TIMER_CLOCK);
+}
+
+/**
+ * @brief Slow thermal supervisor (main loop)
+ * 
+ * The temperature sensor read is slow and the winding heats over seconds,
+ * so it is polled here every THERMAL_CHECK_PERIOD_MS rather than in the
+ * control interrupt.
+ */
+void motor_thermal_check(void) {
+    static uint32_t last_check = 0;
+    uint32_t now = HAL_GetTick();
+    
+    if (now - last_check < THERMAL_CHECK_PERIOD_MS) {
+        return;
     }
+    last_check = now;
     
-    return safe;
-}
\ No newline at end of file
+    for (uint32_t k = 0; k < MOTOR_AXIS_COUNT; k++) {
+        float temperature = read_motor_temperature(k);
+        if (temperature <= MAX_MOTOR_TEMPERATURE) {
+            continue;
+        }
+        
+        // The break, watchdog and supervisor interrupts trip through the same
+        // record; masked, none can land between its first-trip test and write
+        uint32_t primask = __get_PRIMASK();
+        __disable_irq();
+        if (motors[k].state != MOTOR_STATE_FAULT) {
+            disable_motor_outputs(k);
+            motors[k].faults.overtemperature = true;
+            motor_trip_fault(k, TRIP_THERMAL);
+        }
+        __set_PRIMASK(primask);
+    }
+}
+
+/**
+ * @brief Enable the backup SRAM and start recording
+ * 
+ * A previous save is left alone until the next trip overwrites it, so it
+ * can be read with blackbox_load() after the reset that followed it. The
+ * backup regulator keeps it on VBAT too, when a battery is fitted.
+ */
+void blackbox_init(void) {
+    __HAL_RCC_PWR_CLK_ENABLE();
+    HAL_PWR_EnableBkUpAccess();
+    __HAL_RCC_BKPSRAM_CLK_ENABLE();
+    HAL_PWREx_EnableBkUpReg();
+    
+    blackbox.decimate_count = 1;
+    blackbox.write_index = 0;
+    blackbox.recorded = 0;
+    blackbox.state = BLACKBOX_RECORDING;
+}
+
+/**
+ * @brief Scale and saturate to int16
+ */
+static inline int16_t blackbox_fixed(float x, float scale) {
+    x *= scale;
+    if (x > 32767.0f) x = 32767.0f;
+    if (x < -32768.0f) x = -32768.0f;
+    return (int16_t)x;
+}
+
+/**
+ * @brief Snapshot every axis into its ring (control interrupt)
+ * 
+ * Runs every BLACKBOX_DIVISOR ticks until BLACKBOX_POST_TRIP snapshots
+ * after a trip, then the rings stay frozen. Straight-line conversions only,
+ * so the cost is the same every time, a few tens of cycles per axis
+ * (see benchmark_blackbox_record), and one compare once frozen.
+ */
+static void blackbox_record(void) {
+    blackbox_t* bb = &blackbox;
+    blackbox_state_t state = bb->state;
+    
+    if (state != BLACKBOX_RECORDING && state != BLACKBOX_TRIPPED) {
+        return;
+    }
+    if (--bb->decimate_count != 0) {
+        return;
+    }
+    bb->decimate_count = BLACKBOX_DIVISOR;
+    
+    uint32_t i = bb->write_index;
+    uint16_t tick = (uint16_t)control_tick;
+    for (uint32_t k = 0; k < MOTOR_AXIS_COUNT; k++) {
+        const motor_control_t* m = &motors[k];
+        blackbox_record_t* r = &blackbox_ring[k][i];
+        r->tick = tick;
+        r->state = (uint8_t)m->state;
+        r->faults = (uint8_t)(m->faults.overcurrent | (m->faults.overspeed << 1) |
+                              (m->faults.position_limit << 2) | (m->faults.overtemperature << 3));
+        r->position = blackbox_fixed(m->position, 100.0f);
+        r->velocity_setpoint = blackbox_fixed(m->velocity_setpoint, 10.0f);
+        r->velocity = blackbox_fixed(m->velocity, 10.0f);
+        r->iq_ref = blackbox_fixed(foc_axes.iq_ref[k], 1000.0f);
+        r->iq = blackbox_fixed(foc_axes.iq[k], 1000.0f);
+        r->id = blackbox_fixed(foc_axes.id[k], 1000.0f);
+    }
+    bb->write_index = (i + 1) & (BLACKBOX_DEPTH - 1);
+    if (bb->recorded < BLACKBOX_DEPTH) {
+        bb->recorded++;
+    }
+    
+    if (state == BLACKBOX_TRIPPED && --bb->post_remaining == 0) {
+        bb->state = BLACKBOX_FROZEN;
+    }
+}
+
+/**
+ * @brief Fletcher-32 over little-endian 16-bit words
+ * @param sum Result so far, 0 to start
+ */
+static uint32_t blackbox_checksum(const void* data, uint32_t bytes, uint32_t sum) {
+    const uint8_t* p = (const uint8_t*)data;
+    uint32_t sum1 = sum & 0xFFFF, sum2 = sum >> 16;
+    for (uint32_t i = 0; i + 1 < bytes; i += 2) {
+        sum1 = (sum1 + (p[i] | ((uint32_t)p[i + 1] << 8))) % 65535;
+        sum2 = (sum2 + sum1) % 65535;
+    }
+    return (sum2 << 16) | sum1;
+}
+
+/**
+ * @brief Save a frozen black box to backup SRAM (main loop)
+ * 
+ * Only runs once the ring has frozen, by which time the trip path has
+ * turned the outputs off. Saves the newest BLACKBOX_SAVED_DEPTH snapshots
+ * of the tripped axis, oldest first, and writes the header last so a reset
+ * part way through leaves no valid image. If the trip axis is unknown the
+ * records are axis 0's and the header says TRIP_ALL_AXES.
+ */
+void blackbox_service(void) {
+    if (blackbox.state != BLACKBOX_FROZEN) {
+        return;
+    }
+    
+    blackbox_header_t* header = (blackbox_header_t*)BKPSRAM_BASE;
+    blackbox_record_t* saved = (blackbox_record_t*)(header + 1);
+    bool known = motor_trip.axis < MOTOR_AXIS_COUNT;
+    uint32_t axis = known ? motor_trip.axis : 0;
+    uint32_t count = blackbox.recorded;
+    if (count > BLACKBOX_SAVED_DEPTH) count = BLACKBOX_SAVED_DEPTH;
+    
+    header->magic = 0;
+    uint32_t first = (blackbox.write_index - count) & (BLACKBOX_DEPTH - 1);
+    for (uint32_t n = 0; n < count; n++) {
+        saved[n] = blackbox_ring[axis][(first + n) & (BLACKBOX_DEPTH - 1)];
+    }
+    
+    blackbox_header_t h = {0};
+    h.source = (uint8_t)motor_trip.source;
+    h.axis = (uint8_t)(known ? axis : TRIP_ALL_AXES);
+    h.record_count = (uint16_t)count;
+    h.trip_record = (uint16_t)(count > BLACKBOX_POST_TRIP ? count - BLACKBOX_POST_TRIP : 0);
+    uint32_t sum = blackbox_checksum(&h, sizeof(h), 0);
+    h.checksum = blackbox_checksum(saved, count * sizeof(*saved), sum);
+    h.magic = BLACKBOX_MAGIC;
+    *header = h;
+    
+    blackbox.state = BLACKBOX_SAVED;
+}
+
+/**
+ * @brief Saved black box, if backup SRAM holds a valid one
+ * @param records Set to the first (oldest) record
+ * @return Header, or NULL if there is nothing saved or it is damaged
+ */
+const blackbox_header_t* blackbox_load(const blackbox_record_t** records) {
+    const blackbox_header_t* header = (const blackbox_header_t*)BKPSRAM_BASE;
+    const blackbox_record_t* saved = (const blackbox_record_t*)(header + 1);
+    
+    if (header->magic != BLACKBOX_MAGIC || header->record_count > BLACKBOX_SAVED_DEPTH) {
+        return NULL;
+    }
+    blackbox_header_t h = *header;
+    h.magic = 0;
+    h.checksum = 0;
+    uint32_t sum = blackbox_checksum(&h, sizeof(h), 0);
+    sum = blackbox_checksum(saved, h.record_count * sizeof(*saved), sum);
+    if (sum != header->checksum) {
+        return NULL;
+    }
+    *records = saved;
+    return header;
+}
+
+/**
+ * @brief Discard the saved black box once it has been read out
+ */
+void blackbox_clear(void) {
+    ((blackbox_header_t*)BKPSRAM_BASE)->magic = 0;
+}
+
+/**
+ * @brief Address of a telemetry channel's signal on one axis
+ */
+static const float* telemetry_source(telemetry_channel_t channel, uint32_t axis) {
+    const telemetry_source_t* src = &telemetry_sources[channel];
+    return (const float*)((const uint8_t*)src->axis0 + axis * src->stride);
+}
+
+/**
+ * @brief Select the captured channels, the axis and the capture rate
+ * 
+ * Only allowed while no capture is in progress. The ring is split evenly,
+ * so fewer channels give a deeper capture.
+ * @param divisor Capture every divisor current-loop ticks (1 = PWM_FREQUENCY)
+ * @param axis Axis the channels and the trigger are taken from
+ */
+HAL_StatusTypeDef telemetry_configure(const telemetry_channel_t* channels, uint32_t count,
+                                      uint32_t divisor, uint32_t axis) {
+    if (telemetry.state != TELEMETRY_IDLE || count == 0 ||
+        count > TELEMETRY_MAX_CHANNELS || divisor == 0 || axis >= MOTOR_AXIS_COUNT) {
+        return HAL_ERROR;
+    }
+    
+    for (uint32_t i = 0; i < count; i++) {
+        if (channels[i] >= TELEM_CHANNEL_COUNT) {
+            return HAL_ERROR;
+        }
+        telemetry.channel[i] = (uint8_t)channels[i];
+        telemetry.source[i] = telemetry_source(channels[i], axis);
+        telemetry.scale[i] = 32767.0f / telemetry_full_scale[channels[i]];
+    }
+    telemetry.channel_count = count;
+    telemetry.divisor = divisor;
+    telemetry.axis = axis;
+    telemetry.depth = TELEMETRY_BUFFER_WORDS / count;
+    telemetry.ring_words = telemetry.depth * count;
+    return HAL_OK;
+}
+
+/**
+ * @brief Start a capture that freezes around the next trigger edge
+ * 
+ * The trigger is only armed once pre_samples of history are in the ring,
+ * so the capture always holds pre_samples before the trigger sample and
+ * fills the rest of the ring after it.
+ * @param level Trigger level in the source channel's units
+ */
+HAL_StatusTypeDef telemetry_arm(telemetry_channel_t source, float level,
+                                telemetry_edge_t edge, uint32_t pre_samples) {
+    if (telemetry.state != TELEMETRY_IDLE || source >= TELEM_CHANNEL_COUNT ||
+        pre_samples >= telemetry.depth) {
+        return HAL_ERROR;
+    }
+    
+    telemetry.trigger_source = telemetry_source(source, telemetry.axis);
+    telemetry.trigger_level = level;
+    telemetry.trigger_edge = edge;
+    telemetry.trigger_prev = *telemetry.trigger_source;
+    telemetry.force_trigger = false;
+    telemetry.pre_samples = pre_samples;
+    telemetry.pre_filled = 0;
+    telemetry.decimate_count = 1;
+    telemetry.write_index = 0;
+    telemetry.state = TELEMETRY_ARMED;
+    return HAL_OK;
+}
+
+/**
+ * @brief Trigger on the next captured sample regardless of the signal
+ */
+void telemetry_force_trigger(void) {
+    telemetry.force_trigger = true;
+}
+
+/**
+ * @brief Capture one sample (current-loop interrupt, every tick)
+ * 
+ * Copies the selected channels through precomputed pointers, scaled and
+ * saturated to int16, then runs the trigger logic. With four channels this
+ * is a few dozen cycles on the M4; idle or frozen it is one compare.
+ */
+static void telemetry_capture(void) {
+    telemetry_t* t = &telemetry;
+    telemetry_state_t state = t->state;
+    
+    if (state != TELEMETRY_ARMED && state != TELEMETRY_TRIGGERED) {
+        return;
+    }
+    if (--t->decimate_count != 0) {
+        return;
+    }
+    t->decimate_count = t->divisor;
+    
+    int16_t* dst = &telemetry_buffer[t->write_index];
+    for (uint32_t i = 0; i < t->channel_count; i++) {
+        float x = *t->source[i] * t->scale[i];
+        if (x > 32767.0f) x = 32767.0f;
+        if (x < -32768.0f) x = -32768.0f;
+        dst[i] = (int16_t)x;
+    }
+    t->write_index += t->channel_count;
+    if (t->write_index >= t->ring_words) {
+        t->write_index = 0;
+    }
+    
+    if (state == TELEMETRY_ARMED) {
+        float value = *t->trigger_source;
+        bool rising = t->trigger_prev < t->trigger_level && value >= t->trigger_level;
+        bool falling = t->trigger_prev > t->trigger_level && value <= t->trigger_level;
+        t->trigger_prev = value;
+        
+        if (t->pre_filled < t->pre_samples) {
+            t->pre_filled++;
+            return;
+        }
+        if (t->force_trigger ||
+            (rising && t->trigger_edge != TELEMETRY_EDGE_FALLING) ||
+            (falling && t->trigger_edge != TELEMETRY_EDGE_RISING)) {
+            t->post_remaining = t->depth - t->pre_samples - 1;
+            t->state = TELEMETRY_TRIGGERED;
+        }
+    } else {
+        t->post_remaining--;
+    }
+    
+    if (t->state == TELEMETRY_TRIGGERED && t->post_remaining == 0) {
+        // Ring is full: the oldest sample is at write_index
+        t->stream_index = t->depth + 1;
+        t->state = TELEMETRY_COMPLETE;
+    }
+}
+
+/**
+ * @brief Frame a payload: sync, type, sequence, length, payload, Fletcher-16
+ * @return Total frame length in bytes
+ */
+static uint32_t telemetry_build_frame(uint8_t type, uint32_t length) {
+    uint8_t* f = telemetry_frame;
+    f[0] = TELEMETRY_SYNC_0;
+    f[1] = TELEMETRY_SYNC_1;
+    f[2] = type;
+    f[3] = telemetry.sequence++;
+    f[4] = (uint8_t)length;
+    f[5] = (uint8_t)(length >> 8);
+    
+    uint32_t sum1 = 0, sum2 = 0;
+    for (uint32_t i = 2; i < 6 + length; i++) {
+        sum1 = (sum1 + f[i]) % 255;
+        sum2 = (sum2 + sum1) % 255;
+    }
+    f[6 + length] = (uint8_t)sum1;
+    f[7 + length] = (uint8_t)sum2;
+    return 8 + length;
+}
+
+/**
+ * @brief Stream a frozen capture, one frame per call (main loop)
+ * 
+ * Sends a header frame (channels, axis, full scales, sample rate, depth and
+ * trigger position), then data frames of whole samples, oldest first.
+ * Returns to IDLE once the last frame is queued; re-arm to capture again.
+ */
+void telemetry_service(void) {
+    telemetry_t* t = &telemetry;
+    if (t->state != TELEMETRY_COMPLETE || t->tx_busy) {
+        return;
+    }
+    
+    uint8_t* payload = &telemetry_frame[6];
+    uint32_t length;
+    uint8_t type;
+    
+    if (t->stream_index > t->depth) {
+        uint32_t rate = PWM_FREQUENCY / t->divisor;
+        payload[0] = (uint8_t)t->channel_count;
+        payload[1] = (uint8_t)t->axis;
+        memcpy(&payload[2], &rate, 4);
+        memcpy(&payload[6], &t->depth, 4);
+        memcpy(&payload[10], &t->pre_samples, 4);
+        length = 14;
+        for (uint32_t i = 0; i < t->channel_count; i++) {
+            float full_scale = telemetry_full_scale[t->channel[i]];
+            payload[length] = t->channel[i];
+            memcpy(&payload[length + 1], &full_scale, 4);
+            length += 5;
+        }
+        type = TELEMETRY_FRAME_HEADER;
+        t->stream_index = 0;
+    } else {
+        uint32_t per_frame = (TELEMETRY_FRAME_PAYLOAD - 4) / (2 * t->channel_count);
+        uint32_t count = t->depth - t->stream_index;
+        if (count > per_frame) count = per_frame;
+        
+        // Ring position of the sample: oldest is at write_index
+        uint32_t word = t->write_index + t->stream_index * t->channel_count;
+        if (word >= t->ring_words) word -= t->ring_words;
+        
+        memcpy(&payload[0], &t->stream_index, 4);
+        length = 4;
+        for (uint32_t n = 0; n < count; n++) {
+            memcpy(&payload[length], &telemetry_buffer[word], 2 * t->channel_count);
+            length += 2 * t->channel_count;
+            word += t->channel_count;
+            if (word >= t->ring_words) word = 0;
+        }
+        type = TELEMETRY_FRAME_DATA;
+        t->stream_index += count;
+    }
+    
+    uint32_t size = telemetry_build_frame(type, length);
+    t->tx_busy = true;
+    if (t->stream_index >= t->depth) {
+        t->state = TELEMETRY_IDLE;
+    }
+    HAL_UART_Transmit_DMA(&huart_telemetry, telemetry_frame, (uint16_t)size);
+}
+
+/**
+ * @brief UART DMA transmit complete: the frame buffer is free again
+ */
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef* huart) {
+    if (huart->Instance == USART_TELEMETRY) {
+        telemetry.tx_busy = false;
+    }
+}
+
+/**
+ * @brief Precompute PID coefficients for a loop run at a fixed rate
+ * 
+ * The back-calculation gain is Ki/Kp (tracking time constant Ti): while the
+ * output is clamped the integrator is pulled back at the rate it winds up.
+ * @param tf Derivative filter time constant (s), must be > 0 if kd > 0
+ * @param rate_hz Rate at which pid_compute will be called
+ */
+void pid_configure(pid_controller_t* pid, float kp, float ki, float kd, float tf,
+                   float rate_hz, float out_min, float out_max) {
+    float ts = 1.0f / rate_hz;
+    
+    pid->kp = kp;
+    pid->ki_ts = ki * ts;
+    pid->kaw_ts = (kp > 0.0f) ? (ki / kp) * ts : 0.0f;
+    pid->kd_a = tf / (tf + ts);
+    pid->kd_b = kd / (tf + ts);
+    pid->out_min = out_min;
+    pid->out_max = out_max;
+    pid_reset(pid);
+}
+
+/**
+ * @brief Clear controller state (on enable or mode change)
+ */
+void pid_reset(pid_controller_t* pid) {
+    pid->integral = 0.0f;
+    pid->derivative = 0.0f;
+    pid->last_error = 0.0f;
+}
+
+/**
+ * @brief One PID step: clamped output with back-calculation anti-windup
+ */
+float pid_compute(pid_controller_t* pid, float error) {
+    return pid_compute_ff(pid, error, 0.0f);
+}
+
+/**
+ * @brief One PID step with a feedforward term added inside the clamp
+ * 
+ * The output limits apply to PID output plus feedforward, and the
+ * back-calculation sees that clamped sum, so the integrator stops winding
+ * up whichever term drives the reference into the limit.
+ */
+float pid_compute_ff(pid_controller_t* pid, float error, float feedforward) {
+    pid->derivative = pid->kd_a * pid->derivative + pid->kd_b * (error - pid->last_error);
+    pid->last_error = error;
+    
+    float output = pid->kp * error + pid->integral + pid->derivative + feedforward;
+    float clamped = output;
+    if (clamped > pid->out_max) clamped = pid->out_max;
+    if (clamped < pid->out_min) clamped = pid->out_min;
+    
+    // Integrate the error, minus whatever the clamp cut off
+    pid->integral += pid->ki_ts * error + pid->kaw_ts * (clamped - output);
+    
+    return clamped;
+}
+
+/**
+ * @brief Saturate a 64-bit intermediate to a range
+ */
+static inline int32_t clamp_q31(int64_t x, int32_t lo, int32_t hi) {
+    if (x > hi) return hi;
+    if (x < lo) return lo;
+    return (int32_t)x;
+}
+
+static inline int32_t float_to_q24(float x) {
+    return (int32_t)lrintf(x * (float)(1 << PID_GAIN_SHIFT));
+}
+
+/**
+ * @brief Q31 counterpart of pid_configure (gains in real units, |gain| < 128)
+ * @param out_min, out_max Output limits as fractions of full scale (-1.0 to 1.0)
+ */
+void pid_configure_q31(pid_q31_t* pid, float kp, float ki, float kd, float tf,
+                       float rate_hz, float out_min, float out_max) {
+    pid_controller_t f;
+    pid_configure(&f, kp, ki, kd, tf, rate_hz, out_min, out_max);
+    
+    pid->kp = float_to_q24(f.kp);
+    pid->ki_ts = float_to_q24(f.ki_ts);
+    pid->kaw_ts = float_to_q24(f.kaw_ts);
+    pid->kd_b = float_to_q24(f.kd_b);
+    pid->kd_a = (int32_t)(f.kd_a * 2147483647.0);
+    pid->out_min = (int32_t)(out_min * 2147483647.0);
+    pid->out_max = (int32_t)(out_max * 2147483647.0);
+    pid->integral = 0;
+    pid->derivative = 0;
+    pid->last_error = 0;
+}
+
+/**
+ * @brief One Q31 PID step; same structure as pid_compute
+ * 
+ * Products are formed in 64 bits and saturated back to Q31, so large errors
+ * or gains clip instead of wrapping.
+ */
+int32_t pid_compute_q31(pid_q31_t* pid, int32_t error) {
+    int64_t delta = (int64_t)error - pid->last_error;
+    int64_t d = (((int64_t)pid->kd_a * pid->derivative) >> 31) +
+                ((pid->kd_b * delta) >> PID_GAIN_SHIFT);
+    pid->derivative = clamp_q31(d, INT32_MIN, INT32_MAX);
+    pid->last_error = error;
+    
+    int64_t output = (((int64_t)pid->kp * error) >> PID_GAIN_SHIFT) +
+                     pid->integral + pid->derivative;
+    int32_t clamped = clamp_q31(output, pid->out_min, pid->out_max);
+    
+    // Amount cut off by the clamp; bounded so kaw_ts * cut stays in 64 bits
+    int64_t cut = clamped - output;
+    if (cut > (1ll << 32)) cut = 1ll << 32;
+    if (cut < -(1ll << 32)) cut = -(1ll << 32);
+    int64_t integral = pid->integral +
+                       (((int64_t)pid->ki_ts * error + pid->kaw_ts * cut) >> PID_GAIN_SHIFT);
+    pid->integral = clamp_q31(integral, INT32_MIN, INT32_MAX);
+    
+    return clamped;
+}
+
+/**
+ * @brief Fill the quarter-wave sine table (call once at startup)
+ */
+void fast_trig_init(void) {
+    for (int i = 0; i < TRIG_QUARTER_SIZE + 2; i++) {
+        trig_quarter_table[i] = sinf((float)M_PI / 2.0f * i / TRIG_QUARTER_SIZE);
+        trig_quarter_q15[i] = (int16_t)lrintf(32767.0f * trig_quarter_table[i]);
+    }
+}
+
+/**
+ * @brief sin(x) for x from 0 to a quarter turn, linearly interpolated
+ */
+static inline float quarter_sin(uint32_t x) {
+    uint32_t i = x >> TRIG_INDEX_SHIFT;
+    float frac = (float)(x & ((1u << TRIG_INDEX_SHIFT) - 1)) * (1.0f / (1u << TRIG_INDEX_SHIFT));
+    float a = trig_quarter_table[i];
+    return a + (trig_quarter_table[i + 1] - a) * frac;
+}
+
+/**
+ * @brief Sine and cosine of a 32-bit angle from one quarter-wave table
+ * 
+ * Both come from the same quadrant split: the in-quadrant angle gives one
+ * and its complement gives the other. Peak error is about 5e-6.
+ */
+static inline void fast_sincos(uint32_t angle, float* sin_out, float* cos_out) {
+    uint32_t x = angle & (ANGLE_QUARTER_TURN - 1);
+    float a = quarter_sin(x);
+    float b = quarter_sin(ANGLE_QUARTER_TURN - x);
+    
+    switch (angle >> 30) {
+        case 0:  *sin_out = a;  *cos_out = b;  break;
+        case 1:  *sin_out = b;  *cos_out = -a; break;
+        case 2:  *sin_out = -a; *cos_out = -b; break;
+        default: *sin_out = -b; *cos_out = a;  break;
+    }
+}
+
+/**
+ * @brief Q15 counterpart of quarter_sin; integer multiply and shift only
+ */
+static inline int32_t quarter_sin_q15(uint32_t x) {
+    uint32_t i = x >> TRIG_INDEX_SHIFT;
+    int32_t frac = (int32_t)(x & ((1u << TRIG_INDEX_SHIFT) - 1));
+    int32_t a = trig_quarter_q15[i];
+    return a + (((trig_quarter_q15[i + 1] - a) * frac) >> TRIG_INDEX_SHIFT);
+}
+
+/**
+ * @brief Q15 sine and cosine of a 32-bit angle (see fast_sincos)
+ */
+static inline void fast_sincos_q15(uint32_t angle, int32_t* sin_out, int32_t* cos_out) {
+    uint32_t x = angle & (ANGLE_QUARTER_TURN - 1);
+    int32_t a = quarter_sin_q15(x);
+    int32_t b = quarter_sin_q15(ANGLE_QUARTER_TURN - x);
+    
+    switch (angle >> 30) {
+        case 0:  *sin_out = a;  *cos_out = b;  break;
+        case 1:  *sin_out = b;  *cos_out = -a; break;
+        case 2:  *sin_out = -a; *cos_out = -b; break;
+        default: *sin_out = -b; *cos_out = a;  break;
+    }
+}
+
+/**
+ * @brief Sector-based space vector PWM from a stationary-frame voltage
+ * 
+ * The sector is found by ordering the three phase voltages, so no angle or
+ * trig is needed. In each sector the two active vectors are applied for
+ * T1 = v_max - v_mid and T2 = v_mid - v_min, and the remaining time is split
+ * evenly between the two zero vectors (centre-aligned PWM). Requests beyond
+ * the hexagon are scaled back onto it, keeping the voltage angle.
+ * @param v_alpha, v_beta Voltage as a fraction of the DC bus (linear up to 1/sqrt(3))
+ * @param duties Phase A/B/C duty cycles, 0.0 to 1.0
+ * @return Sector 0-5 (sector k spans k*60 to (k+1)*60 degrees)
+ */
+uint32_t svpwm_duties(float v_alpha, float v_beta, float* duties) {
+    // Inverse Clarke
+    float v[3];
+    v[0] = v_alpha;
+    v[1] = -0.5f * v_alpha + 0.8660254f * v_beta;
+    v[2] = -0.5f * v_alpha - 0.8660254f * v_beta;
+    
+    uint32_t sector;
+    int hi, mid, lo;
+    if (v[0] >= v[1]) {
+        if (v[1] >= v[2])      { sector = 0; hi = 0; mid = 1; lo = 2; }
+        else if (v[0] >= v[2]) { sector = 5; hi = 0; mid = 2; lo = 1; }
+        else                   { sector = 4; hi = 2; mid = 0; lo = 1; }
+    } else {
+        if (v[0] >= v[2])      { sector = 1; hi = 1; mid = 0; lo = 2; }
+        else if (v[1] >= v[2]) { sector = 2; hi = 1; mid = 2; lo = 0; }
+        else                   { sector = 3; hi = 2; mid = 1; lo = 0; }
+    }
+    
+    float t1 = v[hi] - v[mid];
+    float t2 = v[mid] - v[lo];
+    float active = t1 + t2;
+    if (active > 1.0f) {
+        // Overmodulation: clamp to the hexagon edge
+        float scale = 1.0f / active;
+        t1 *= scale;
+        t2 *= scale;
+        active = 1.0f;
+    }
+    
+    float t0_half = 0.5f * (1.0f - active);
+    duties[lo] = t0_half;
+    duties[mid] = t0_half + t2;
+    duties[hi] = t0_half + t2 + t1;
+    return sector;
+}
+
+/**
+ * @brief Space Vector Modulation for 3-phase PWM generation
+ * @param voltage_magnitude Voltage in units of half the DC bus (linear up to 2/sqrt(3))
+ * @param angle Electrical angle of the voltage vector (2^32 = one turn)
+ */
+void space_vector_modulation(float voltage_magnitude, uint32_t angle, float* duties) {
+    float s, c;
+    fast_sincos(angle, &s, &c);
+    svpwm_duties(0.5f * voltage_magnitude * c, 0.5f * voltage_magnitude * s, duties);
+}
+
+/**
+ * @brief Tune one axis's d/q current PI loops and reset its current loop state
+ * 
+ * Pole-zero cancellation: Kp = L*wc and Ki = R*wc give a first-order
+ * closed loop at CURRENT_LOOP_BANDWIDTH_HZ. Gains are divided by the bus
+ * voltage because the loop outputs a fraction of Vdc.
+ */
+void foc_configure(foc_batch_t* foc, uint32_t axis) {
+    float wc = 2.0f * (float)M_PI * CURRENT_LOOP_BANDWIDTH_HZ;
+    float kp = MOTOR_LS * wc / DC_BUS_VOLTAGE;
+    float ki = MOTOR_RS * wc / DC_BUS_VOLTAGE;
+    pid_controller_t pi;
+    
+    pid_configure(&pi, kp, ki, 0.0f, 1.0f, PWM_FREQUENCY, -FOC_VOLTAGE_LIMIT, FOC_VOLTAGE_LIMIT);
+    foc->kp[axis] = pi.kp;
+    foc->ki_ts[axis] = pi.ki_ts;
+    foc->kaw_ts[axis] = pi.kaw_ts;
+    foc->id_integral[axis] = 0.0f;
+    foc->iq_integral[axis] = 0.0f;
+    foc->id_ref[axis] = 0.0f;    // No field weakening
+    foc->iq_ref[axis] = 0.0f;
+    foc->adc_offset[0][axis] = ADC_CURRENT_OFFSET;
+    foc->adc_offset[1][axis] = ADC_CURRENT_OFFSET;
+    for (int i = 0; i < 3; i++) {
+        foc->duty[axis][i] = 0.5f;
+    }
+}
+
+/**
+ * @brief Current-loop PI step; pid_compute with no derivative and the
+ *        limits fixed at the SVPWM linear range
+ */
+static inline float foc_pi_step(float kp, float ki_ts, float kaw_ts, float* integral,
+                                float error) {
+    float output = kp * error + *integral;
+    float clamped = output;
+    if (clamped > FOC_VOLTAGE_LIMIT) clamped = FOC_VOLTAGE_LIMIT;
+    if (clamped < -FOC_VOLTAGE_LIMIT) clamped = -FOC_VOLTAGE_LIMIT;
+    
+    *integral += ki_ts * error + kaw_ts * (clamped - output);
+    return clamped;
+}
+
+/**
+ * @brief One field-oriented control step for one axis: currents in, PWM duties out
+ * 
+ * Clarke and Park take the phase currents into the rotor frame, where the
+ * d and q currents are DC in steady state and two PI loops regulate them.
+ * The voltage vector is limited to the SVPWM linear range, giving the
+ * d axis priority, then goes back through inverse Park to SVPWM.
+ * @param adc_a, adc_b Raw phase A/B samples
+ * @param s, c Sine and cosine of the electrical rotor angle at the sampling instant
+ */
+static inline void foc_axis_step(foc_batch_t* foc, uint32_t k, int32_t adc_a, int32_t adc_b,
+                                 float s, float c) {
+    float ia = (adc_a - foc->adc_offset[0][k]) * CURRENT_AMPS_PER_COUNT;
+    float ib = (adc_b - foc->adc_offset[1][k]) * CURRENT_AMPS_PER_COUNT;
+    
+    // Clarke (balanced phases, ic = -ia - ib)
+    float i_alpha = ia;
+    float i_beta = 0.57735027f * (ia + 2.0f * ib);
+    
+    // Park
+    float id = c * i_alpha + s * i_beta;
+    float iq = c * i_beta - s * i_alpha;
+    foc->id[k] = id;
+    foc->iq[k] = iq;
+    
+    // d/q PI loops
+    float vd = foc_pi_step(foc->kp[k], foc->ki_ts[k], foc->kaw_ts[k], &foc->id_integral[k],
+                           foc->id_ref[k] - id);
+    float vq = foc_pi_step(foc->kp[k], foc->ki_ts[k], foc->kaw_ts[k], &foc->iq_integral[k],
+                           foc->iq_ref[k] - iq);
+    
+    // Circle limit: vq gets whatever vd leaves of the linear range
+    float vq_max_sq = FOC_VOLTAGE_LIMIT * FOC_VOLTAGE_LIMIT - vd * vd;
+    if (vq * vq > vq_max_sq) {
+        float vq_max = sqrtf(vq_max_sq);
+        vq = (vq > 0.0f) ? vq_max : -vq_max;
+    }
+    foc->vd[k] = vd;
+    foc->vq[k] = vq;
+    
+    // Inverse Park, then SVPWM
+    float v_alpha = c * vd - s * vq;
+    float v_beta = s * vd + c * vq;
+    foc->v_alpha[k] = v_alpha;
+    foc->v_beta[k] = v_beta;
+    foc->sector[k] = svpwm_duties(v_alpha, v_beta, foc->duty[k]);
+}
+
+/**
+ * @brief Reset an axis's flux observer and work out its fixed-point gains
+ * 
+ * The flux starts on the magnet circle at angle zero; it is pulled onto
+ * the true angle once the rotor turns. The PLL is critically damped at
+ * OBSERVER_PLL_BANDWIDTH_HZ: Kp = 2*wn*Ts and Ki = (wn*Ts)^2 per period,
+ * scaled from radians to the 32-bit angle.
+ */
+void flux_observer_configure(flux_observer_t* obs, uint32_t axis) {
+    const float ts = 1.0f / PWM_FREQUENCY;
+    const float flux_unit = OBSERVER_FLUX_ONE / MOTOR_FLUX_LINKAGE;      // Q24 per Wb
+    const float angle_per_radian = 4294967296.0f / (2.0f * (float)M_PI);
+    const float omega_per_rpm = 4294967296.0f * MOTOR_POLE_PAIRS / (60.0f * PWM_FREQUENCY);
+    float wn_ts = 2.0f * (float)M_PI * OBSERVER_PLL_BANDWIDTH_HZ * ts;
+    
+    obs->k_v[axis] = (int32_t)lrintf(DC_BUS_VOLTAGE * ts * flux_unit);
+    obs->k_r[axis] = (int32_t)lrintf(MOTOR_RS * ts * CURRENT_AMPS_PER_COUNT * flux_unit * 65536.0f);
+    obs->k_l[axis] = (int32_t)lrintf(MOTOR_LS * CURRENT_AMPS_PER_COUNT * flux_unit * 65536.0f);
+    obs->k_gamma[axis] = (int32_t)lrintf(OBSERVER_GAIN * ts * OBSERVER_FLUX_ONE);
+    obs->pll_kp[axis] = (int32_t)lrintf(2.0f * wn_ts * angle_per_radian);
+    obs->pll_ki[axis] = (int32_t)lrintf(wn_ts * wn_ts * angle_per_radian);
+    obs->lock_omega = (int32_t)lrintf(OBSERVER_LOCK_RPM * omega_per_rpm);
+    obs->unlock_omega = (int32_t)lrintf(OBSERVER_UNLOCK_RPM * omega_per_rpm);
+    
+    obs->flux_alpha[axis] = OBSERVER_FLUX_ONE;
+    obs->flux_beta[axis] = 0;
+    obs->v_alpha[axis] = 0;
+    obs->v_beta[axis] = 0;
+    obs->theta[axis] = 0;
+    obs->omega[axis] = 0;
+    obs->locked[axis] = false;
+}
+
+/**
+ * @brief One flux observer and PLL step for one axis (integer only)
+ * 
+ * The voltage across the last period is half the command from two cycles
+ * back and half the last one, because duties load at the timer update
+ * half a period after they are computed.
+ * @param ia, ib Phase A/B currents (ADC counts, offset removed)
+ * @param v_alpha, v_beta Last commanded voltage (fraction of Vdc)
+ * @return Rotor electrical angle at this sample
+ */
+static inline uint32_t flux_observer_step(flux_observer_t* obs, uint32_t k, int32_t ia, int32_t ib,
+                                          float v_alpha, float v_beta) {
+    // Clarke in Q16 counts
+    int32_t i_alpha = ia * 65536;
+    int32_t i_beta = (ia + 2 * ib) * 37837;          // 65536 / sqrt(3)
+    
+    int32_t va = (int32_t)(v_alpha * 2147483648.0f);
+    int32_t vb = (int32_t)(v_beta * 2147483648.0f);
+    int64_t ua = ((int64_t)obs->v_alpha[k] + va) >> 1;
+    int64_t ub = ((int64_t)obs->v_beta[k] + vb) >> 1;
+    obs->v_alpha[k] = va;
+    obs->v_beta[k] = vb;
+    
+    // Stator flux: integral of v - R*i
+    int32_t flux_a = obs->flux_alpha[k] + (int32_t)((ua * obs->k_v[k]) >> 31) -
+                     (int32_t)(((int64_t)i_alpha * obs->k_r[k]) >> 32);
+    int32_t flux_b = obs->flux_beta[k] + (int32_t)((ub * obs->k_v[k]) >> 31) -
+                     (int32_t)(((int64_t)i_beta * obs->k_r[k]) >> 32);
+    
+    // Magnet flux, and its pull back onto the circle of radius one
+    int32_t eta_a = flux_a - (int32_t)(((int64_t)i_alpha * obs->k_l[k]) >> 32);
+    int32_t eta_b = flux_b - (int32_t)(((int64_t)i_beta * obs->k_l[k]) >> 32);
+    int32_t radius_sq = (int32_t)(((int64_t)eta_a * eta_a + (int64_t)eta_b * eta_b) >>
+                                  OBSERVER_FLUX_SHIFT);
+    int64_t pull = ((int64_t)(OBSERVER_FLUX_ONE - radius_sq) * obs->k_gamma[k]) >>
+                   OBSERVER_FLUX_SHIFT;
+    obs->flux_alpha[k] = flux_a + (int32_t)((eta_a * pull) >> OBSERVER_FLUX_SHIFT);
+    obs->flux_beta[k] = flux_b + (int32_t)((eta_b * pull) >> OBSERVER_FLUX_SHIFT);
+    
+    // PLL: the cross product with the predicted angle is sin(error), Q24
+    int32_t s, c;
+    fast_sincos_q15(obs->theta[k], &s, &c);
+    int32_t error = (int32_t)(((int64_t)eta_b * c - (int64_t)eta_a * s) >> 15);
+    int32_t omega = obs->omega[k] + (int32_t)(((int64_t)error * obs->pll_ki[k]) >>
+                                              OBSERVER_FLUX_SHIFT);
+    uint32_t theta = obs->theta[k] + (uint32_t)(int32_t)(((int64_t)error * obs->pll_kp[k]) >>
+                                                         OBSERVER_FLUX_SHIFT);
+    obs->omega[k] = omega;
+    obs->theta[k] = theta + (uint32_t)omega;
+    
+    int32_t speed = omega < 0 ? -omega : omega;
+    if (speed > obs->lock_omega) {
+        obs->locked[k] = true;
+    } else if (speed < obs->unlock_omega) {
+        obs->locked[k] = false;
+    }
+    return theta;
+}
+
+/**
+ * @brief Flux observer speed estimate in rpm
+ */
+float flux_observer_velocity(const flux_observer_t* obs, uint32_t axis) {
+    return (float)obs->omega[axis] *
+           (60.0f * PWM_FREQUENCY / (4294967296.0f * MOTOR_POLE_PAIRS));
+}
+
+/**
+ * @brief Current loops of axes 0 to axis_count-1 in one pass
+ * 
+ * The ADC converts the axes in order and DMA stores each sample as it
+ * completes. Each axis first reads its encoder and looks up the sine and
+ * cosine of its angle, which needs no samples and so overlaps the
+ * conversion of its pair; it then waits for the pair and runs the loop
+ * while the later axes are still converting. Consumed samples are set back
+ * to ADC_SAMPLE_PENDING. An axis whose pair never arrives keeps its last
+ * duties and is counted in sample_timeouts. The flux observer runs on every
+ * axis; a sensorless axis switches to its angle once it has locked.
+ */
+void foc_current_loop_batch(foc_batch_t* foc, uint32_t axis_count) {
+    for (uint32_t k = 0; k < axis_count; k++) {
+        // Extend the counter every PWM period; with 2^14 counts per turn the
+        // low 32 bits of the count give the angle directly
+        int64_t count = encoder_extend(&motors[k].encoder,
+                                       (uint16_t)__HAL_TIM_GET_COUNTER(&htim_encoder[k]));
+        uint32_t theta = (uint32_t)count * ENCODER_ANGLE_SCALE * MOTOR_POLE_PAIRS;
+        float s, c;
+        fast_sincos(theta, &s, &c);
+        foc->theta[k] = theta;
+        
+        // DMA writes in scan order, so phase B landing means both have
+        volatile uint16_t* pair = &current_samples[2 * k];
+        uint32_t polls = ADC_SAMPLE_WAIT_LIMIT;
+        while (pair[1] == ADC_SAMPLE_PENDING && --polls != 0) {
+        }
+        if (polls == 0) {
+            foc->sample_timeouts++;
+            continue;
+        }
+        int32_t adc_a = pair[0];
+        int32_t adc_b = pair[1];
+        pair[0] = ADC_SAMPLE_PENDING;
+        pair[1] = ADC_SAMPLE_PENDING;
+        
+        if (motors[k].state == MOTOR_STATE_FAULT) {
+            foc->id_integral[k] = 0.0f;
+            foc->iq_integral[k] = 0.0f;
+            flux_observers.locked[k] = false;
+            continue;
+        }
+        
+        uint32_t estimate = flux_observer_step(&flux_observers, k,
+                                               adc_a - foc->adc_offset[0][k],
+                                               adc_b - foc->adc_offset[1][k],
+                                               foc->v_alpha[k], foc->v_beta[k]);
+        if (motors[k].sensorless && flux_observers.locked[k]) {
+            foc->theta[k] = estimate;
+            fast_sincos(estimate, &s, &c);
+        }
+        foc_axis_step(foc, k, adc_a, adc_b, s, c);
+        update_3phase_pwm(k, foc->duty[k]);
+    }
+}
+
+/**
+ * @brief Reference SVM using cosf and min/max common-mode injection
+ * 
+ * The original implementation, kept to check and time the fast path.
+ * @param angle Electrical angle in radians
+ */
+void space_vector_modulation_libm(float voltage_magnitude, float angle, float* duties) {
+    // Convert to 3-phase voltages
+    float va = voltage_magnitude * cosf(angle);
+    float vb = voltage_magnitude * cosf(angle - 2.0f * M_PI / 3.0f);
+    float vc = voltage_magnitude * cosf(angle + 2.0f * M_PI / 3.0f);
+    
+    // Find min and max for centering
+    float vmin = fminf(fminf(va, vb), vc);
+    float vmax = fmaxf(fmaxf(va, vb), vc);
+    float vcom = (vmin + vmax) / 2.0f;
+    
+    // Generate centered PWM duties
+    duties[0] = (va - vcom + 1.0f) / 2.0f;  // Phase A
+    duties[1] = (vb - vcom + 1.0f) / 2.0f;  // Phase B
+    duties[2] = (vc - vcom + 1.0f) / 2.0f;  // Phase C
+    
+    // Clamp to valid range
+    for (int i = 0; i < 3; i++) {
+        if (duties[i] < 0.0f) duties[i] = 0.0f;
+        if (duties[i] > 1.0f) duties[i] = 1.0f;
+    }
+}
+
+/**
+ * @brief Software limits, checked by the supervisor task
+ * 
+ * Cheap compares only; temperature is polled by motor_thermal_check().
+ */
+bool check_safety_limits(motor_control_t* ctrl) {
+    bool safe = true;
+    
+    // Current limit check (sustained torque current; peaks are caught by
+    // the break input and analog watchdog)
+    if (fabsf(ctrl->current) > ctrl->max_current) {
+        ctrl->faults.overcurrent = true;
+        safe = false;
+    }
+    
+    // Velocity limit check
+    if (fabsf(ctrl->velocity) > ctrl->max_velocity) {
+        ctrl->faults.overspeed = true;
+        safe = false;
+    }
+    
+    // Position limit check
+    if (ctrl->position < ctrl->position_limit_min || 
+        ctrl->position > ctrl->position_limit_max) {
+        ctrl->faults.position_limit = true;
+        safe = false;
+    }
+    
+    return safe;
+}
+
+#ifdef HOST_BUILD
+/**
+ * @brief Host benchmark: PID cycles per call, float and Q31
+ * 
+ * Drives a first-order plant with a square-wave setpoint large enough to
+ * saturate the output, so the anti-windup path is exercised, and reports
+ * the largest difference between the float and Q31 closed loops. Q31 full
+ * scale is 2.0 plant units; gains are ratios, so they need no rescaling.
+ */
+void benchmark_pid(void) {
+    #define PID_BENCH_CALLS 1000000
+    const float tf = 4.0f / CONTROL_FREQUENCY;
+    pid_controller_t pid_f;
+    pid_q31_t pid_q;
+    float y_f = 0.0f, y_q = 0.0f, max_diff = 0.0f;
+    uint32_t float_cycles = 0, q31_cycles = 0;
+    
+    pid_configure(&pid_f, 2.0f, 200.0f, 0.001f, tf, CONTROL_FREQUENCY, -0.5f, 0.5f);
+    pid_configure_q31(&pid_q, 2.0f, 200.0f, 0.001f, tf, CONTROL_FREQUENCY, -0.25f, 0.25f);
+    
+    for (uint32_t n = 0; n < PID_BENCH_CALLS; n++) {
+        float setpoint = ((n >> 11) & 1) ? 0.6f : -0.2f;
+        int32_t e = (int32_t)((setpoint - y_q) * 1073741824.0f);
+        
+        uint32_t start = control_cycle_count();
+        float u_f = pid_compute(&pid_f, setpoint - y_f);
+        uint32_t mid = control_cycle_count();
+        int32_t u_q = pid_compute_q31(&pid_q, e);
+        uint32_t end = control_cycle_count();
+        float_cycles += mid - start;
+        q31_cycles += end - mid;
+        
+        y_f += 0.05f * (u_f - y_f);
+        y_q += 0.05f * (u_q * (2.0f / 2147483648.0f) - y_q);
+        float diff = fabsf(y_q - y_f);
+        if (diff > max_diff) max_diff = diff;
+    }
+    
+    // Per-call timing includes the counter read, so compare by difference
+    printf("PID benchmark (%d calls)\n", PID_BENCH_CALLS);
+    printf("  float: %.1f cycles/call\n", (float)float_cycles / PID_BENCH_CALLS);
+    printf("  Q31:   %.1f cycles/call\n", (float)q31_cycles / PID_BENCH_CALLS);
+    printf("  max float/Q31 closed-loop difference: %.2e\n", max_diff);
+}
+
+/**
+ * @brief Host benchmark: batched current loops, total and per axis
+ * 
+ * Runs foc_current_loop_batch, flux observers included, over 1 to
+ * MOTOR_AXIS_COUNT axes with synthetic phase currents for a rotating
+ * field, so every SVPWM sector and the voltage limit are exercised. Every
+ * sample is in place before the call, so this is the computation alone;
+ * on target the later axes convert while the earlier ones compute, and
+ * foc_get_timing() gives the whole figure, which must stay well under one
+ * PWM period.
+ */
+void benchmark_foc_batch(void) {
+    #define FOC_BENCH_CALLS 200000
+    
+    fast_trig_init();
+    memset(&foc_axes, 0, sizeof(foc_axes));
+    for (uint32_t k = 0; k < MOTOR_AXIS_COUNT; k++) {
+        foc_configure(&foc_axes, k);
+        flux_observer_configure(&flux_observers, k);
+        foc_axes.iq_ref[k] = 3.0f;
+        encoder_configure(&motors[k].encoder, ENCODER_PLL_BANDWIDTH_HZ, CONTROL_FREQUENCY, 0);
+        motors[k].state = MOTOR_STATE_READY;
+    }
+    
+    printf("FOC current loops, batched (%d ticks)\n", FOC_BENCH_CALLS);
+    for (uint32_t axes = 1; axes <= MOTOR_AXIS_COUNT; axes++) {
+        uint32_t total = 0, worst = 0;
+        
+        for (uint32_t n = 0; n < FOC_BENCH_CALLS; n++) {
+            for (uint32_t k = 0; k < axes; k++) {
+                // 23 counts is about 2 electrical degrees per step
+                uint16_t hw = (uint16_t)(n * 23u + k * 1000u);
+                float radians = (float)hw * (2.0f * (float)M_PI * MOTOR_POLE_PAIRS /
+                                             ENCODER_COUNTS_PER_REV);
+                __HAL_TIM_SET_COUNTER(&htim_encoder[k], hw);
+                current_samples[2 * k] = (uint16_t)(ADC_CURRENT_OFFSET +
+                                                    (int32_t)(300.0f * cosf(radians)));
+                current_samples[2 * k + 1] = (uint16_t)(ADC_CURRENT_OFFSET +
+                                                        (int32_t)(300.0f * cosf(radians - 2.0943951f)));
+            }
+            
+            uint32_t start = control_cycle_count();
+            foc_current_loop_batch(&foc_axes, axes);
+            uint32_t cycles = control_cycle_count() - start;
+            total += cycles;
+            if (cycles > worst) worst = cycles;
+        }
+        
+        float average = (float)total / FOC_BENCH_CALLS;
+        printf("  %u %s: average %.1f cycles (%.1f per axis), worst %lu\n", (unsigned)axes,
+               axes == 1 ? "axis" : "axes", average, average / axes, (unsigned long)worst);
+    }
+}
+
+/**
+ * @brief Host benchmark: table/sector SVM against the cosf reference
+ * 
+ * Sweeps the electrical angle in the linear modulation range and reports
+ * cycles per call for both paths and the largest duty difference. Timing
+ * uses the TSC, so compare the paths by ratio rather than absolute cycles.
+ */
+void benchmark_svm_paths(void) {
+    #define SVM_BENCH_CALLS 200000
+    float duties[3], reference[3];
+    volatile float sink = 0.0f;
+    float max_error = 0.0f;
+    
+    fast_trig_init();
+    
+    uint32_t start = control_cycle_count();
+    for (uint32_t n = 0; n < SVM_BENCH_CALLS; n++) {
+        space_vector_modulation_libm(1.1f, (float)n * 0.001f, duties);
+        sink += duties[0];
+    }
+    uint32_t libm_cycles = control_cycle_count() - start;
+    
+    start = control_cycle_count();
+    for (uint32_t n = 0; n < SVM_BENCH_CALLS; n++) {
+        space_vector_modulation(1.1f, n * 683565u, duties);   // 0.001 rad steps
+        sink += duties[0];
+    }
+    uint32_t fast_cycles = control_cycle_count() - start;
+    
+    for (uint32_t n = 0; n < 3600; n++) {
+        float radians = (float)n * (2.0f * (float)M_PI / 3600.0f);
+        space_vector_modulation_libm(1.1f, radians, reference);
+        space_vector_modulation(1.1f, (uint32_t)(n * (4294967296.0 / 3600.0)), duties);
+        for (int i = 0; i < 3; i++) {
+            float e = fabsf(duties[i] - reference[i]);
+            if (e > max_error) max_error = e;
+        }
+    }
+    
+    float libm_per_call = (float)libm_cycles / SVM_BENCH_CALLS;
+    float fast_per_call = (float)fast_cycles / SVM_BENCH_CALLS;
+    printf("SVM benchmark (%d calls)\n", SVM_BENCH_CALLS);
+    printf("  cosf + min/max:  %.1f cycles/call\n", libm_per_call);
+    printf("  table + sector:  %.1f cycles/call\n", fast_per_call);
+    printf("  speedup:         %.1fx, max duty difference %.2e\n",
+           libm_per_call / fast_per_call, max_error);
+    (void)sink;
+}
+
+/**
+ * @brief Host check: encoder observer against the old filtered difference
+ * 
+ * Replays a speed profile through a wrapping 16-bit counter at
+ * CONTROL_FREQUENCY: 5rpm creep (under one count per tick), a ramp to
+ * 3000rpm and a hold. Reports RMS velocity error in each phase for both
+ * estimators, observer cycles per call, and checks the extended count
+ * against the true count after many counter wraps.
+ * @return 0 if the extended count is exact
+ */
+int check_encoder_observer(void) {
+    #define ENCODER_CHECK_TICKS (3 * CONTROL_FREQUENCY)
+    encoder_state_t enc;
+    double angle = 0.0;          // True position (counts)
+    float iir = 0.0f;
+    int64_t last_count = 0;
+    double sq_iir[3] = {0}, sq_pll[3] = {0};
+    uint32_t samples[3] = {0};
+    uint32_t cycles = 0;
+    
+    encoder_configure(&enc, ENCODER_PLL_BANDWIDTH_HZ, CONTROL_FREQUENCY, 0);
+    
+    for (uint32_t n = 0; n < ENCODER_CHECK_TICKS; n++) {
+        float t = (float)n / CONTROL_FREQUENCY;
+        int phase = t < 1.0f ? 0 : t < 1.5f ? 1 : 2;
+        float rpm = phase == 0 ? 5.0f : phase == 1 ? 5.0f + (t - 1.0f) * 5990.0f : 3000.0f;
+        angle += rpm * (ENCODER_COUNTS_PER_REV / 60.0) / CONTROL_FREQUENCY;
+        int64_t true_count = (int64_t)floor(angle);
+        
+        encoder_extend(&enc, (uint16_t)true_count);
+        uint32_t start = control_cycle_count();
+        float pll_rpm = encoder_observer_update(&enc) * (60.0f / ENCODER_COUNTS_PER_REV);
+        cycles += control_cycle_count() - start;
+        
+        // Previous estimator: filtered first difference (alpha 0.1)
+        float raw = (float)(enc.count - last_count) * CONTROL_FREQUENCY * 60.0f /
+                    ENCODER_COUNTS_PER_REV;
+        iir = 0.1f * raw + 0.9f * iir;
+        last_count = enc.count;
+        
+        if (t > 0.2f) {          // Skip the start-up transient
+            sq_iir[phase] += (iir - rpm) * (iir - rpm);
+            sq_pll[phase] += (pll_rpm - rpm) * (pll_rpm - rpm);
+            samples[phase]++;
+        }
+    }
+    
+    int64_t expected = (int64_t)floor(angle);
+    const char* names[3] = { "5rpm creep", "ramp to 3000rpm", "3000rpm hold" };
+    printf("Encoder velocity estimators (%d ticks at %dHz, RMS error)\n",
+           ENCODER_CHECK_TICKS, CONTROL_FREQUENCY);
+    for (int i = 0; i < 3; i++) {
+        printf("  %-16s IIR %7.2frpm   observer %7.2frpm\n", names[i],
+               sqrt(sq_iir[i] / samples[i]), sqrt(sq_pll[i] / samples[i]));
+    }
+    printf("  observer: %.1f cycles/call; extended count %lld, expected %lld\n",
+           (float)cycles / ENCODER_CHECK_TICKS, (long long)enc.count, (long long)expected);
+    return enc.count == expected ? 0 : 1;
+}
+
+/**
+ * @brief Host check: flux observer on an ideal machine at constant speed
+ * 
+ * Feeds flux_observer_step the ADC-quantised phase currents and the
+ * voltage commands of a motor carrying 2A of torque current, at several
+ * speeds in both directions, from a start angle the observer does not
+ * know. Reports the angle and speed error once settled, the time to lock
+ * and cycles per call; the closed loop is checked in the host simulation.
+ * @return Number of speeds with an angle error over 2 electrical degrees,
+ *         a speed error over 1%, or no lock
+ */
+int check_flux_observer(void) {
+    #define FLUX_CHECK_TICKS (PWM_FREQUENCY / 2)
+    const float speeds[] = { 300.0f, 1000.0f, 3000.0f, -1000.0f };
+    const float ts = 1.0f / PWM_FREQUENCY;
+    const float iq = 2.0f;
+    uint32_t cycles = 0, calls = 0;
+    int failures = 0;
+    
+    fast_trig_init();
+    printf("Flux observer, ideal machine (%dHz, %.1fA torque current)\n", PWM_FREQUENCY, iq);
+    for (uint32_t i = 0; i < sizeof(speeds) / sizeof(speeds[0]); i++) {
+        float omega = speeds[i] * (2.0f * (float)M_PI * MOTOR_POLE_PAIRS / 60.0f);  // rad/s
+        double theta = 2.0;      // True electrical angle (rad)
+        float lock_time = -1.0f, angle_error = 0.0f, speed_error = 0.0f;
+        float command[2] = { 0.0f, 0.0f };
+        
+        flux_observer_configure(&flux_observers, 0);
+        for (uint32_t n = 0; n < FLUX_CHECK_TICKS; n++) {
+            theta += omega * ts;
+            float s = sinf((float)theta), c = cosf((float)theta);
+            int32_t ia = (int32_t)lrintf(-iq * s / CURRENT_AMPS_PER_COUNT);
+            int32_t ib = (int32_t)lrintf(iq * (0.5f * s + 0.8660254f * c) /
+                                         CURRENT_AMPS_PER_COUNT);
+            
+            uint32_t start = control_cycle_count();
+            uint32_t estimate = flux_observer_step(&flux_observers, 0, ia, ib,
+                                                   command[0], command[1]);
+            cycles += control_cycle_count() - start;
+            calls++;
+            
+            // The next command loads half a period from now and is centred a
+            // period from now: v = R*i + j*w*(L*i + flux)
+            float s1 = sinf((float)theta + omega * ts), c1 = cosf((float)theta + omega * ts);
+            float vd = -omega * MOTOR_LS * iq;
+            float vq = MOTOR_RS * iq + omega * MOTOR_FLUX_LINKAGE;
+            command[0] = (c1 * vd - s1 * vq) / DC_BUS_VOLTAGE;
+            command[1] = (s1 * vd + c1 * vq) / DC_BUS_VOLTAGE;
+            
+            if (lock_time < 0.0f && flux_observers.locked[0]) lock_time = n * ts;
+            if (n >= FLUX_CHECK_TICKS / 2) {
+                uint32_t truth = (uint32_t)(int64_t)(theta * (4294967296.0 / (2.0 * M_PI)));
+                float e = fabsf((int32_t)(estimate - truth) * (360.0f / 4294967296.0f));
+                float v = fabsf(flux_observer_velocity(&flux_observers, 0) - speeds[i]);
+                if (e > angle_error) angle_error = e;
+                if (v > speed_error) speed_error = v;
+            }
+        }
+        
+        printf("  %6.0frpm: locked after %5.1fms, angle error %.2f deg (elec), "
+               "speed error %.2frpm\n", speeds[i], lock_time * 1e3f, angle_error, speed_error);
+        if (lock_time < 0.0f || angle_error > 2.0f || speed_error > 0.01f * fabsf(speeds[i])) {
+            printf("  FAILED\n");
+            failures++;
+        }
+    }
+    printf("  %.1f cycles/call\n", (float)cycles / calls);
+    return failures;
+}
+
+/**
+ * @brief Host check: queued S-curve moves against their limits
+ * 
+ * Queues a long move that cruises, a short one that never reaches vmax and
+ * a tiny one that never reaches amax, plays them back at
+ * POSITION_LOOP_FREQUENCY and checks velocity, acceleration and jerk (by
+ * differencing) stay within the limits, the position never jumps, and each
+ * move ends exactly on its target. Reports cycles per trajectory_update.
+ * @return 0 if every check passes
+ */
+int check_trajectory(void) {
+    const float vmax = 3600.0f, amax = 36000.0f, jmax = 1.8e6f;
+    const float targets[] = { 720.0f, 630.0f, 629.5f };
+    const float ts = 1.0f / POSITION_LOOP_FREQUENCY;
+    trajectory_t traj;
+    float worst_v = 0.0f, worst_a = 0.0f, worst_j = 0.0f, worst_step = 0.0f;
+    float last_p = 0.0f, last_a = 0.0f;
+    uint32_t cycles = 0, ticks = 0, reached = 0;
+    
+    trajectory_init(&traj, 0.0f, POSITION_LOOP_FREQUENCY);
+    for (int i = 0; i < 3; i++) {
+        trajectory_queue_move(&traj, targets[i], vmax, amax, jmax);
+    }
+    
+    while (traj.tail != traj.head && ticks < 10 * POSITION_LOOP_FREQUENCY) {
+        uint32_t start = control_cycle_count();
+        trajectory_update(&traj);
+        cycles += control_cycle_count() - start;
+        
+        if (ticks > 0) {
+            float jerk = fabsf(traj.acceleration - last_a) / ts;
+            if (jerk > worst_j) worst_j = jerk;
+            if (fabsf(traj.position - last_p) > worst_step) worst_step = fabsf(traj.position - last_p);
+        }
+        if (fabsf(traj.velocity) > worst_v) worst_v = fabsf(traj.velocity);
+        if (fabsf(traj.acceleration) > worst_a) worst_a = fabsf(traj.acceleration);
+        if (!traj.active && traj.position == targets[reached]) reached++;
+        last_p = traj.position;
+        last_a = traj.acceleration;
+        ticks++;
+    }
+    
+    printf("Trajectory (3 queued moves, %d ticks at %dHz)\n", (int)ticks, POSITION_LOOP_FREQUENCY);
+    printf("  peak velocity %.0f/%.0f deg/s, acceleration %.0f/%.0f deg/s^2, "
+           "jerk %.3g/%.3g deg/s^3\n", worst_v, vmax, worst_a, amax, worst_j, jmax);
+    printf("  largest step %.3fdeg, %u of 3 targets reached exactly, %.1f cycles/update\n",
+           worst_step, (unsigned)reached, (float)cycles / ticks);
+    
+    bool ok = reached == 3 && worst_v <= vmax * 1.001f && worst_a <= amax * 1.001f &&
+              worst_j <= jmax * 1.001f && worst_step <= vmax * ts * 1.001f;
+    return ok ? 0 : 1;
+}
+
+/**
+ * @brief Host benchmark: black box recording cost per snapshot
+ * 
+ * Calls blackbox_record with the decimation forced to fire, so every call
+ * writes a snapshot of every axis.
+ */
+void benchmark_blackbox_record(void) {
+    #define BLACKBOX_BENCH_CALLS 200000
+    uint32_t total = 0, worst = 0;
+    
+    blackbox.state = BLACKBOX_RECORDING;
+    blackbox.write_index = 0;
+    blackbox.recorded = 0;
+    for (uint32_t n = 0; n < BLACKBOX_BENCH_CALLS; n++) {
+        motors[n % MOTOR_AXIS_COUNT].velocity = (float)(n & 1023);
+        blackbox.decimate_count = 1;
+        uint32_t start = control_cycle_count();
+        blackbox_record();
+        uint32_t cycles = control_cycle_count() - start;
+        total += cycles;
+        if (cycles > worst) worst = cycles;
+    }
+    
+    float average = (float)total / BLACKBOX_BENCH_CALLS;
+    printf("Black box snapshot (%d calls, %d axes)\n", BLACKBOX_BENCH_CALLS, MOTOR_AXIS_COUNT);
+    printf("  average %.1f cycles (%.1f per axis), worst %lu\n", average,
+           average / MOTOR_AXIS_COUNT, (unsigned long)worst);
+}
+
+/**
+ * @brief Host benchmark: telemetry capture cost per control tick
+ * 
+ * Keeps the scope armed on a level that is never crossed, so every call
+ * stores a sample and evaluates the trigger (the worst case). Each call is
+ * timed on its own, so the pair of counter reads is timed the same way
+ * around nothing and subtracted; it is host-dependent (tens of cycles for
+ * the TSC, more under virtualisation) and often larger than the capture.
+ */
+void benchmark_telemetry_capture(void) {
+    #define TELEMETRY_BENCH_CALLS 200000
+    static const telemetry_channel_t channels[TELEMETRY_MAX_CHANNELS] = {
+        TELEM_VELOCITY_SETPOINT, TELEM_VELOCITY, TELEM_IQ_REF, TELEM_IQ,
+        TELEM_VD, TELEM_VQ, TELEM_VELOCITY_INTEGRAL, TELEM_DUTY_A,
+    };
+    uint32_t overhead_total = 0;
+    
+    for (uint32_t n = 0; n < TELEMETRY_BENCH_CALLS; n++) {
+        motors[0].velocity = (float)(n & 1023);
+        uint32_t start = control_cycle_count();
+        overhead_total += control_cycle_count() - start;
+    }
+    float overhead = (float)overhead_total / TELEMETRY_BENCH_CALLS;
+    
+    printf("Telemetry capture (%d calls, trigger armed, %.1f cycles of counter reads "
+           "subtracted)\n", TELEMETRY_BENCH_CALLS, overhead);
+    for (uint32_t count = 1; count <= TELEMETRY_MAX_CHANNELS; count *= 2) {
+        uint32_t total = 0;
+        
+        telemetry.state = TELEMETRY_IDLE;
+        telemetry_configure(channels, count, 1, 0);
+        telemetry_arm(TELEM_VELOCITY, 1e9f, TELEMETRY_EDGE_RISING, 0);
+        for (uint32_t n = 0; n < TELEMETRY_BENCH_CALLS; n++) {
+            motors[0].velocity = (float)(n & 1023);
+            uint32_t start = control_cycle_count();
+            telemetry_capture();
+            total += control_cycle_count() - start;
+        }
+        printf("  %u channels: %.1f cycles/tick\n", (unsigned)count,
+               (float)total / TELEMETRY_BENCH_CALLS - overhead);
+    }
+    telemetry.state = TELEMETRY_IDLE;
+}
+#endif
@@ -0,0 +1,1208 @@
+/*
+ * Code Example 48 - Host Motor Simulator
+ * Language: C
+ * Chapter: Chapter_11_Capstone_Projects_Advanced_System_Integration
+ *
+ * Runs the motor controller from code_example_48.c on a PC against a model
+ * of each axis's motor and inverter: PMSM electrical and mechanical
+ * equations, an averaged three-phase bridge, a quadrature encoder quantised
+ * to ENCODER_PPR and 12-bit shunt current samples. The same interrupt
+ * handler that runs on the board is called once per simulated PWM period,
+ * so the current, velocity and position loops of every axis, the SVPWM and
+ * the safety checks all run closed loop in virtual time, as fast as the
+ * host allows.
+ *
+ * Usage:
+ * 1. gcc -O2 -o motor_sim code_example_48_host_sim.c -lm
+ *    (add -DPWM_FREQUENCY=40000 to run every loop at another rate;
+ *    10-40kHz is the useful range. -DMOTOR_AXIS_COUNT=n sets the number
+ *    of axes, default 4)
+ * 2. ./motor_sim [options]
+ *      -m velocity|position|move
+ *                             Step the velocity (rpm) or position (degrees)
+ *                             setpoint of every axis, or queue an S-curve
+ *                             move (degrees) on each (default velocity);
+ *                             axis 0 is measured
+ *      -a amount              Step size (default 300rpm or 90 degrees)
+ *      -v vmax                Move velocity limit (rpm, default 600)
+ *      -t seconds             Simulated time (default 0.5)
+ *      -L torque              Load torque step (Nm) at 60% of the run
+ *      -o trace.csv           Write a trace at the velocity-loop rate
+ *      -T scope.bin           Arm the telemetry scope on the step and save
+ *                             the UART frame stream it sends
+ * 3. ./motor_sim --selftest runs the benchmarks and checks built into
+ *    code_example_48.c and checks both step responses and a planned move
+ *    against fixed limits
+ *    (exit 1 on failure)
+ *
+ * The step report gives rise time, overshoot, settling time and final
+ * error, then the cost of the control interrupt in host cycles and how
+ * much faster than real time the whole simulation ran.
+ */
+
+#define HOST_BUILD
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#ifndef MOTOR_AXIS_COUNT
+#define MOTOR_AXIS_COUNT 4
+#endif
+
+// Host stand-ins for the STM32 HAL and the book's helper functions
+typedef enum { HAL_OK, HAL_ERROR } HAL_StatusTypeDef;
+typedef struct { uint32_t CNT; uint32_t ARR; } TIM_TypeDef;
+typedef struct { TIM_TypeDef* Instance; uint32_t Channel; } TIM_HandleTypeDef;
+typedef struct { uint32_t NDTR; } DMA_HandleTypeDef;
+typedef struct { void* Instance; DMA_HandleTypeDef* DMA_Handle; } ADC_HandleTypeDef;
+typedef struct { void* Instance; } UART_HandleTypeDef;
+
+typedef struct {
+    uint32_t OffStateRunMode, OffStateIDLEMode, LockLevel, DeadTime;
+    uint32_t BreakState, BreakPolarity, AutomaticOutput;
+} TIM_BreakDeadTimeConfigTypeDef;
+
+typedef struct {
+    uint32_t WatchdogMode, HighThreshold, LowThreshold, Channel, ITMode;
+} ADC_AnalogWDGConfTypeDef;
+
+typedef enum {
+    MOTOR_STATE_READY,
+    MOTOR_STATE_POSITION_CONTROL,
+    MOTOR_STATE_FAULT
+} motor_state_t;
+
+typedef struct {
+    bool overcurrent;
+    bool overspeed;
+    bool position_limit;
+    bool overtemperature;
+} fault_flags_t;
+
+#define ADC_CURRENT ((void*)1)
+#define USART_TELEMETRY ((void*)2)
+#define ADC_EXTERNALTRIGCONV_T8_TRGO 0
+#define TIM_CHANNEL_4 0x0C
+#define HAL_TIM_ACTIVE_CHANNEL_4 0x08
+#define MAX_MOTOR_TEMPERATURE 100.0f
+#define ENABLE 1
+#define TIM_OSSR_ENABLE 1
+#define TIM_OSSI_ENABLE 1
+#define TIM_LOCKLEVEL_OFF 0
+#define TIM_BREAK_ENABLE 1
+#define TIM_BREAKPOLARITY_HIGH 1
+#define TIM_AUTOMATICOUTPUT_DISABLE 0
+#define TIM_IT_BREAK 0x80
+#define ADC_ANALOGWATCHDOG_ALL_REG 1
+#define __HAL_TIM_GET_COUNTER(h) ((h)->Instance->CNT)
+#define __HAL_TIM_SET_COUNTER(h, n) ((h)->Instance->CNT = (n))
+#define __HAL_TIM_GET_AUTORELOAD(h) ((h)->Instance->ARR)
+#define __HAL_TIM_ENABLE_IT(h, it) ((void)(h), (void)(it))
+#define __HAL_DMA_GET_COUNTER(h) ((h)->NDTR)
+#define __HAL_TIM_MOE_DISABLE_UNCONDITIONALLY(h) sim_outputs_off((uint32_t)((h) - htim_pwm))
+#define __HAL_RCC_PWR_CLK_ENABLE() ((void)0)
+#define __HAL_RCC_BKPSRAM_CLK_ENABLE() ((void)0)
+#define HAL_PWR_EnableBkUpAccess() ((void)0)
+#define HAL_PWREx_EnableBkUpReg() ((void)0)
+#define BKPSRAM_BASE ((uintptr_t)sim_backup_sram)
+
+static uint32_t __get_PRIMASK(void) {
+    return 0;
+}
+
+static void __set_PRIMASK(uint32_t primask) {
+    (void)primask;
+}
+
+static void __disable_irq(void) {
+}
+
+// One encoder and one PWM timer per axis; htim_pwm[0] is the master
+static TIM_TypeDef encoder_timers[MOTOR_AXIS_COUNT];
+static TIM_TypeDef pwm_timers[MOTOR_AXIS_COUNT];
+static TIM_HandleTypeDef htim_encoder[MOTOR_AXIS_COUNT];
+static TIM_HandleTypeDef htim_pwm[MOTOR_AXIS_COUNT];
+static DMA_HandleTypeDef hdma_current;
+static ADC_HandleTypeDef hadc_current = { ADC_CURRENT, &hdma_current };
+static UART_HandleTypeDef huart_telemetry = { USART_TELEMETRY };
+static uint32_t sim_backup_sram[4096 / 4];    // Kept across sim_reset, as through a reset
+static uint32_t SystemCoreClock = 168000000;   // Set to the host tick rate in main()
+
+// Motor and inverter model (SI units, rotor d/q frame)
+#define SIM_FLUX_LINKAGE 0.008f     // Permanent magnet flux (Wb), Kt = 1.5 * p * flux
+#define SIM_INERTIA 0.00005f        // Rotor plus load (kg m^2)
+#define SIM_VISCOUS_DAMPING 0.00002f // (Nm s/rad)
+#define SIM_STEP_RATE 160000.0f     // Plant integration rate (Hz)
+#define SIM_ADC_NOISE_LSB 1.0f      // RMS noise on each current sample
+#define SIM_TEMPERATURE 40.0f
+#define SIM_ADC_CONVERSION_US 1.0f  // Conversion time of one axis's pair of samples
+
+// Limits for queued moves (-m move); the velocity limit is set with -v
+#define SIM_MOVE_ACCELERATION 36000.0f   // deg/s^2 (about 0.65A of feedforward)
+#define SIM_MOVE_JERK 1.8e6f             // deg/s^3 (peak acceleration in 20ms)
+
+static float sim_move_velocity = 600.0f; // rpm
+static bool sim_sensorless = false;      // Run every axis on the flux observer (-s)
+
+typedef struct {
+    float id, iq;                // Winding currents (A)
+    float omega;                 // Mechanical speed (rad/s)
+    double angle;                // Mechanical angle (rad), unwrapped
+    float load_torque;           // (Nm)
+    float duties[3];             // Duties latched at the last PWM update
+    float pending[3];            // Written by update_3phase_pwm, latched mid-period
+    bool outputs_enabled;
+    uint32_t noise_seed;
+    float inductance;            // MOTOR_LS, lowered to model a shorted winding
+
+    // Protection model
+    bool break_fitted;           // Overcurrent comparator wired to BKIN
+    bool break_enabled;          // Set by HAL_TIMEx_ConfigBreakDeadTime
+    double crossed_watchdog_at;  // First phase current beyond each trip level
+    double crossed_break_at;
+    double outputs_off_at;
+    float peak_current;          // Largest phase current while driven
+} motor_plant_t;
+
+static motor_plant_t plants[MOTOR_AXIS_COUNT];
+static double sim_time;                      // Virtual time (s)
+static uint32_t window_low, window_high;     // Analog watchdog thresholds (counts)
+
+static void sim_outputs_off(uint32_t axis) {
+    if (plants[axis].outputs_enabled) {
+        plants[axis].outputs_enabled = false;
+        plants[axis].outputs_off_at = sim_time;
+    }
+}
+
+uint32_t HAL_GetTick(void);
+
+HAL_StatusTypeDef HAL_TIMEx_ConfigBreakDeadTime(TIM_HandleTypeDef* htim,
+                                                TIM_BreakDeadTimeConfigTypeDef* config) {
+    plants[htim - htim_pwm].break_enabled = config->BreakState == TIM_BREAK_ENABLE;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_ADC_AnalogWDGConfig(ADC_HandleTypeDef* hadc,
+                                          ADC_AnalogWDGConfTypeDef* config) {
+    (void)hadc;
+    window_low = config->LowThreshold;
+    window_high = config->HighThreshold;
+    return HAL_OK;
+}
+
+void configure_encoder_interface(uint32_t ppr) {
+    (void)ppr;
+}
+
+void configure_3phase_pwm(uint32_t frequency) {
+    (void)frequency;
+}
+
+void configure_current_sense_adc(uint32_t trigger) {
+    (void)trigger;
+}
+
+// Circular ADC DMA target, filled by sim_sample
+static volatile uint16_t* adc_dma_buffer;
+
+HAL_StatusTypeDef HAL_ADC_Start_DMA(ADC_HandleTypeDef* hadc, uint32_t* data, uint32_t length) {
+    adc_dma_buffer = (volatile uint16_t*)data;
+    hadc->DMA_Handle->NDTR = length;
+    return HAL_OK;
+}
+
+// Watchdog axis checks: a scan sample driven to full scale, and how many
+// pairs the current loops have taken when the watchdog interrupt is entered
+static int32_t sim_forced_sample = -1;
+static uint32_t sim_pairs_taken;
+
+HAL_StatusTypeDef HAL_TIM_OC_Start_IT(TIM_HandleTypeDef* htim, uint32_t channel) {
+    (void)htim;
+    (void)channel;
+    return HAL_OK;
+}
+
+void update_3phase_pwm(uint32_t axis, float* duties) {
+    memcpy(plants[axis].pending, duties, sizeof(plants[axis].pending));
+}
+
+void disable_motor_outputs(uint32_t axis) {
+    sim_outputs_off(axis);
+}
+
+float read_motor_temperature(uint32_t axis) {
+    (void)axis;
+    return SIM_TEMPERATURE;
+}
+
+// Telemetry UART: bytes are collected, and the DMA completes after the
+// frame's time on the wire in virtual time
+static uint8_t* uart_stream;
+static size_t uart_stream_size, uart_stream_capacity;
+static uint32_t uart_baud_rate;
+static int64_t uart_bits_pending;        // Bits left on the wire for the frame in flight
+
+void configure_telemetry_uart(uint32_t baud_rate) {
+    uart_baud_rate = baud_rate;
+}
+
+HAL_StatusTypeDef HAL_UART_Transmit_DMA(UART_HandleTypeDef* huart, uint8_t* data,
+                                        uint16_t size) {
+    (void)huart;
+    if (uart_stream_size + size > uart_stream_capacity) {
+        uart_stream_capacity = 2 * (uart_stream_size + size);
+        uart_stream = realloc(uart_stream, uart_stream_capacity);
+    }
+    memcpy(uart_stream + uart_stream_size, data, size);
+    uart_stream_size += size;
+    uart_bits_pending = (int64_t)size * 10;  // Start, 8 data, stop
+    return HAL_OK;
+}
+
+#include "code_example_48.c"
+
+/**
+ * @brief Gaussian-ish noise from a fixed-seed LCG, so runs are repeatable
+ */
+static float sim_noise(motor_plant_t* p) {
+    float sum = 0.0f;
+    for (int i = 0; i < 4; i++) {
+        p->noise_seed = p->noise_seed * 1664525u + 1013904223u;
+        sum += (float)(p->noise_seed >> 8) * (1.0f / 16777216.0f) - 0.5f;
+    }
+    return sum * 1.7320508f;     // Unit variance
+}
+
+static void sim_reset(bool break_fitted) {
+    memset(plants, 0, sizeof(plants));
+    for (uint32_t k = 0; k < MOTOR_AXIS_COUNT; k++) {
+        motor_plant_t* p = &plants[k];
+        for (int i = 0; i < 3; i++) {
+            p->duties[i] = p->pending[i] = 0.5f;
+        }
+        p->outputs_enabled = true;
+        p->noise_seed = 12345 + k;
+        p->break_fitted = break_fitted;
+        p->inductance = MOTOR_LS;
+        p->crossed_watchdog_at = -1.0;
+        p->crossed_break_at = -1.0;
+        p->outputs_off_at = -1.0;
+        encoder_timers[k].CNT = 0;
+        pwm_timers[k].ARR = PWM_TIMER_CLOCK / (2 * PWM_FREQUENCY);   // Centre-aligned
+        htim_encoder[k].Instance = &encoder_timers[k];
+        htim_pwm[k].Instance = &pwm_timers[k];
+    }
+    htim_pwm[0].Channel = HAL_TIM_ACTIVE_CHANNEL_4;
+    sim_time = 0.0;
+}
+
+uint32_t HAL_GetTick(void) {
+    return (uint32_t)(sim_time * 1000.0);
+}
+
+/**
+ * @brief Advance one axis's plant by dt seconds with the latched duties
+ *
+ * The bridge is averaged over the PWM period: each phase sits at duty*Vdc
+ * and the star point at the mean of the three. With the outputs disabled
+ * the bridge is treated as open and the currents are zeroed.
+ */
+static void sim_step(uint32_t axis, float dt) {
+    motor_plant_t* p = &plants[axis];
+    float elec = (float)fmod(p->angle * MOTOR_POLE_PAIRS, 2.0 * M_PI);
+    float s = sinf(elec), c = cosf(elec);
+    float omega_e = p->omega * MOTOR_POLE_PAIRS;
+
+    if (p->outputs_enabled) {
+        float mean = (p->duties[0] + p->duties[1] + p->duties[2]) / 3.0f;
+        float va = (p->duties[0] - mean) * DC_BUS_VOLTAGE;
+        float vb = (p->duties[1] - mean) * DC_BUS_VOLTAGE;
+        float vc = (p->duties[2] - mean) * DC_BUS_VOLTAGE;
+        float v_alpha = (2.0f * va - vb - vc) / 3.0f;
+        float v_beta = (vb - vc) * 0.57735027f;
+        float vd = c * v_alpha + s * v_beta;
+        float vq = c * v_beta - s * v_alpha;
+
+        // Semi-implicit Euler: the resistive term is taken at the new current
+        float l = p->inductance;
+        float k = 1.0f / (1.0f + dt * MOTOR_RS / l);
+        float id = (p->id + dt / l * (vd + omega_e * l * p->iq)) * k;
+        float iq = (p->iq + dt / l * (vq - omega_e * l * p->id -
+                                      omega_e * SIM_FLUX_LINKAGE)) * k;
+        p->id = id;
+        p->iq = iq;
+    } else {
+        p->id = 0.0f;
+        p->iq = 0.0f;
+    }
+
+    // Phase currents against the trip levels at the end of the step. The
+    // comparator on the break input acts within this step, as the hardware
+    // does within microseconds.
+    double now = sim_time + dt;
+    float i_alpha = c * p->id - s * p->iq;
+    float i_beta = s * p->id + c * p->iq;
+    float ib = -0.5f * i_alpha + 0.8660254f * i_beta;
+    float peak = fmaxf(fmaxf(fabsf(i_alpha), fabsf(ib)), fabsf(i_alpha + ib));
+    if (p->outputs_enabled) {
+        if (peak > p->peak_current) p->peak_current = peak;
+        if (peak > OVERCURRENT_TRIP_AMPS && p->crossed_watchdog_at < 0.0) {
+            p->crossed_watchdog_at = now;
+        }
+        if (peak > BREAK_TRIP_AMPS && p->crossed_break_at < 0.0) {
+            p->crossed_break_at = now;
+        }
+        if (peak > BREAK_TRIP_AMPS && p->break_fitted && p->break_enabled) {
+            p->outputs_enabled = false;
+            p->outputs_off_at = now;
+            HAL_TIMEx_BreakCallback(&htim_pwm[axis]);
+        }
+    }
+
+    float torque = 1.5f * MOTOR_POLE_PAIRS * SIM_FLUX_LINKAGE * p->iq;
+    float accel = (torque - SIM_VISCOUS_DAMPING * p->omega - p->load_torque) / SIM_INERTIA;
+    p->omega += accel * dt;
+    p->angle += p->omega * dt;
+}
+
+/**
+ * @brief Sample the sensors the way the board does at the PWM centre
+ *
+ * The scan converts the axes in order and DMA stores each sample. The
+ * first sample outside the analog watchdog window raises its interrupt,
+ * which runs before the next conversion lands; by then the current loops
+ * have taken sim_pairs_taken of the earlier pairs (cleared to
+ * ADC_SAMPLE_PENDING for the interrupt, then put back). Every pair lands
+ * before the control interrupt runs, which only removes the wait the board
+ * overlaps with computation.
+ */
+static void sim_sample(void) {
+    bool tripped = false;
+
+    for (uint32_t k = 0; k < MOTOR_AXIS_COUNT; k++) {
+        motor_plant_t* p = &plants[k];
+        float elec = (float)fmod(p->angle * MOTOR_POLE_PAIRS, 2.0 * M_PI);
+        float s = sinf(elec), c = cosf(elec);
+        float i_alpha = c * p->id - s * p->iq;
+        float i_beta = s * p->id + c * p->iq;
+        float phase[2] = { i_alpha, -0.5f * i_alpha + 0.8660254f * i_beta };
+
+        for (int i = 0; i < 2; i++) {
+            float counts = ADC_CURRENT_OFFSET + phase[i] / CURRENT_AMPS_PER_COUNT +
+                           SIM_ADC_NOISE_LSB * sim_noise(p);
+            long code = lrintf(counts);
+            uint16_t sample = (uint16_t)(code < 0 ? 0 : code > 4095 ? 4095 : code);
+            uint32_t index = 2 * k + i;
+            if ((int32_t)index == sim_forced_sample) sample = 4095;
+            adc_dma_buffer[index] = sample;
+            hdma_current.NDTR = 2 * MOTOR_AXIS_COUNT - (index + 1);
+            if (hdma_current.NDTR == 0) hdma_current.NDTR = 2 * MOTOR_AXIS_COUNT;
+
+            if ((sample > window_high || sample < window_low) && !tripped) {
+                // The master PWM counter has counted down from its peak
+                // while the scan reached the offending pair
+                tripped = true;
+                pwm_timers[0].CNT = pwm_timers[0].ARR -
+                    (uint32_t)((k + 1) * SIM_ADC_CONVERSION_US * 1e-6f * PWM_TIMER_CLOCK);
+                uint16_t taken[2 * MOTOR_AXIS_COUNT];
+                uint32_t pairs = sim_pairs_taken < MOTOR_AXIS_COUNT ? sim_pairs_taken
+                                                                    : MOTOR_AXIS_COUNT;
+                for (uint32_t n = 0; n < 2 * pairs; n++) {
+                    taken[n] = adc_dma_buffer[n];
+                    adc_dma_buffer[n] = ADC_SAMPLE_PENDING;
+                }
+                HAL_ADC_LevelOutOfWindowCallback(&hadc_current);
+                for (uint32_t n = 0; n < 2 * pairs; n++) {
+                    adc_dma_buffer[n] = taken[n];
+                }
+            }
+        }
+
+        // Quadrature counter: floor of the angle in counts, two's complement wrap
+        double counts = floor(p->angle / (2.0 * M_PI) * ENCODER_COUNTS_PER_REV);
+        encoder_timers[k].CNT = (uint16_t)(int64_t)counts;   // 16-bit timer
+    }
+
+    if (!tripped) {
+        pwm_timers[0].CNT = pwm_timers[0].ARR -
+                            (uint32_t)(SIM_ADC_CONVERSION_US * 1e-6f * PWM_TIMER_CLOCK);
+    }
+}
+
+typedef enum { STEP_VELOCITY, STEP_POSITION, STEP_MOVE } step_mode_t;
+
+typedef struct {
+    float rise_time;             // 10-90% (s)
+    float overshoot;             // Percent of the step
+    float settling_time;         // Into and staying within 2% (s)
+    float final_error;           // Mean error over the last 10% of the run
+    float peak_following_error;  // Largest |setpoint - position| (position modes)
+    float peak_integral;         // Largest |position PID integrator| (rpm)
+    float lock_time;             // Sensorless: flux observer locked, after the step (s)
+    float peak_angle_error;      // Sensorless: largest |estimate - encoder| once locked (elec deg)
+    bool faulted;
+} step_result_t;
+
+typedef struct {
+    uint64_t isr_ticks;          // Host cycles spent in the control interrupt
+    uint32_t isr_worst;
+    uint32_t isr_calls;
+    double cpu_seconds;          // Whole run, plant included
+} sim_timing_t;
+
+static double cpu_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/**
+ * @brief Measure control_cycle_count() ticks per second against the wall clock
+ *
+ * Used as SystemCoreClock so the timing budgets are in host ticks.
+ */
+static uint32_t calibrate_cycle_counter(void) {
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    uint32_t start = control_cycle_count();
+    do {
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+    } while ((t1.tv_sec - t0.tv_sec) * 1e9 + (t1.tv_nsec - t0.tv_nsec) < 20e6);
+    uint32_t ticks = control_cycle_count() - start;
+    double seconds = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) * 1e-9;
+    return (uint32_t)(ticks / seconds);
+}
+
+/**
+ * @brief One PWM period: sample, interrupts, main loop, then the plants
+ *
+ * The analog watchdog interrupt has the higher priority, so its callback
+ * runs before the control interrupt gets past the offending axis; it runs
+ * from within the scan (sim_sample). New duties take effect half a period
+ * after the sample (timer preload).
+ */
+static void sim_pwm_period(int substeps, float dt, sim_timing_t* timing) {
+    sim_sample();
+    uint32_t start = control_cycle_count();
+    HAL_TIM_OC_DelayElapsedCallback(&htim_pwm[0]);
+    uint32_t ticks = control_cycle_count() - start;
+    timing->isr_ticks += ticks;
+    timing->isr_calls++;
+    if (ticks > timing->isr_worst) timing->isr_worst = ticks;
+
+    // Main loop: finish the UART transfer in flight, queue the next frame,
+    // poll the slow supervisor, save a frozen black box
+    if (uart_bits_pending > 0) {
+        uart_bits_pending -= uart_baud_rate / PWM_FREQUENCY;
+        if (uart_bits_pending <= 0) HAL_UART_TxCpltCallback(&huart_telemetry);
+    }
+    telemetry_service();
+    motor_thermal_check();
+    blackbox_service();
+
+    for (int n = 0; n < substeps; n++) {
+        for (uint32_t k = 0; k < MOTOR_AXIS_COUNT; k++) {
+            if (n == substeps / 2) {
+                memcpy(plants[k].duties, plants[k].pending, sizeof(plants[k].duties));
+            }
+            sim_step(k, dt);
+        }
+        sim_time += dt;
+    }
+}
+
+/**
+ * @brief Run one step response in virtual time
+ *
+ * Every axis gets the same setpoint step, or the same queued move, at 10%
+ * of the run (and the same load step); axis 0 is measured. Velocity steps open the position limits,
+ * which a free-running shaft would otherwise trip. Each PWM period
+ * the sensors are sampled, the control interrupt runs, and the new duties
+ * take effect half a period later, as with the timer's preload.
+ * @param scope Arm a telemetry capture on the setpoint step; the frames
+ *              streamed over the simulated UART are left in uart_stream
+ * @param trace Optional CSV output at the velocity-loop rate
+ */
+static step_result_t simulate_step(step_mode_t mode, float amount, float seconds,
+                                   float load_torque, bool scope, FILE* trace,
+                                   sim_timing_t* timing) {
+    uint32_t periods = (uint32_t)(seconds * PWM_FREQUENCY);
+    uint32_t step_at = periods / 10;
+    uint32_t load_at = periods * 6 / 10;
+    int substeps = (int)ceilf(SIM_STEP_RATE / PWM_FREQUENCY) & ~1;
+    float dt = 1.0f / ((float)PWM_FREQUENCY * substeps);
+    float* response = malloc(sizeof(float) * periods);
+    step_result_t result = { 0 };
+    result.lock_time = -1.0f;
+
+    sim_reset(true);
+    memset(motors, 0, sizeof(motors));
+    memset(&motor_trip, 0, sizeof(motor_trip));
+    init_motor_control_system();
+    for (uint32_t k = 0; k < MOTOR_AXIS_COUNT; k++) {
+        motors[k].sensorless = sim_sensorless;
+        if (mode == STEP_VELOCITY) {
+            motors[k].position_limit_min = -1e9f;
+            motors[k].position_limit_max = 1e9f;
+        } else {
+            motors[k].state = MOTOR_STATE_POSITION_CONTROL;
+        }
+    }
+    uart_stream_size = 0;
+    uart_bits_pending = 0;
+    if (scope) {
+        telemetry_channel_t setpoint = (mode == STEP_VELOCITY) ? TELEM_VELOCITY_SETPOINT
+                                                               : TELEM_POSITION_SETPOINT;
+        telemetry_arm(setpoint, 0.5f * amount, TELEMETRY_EDGE_RISING, telemetry.depth / 10);
+    }
+
+    if (trace) {
+        fprintf(trace, "time,setpoint,position,velocity,iq_ref,iq,vq,state\n");
+    }
+    memset(timing, 0, sizeof(*timing));
+    double cpu_start = cpu_seconds();
+
+    for (uint32_t n = 0; n < periods; n++) {
+        for (uint32_t k = 0; k < MOTOR_AXIS_COUNT; k++) {
+            if (n == step_at) {
+                if (mode == STEP_VELOCITY) {
+                    motors[k].velocity_setpoint = amount;
+                } else if (mode == STEP_POSITION) {
+                    motors[k].position_setpoint = amount;
+                } else {
+                    trajectory_queue_move(&motors[k].trajectory, amount,
+                                          sim_move_velocity * 6.0f, SIM_MOVE_ACCELERATION,
+                                          SIM_MOVE_JERK);
+                }
+            }
+            if (n == load_at) {
+                plants[k].load_torque = load_torque;
+            }
+        }
+
+        sim_pwm_period(substeps, dt, timing);
+
+        const motor_control_t* m = &motors[0];
+        response[n] = (mode == STEP_VELOCITY) ? m->velocity : m->position;
+        if (mode != STEP_VELOCITY && n >= step_at) {
+            float following = fabsf(m->position_setpoint - m->position);
+            float integral = fabsf(m->position_pid.integral);
+            if (following > result.peak_following_error) result.peak_following_error = following;
+            if (integral > result.peak_integral) result.peak_integral = integral;
+        }
+        if (sim_sensorless && flux_observers.locked[0]) {
+            // Both are the angle at this sample; the encoder's is up to one
+            // count (0.35 elec deg) behind
+            uint32_t encoder = (uint32_t)m->encoder.count * ENCODER_ANGLE_SCALE * MOTOR_POLE_PAIRS;
+            float error = fabsf((int32_t)(foc_axes.theta[0] - encoder) * (360.0f / 4294967296.0f));
+            if (result.lock_time < 0.0f) result.lock_time = (float)(n - step_at) / PWM_FREQUENCY;
+            if (error > result.peak_angle_error) result.peak_angle_error = error;
+        }
+        if (trace && (n % VELOCITY_LOOP_DIVISOR) == 0) {
+            fprintf(trace, "%.6f,%.3f,%.3f,%.3f,%.4f,%.4f,%.4f,%d\n",
+                    (double)n / PWM_FREQUENCY,
+                    mode == STEP_VELOCITY ? m->velocity_setpoint : m->position_setpoint,
+                    m->position, m->velocity, foc_axes.iq_ref[0], foc_axes.iq[0],
+                    foc_axes.vq[0], (int)m->state);
+        }
+    }
+    timing->cpu_seconds = cpu_seconds() - cpu_start;
+
+    // Step metrics, measured up to the load step (if any)
+    uint32_t end = load_torque != 0.0f ? load_at : periods;
+    uint32_t t10 = 0, t90 = 0;
+    float peak = 0.0f;
+    uint32_t last_outside = step_at;
+    for (uint32_t n = step_at; n < end; n++) {
+        float x = response[n] / amount;
+        if (!t10 && x >= 0.1f) t10 = n;
+        if (!t90 && x >= 0.9f) t90 = n;
+        if (x > peak) peak = x;
+        if (fabsf(x - 1.0f) > 0.02f) last_outside = n;
+    }
+    float error = 0.0f;
+    uint32_t tail = (end - step_at) / 10;
+    for (uint32_t n = end - tail; n < end; n++) {
+        error += amount - response[n];
+    }
+
+    result.rise_time = (t10 && t90) ? (float)(t90 - t10) / PWM_FREQUENCY : -1.0f;
+    result.overshoot = peak > 1.0f ? (peak - 1.0f) * 100.0f : 0.0f;
+    result.settling_time = (last_outside + 1 < end) ?
+                           (float)(last_outside + 1 - step_at) / PWM_FREQUENCY : -1.0f;
+    result.final_error = tail ? error / tail : 0.0f;
+    for (uint32_t k = 0; k < MOTOR_AXIS_COUNT; k++) {
+        if (motors[k].state == MOTOR_STATE_FAULT) result.faulted = true;
+    }
+    free(response);
+    return result;
+}
+
+static void print_step_report(step_mode_t mode, float amount, float seconds,
+                              const step_result_t* r, const sim_timing_t* t) {
+    const char* unit = (mode == STEP_VELOCITY) ? "rpm" : "deg";
+    uint32_t tick_worst, task_worst[CONTROL_TASK_COUNT];
+    uint32_t type_worst[CONTROL_TASK_TYPES] = {0};
+    uint32_t budget = control_get_tick_timing(&tick_worst, task_worst);
+    const fault_flags_t* faults = &motors[0].faults;
+
+    for (uint32_t i = 0; i < CONTROL_TASK_COUNT; i++) {
+        uint32_t type = i / MOTOR_AXIS_COUNT;
+        if (task_worst[i] > type_worst[type]) type_worst[type] = task_worst[i];
+    }
+
+    const char* names[] = { "Velocity step", "Position step", "S-curve move" };
+
+    printf("%s %.1f%s, %.2fs at %dHz PWM, %d axes\n", names[mode], amount, unit, seconds,
+           PWM_FREQUENCY, MOTOR_AXIS_COUNT);
+    if (r->rise_time >= 0.0f) printf("  rise time 10-90%%:  %.2fms\n", r->rise_time * 1e3f);
+    else                      printf("  rise time 10-90%%:  not reached\n");
+    printf("  overshoot:          %.1f%%\n", r->overshoot);
+    if (r->settling_time >= 0.0f) printf("  settling time 2%%:  %.2fms\n", r->settling_time * 1e3f);
+    else                          printf("  settling time 2%%:  not settled\n");
+    printf("  final error:        %.3f%s\n", r->final_error, unit);
+    if (mode != STEP_VELOCITY) {
+        printf("  following error:    %.2fdeg peak, position integrator %.1frpm peak\n",
+               r->peak_following_error, r->peak_integral);
+    }
+    if (sim_sensorless) {
+        if (r->lock_time >= 0.0f) {
+            printf("  sensorless:         locked %.1fms after the step, angle %.2fdeg (elec) "
+                   "peak from the encoder\n", r->lock_time * 1e3f, r->peak_angle_error);
+        } else {
+            printf("  sensorless:         never locked\n");
+        }
+    }
+    if (r->faulted) {
+        printf("  FAULT:%s%s%s%s\n", faults->overcurrent ? " overcurrent" : "",
+               faults->overspeed ? " overspeed" : "",
+               faults->position_limit ? " position_limit" : "",
+               faults->overtemperature ? " overtemperature" : "");
+    }
+    printf("  control interrupt:  %.1f cycles average, %u worst, budget %u\n",
+           (double)t->isr_ticks / t->isr_calls, t->isr_worst, budget);
+    printf("  outer tasks worst:  velocity %u, position %u, supervisor %u\n",
+           type_worst[0], type_worst[1], type_worst[2]);
+    if (foc_axes.sample_timeouts) {
+        printf("  current samples missed: %u\n", foc_axes.sample_timeouts);
+    }
+    printf("  simulation speed:   %.1fx real time\n", seconds / t->cpu_seconds);
+}
+
+typedef struct {
+    uint32_t frames;
+    uint32_t bad_frames;         // Checksum or framing errors
+    uint32_t channel_count;
+    uint32_t sample_rate;
+    uint32_t depth;
+    uint32_t trigger_sample;
+    uint8_t channel[TELEMETRY_MAX_CHANNELS];
+    float full_scale[TELEMETRY_MAX_CHANNELS];
+    float* samples;              // depth * channel_count, in channel units
+    uint32_t samples_received;
+} telemetry_capture_t;
+
+/**
+ * @brief Decode a telemetry byte stream the way a PC scope client would
+ * @return true if a header and every sample arrived intact
+ */
+static bool telemetry_decode(const uint8_t* data, size_t size, telemetry_capture_t* cap) {
+    memset(cap, 0, sizeof(*cap));
+    size_t pos = 0;
+
+    while (pos + 8 <= size) {
+        if (data[pos] != TELEMETRY_SYNC_0 || data[pos + 1] != TELEMETRY_SYNC_1) {
+            pos++;               // Resynchronise
+            continue;
+        }
+        uint32_t length = data[pos + 4] | (data[pos + 5] << 8);
+        if (pos + 8 + length > size) break;
+
+        uint32_t sum1 = 0, sum2 = 0;
+        for (size_t i = pos + 2; i < pos + 6 + length; i++) {
+            sum1 = (sum1 + data[i]) % 255;
+            sum2 = (sum2 + sum1) % 255;
+        }
+        const uint8_t* payload = &data[pos + 6];
+        if (payload[length] != sum1 || payload[length + 1] != sum2) {
+            cap->bad_frames++;
+            pos++;
+            continue;
+        }
+        cap->frames++;
+
+        if (data[pos + 2] == TELEMETRY_FRAME_HEADER) {
+            cap->channel_count = payload[0];
+            memcpy(&cap->sample_rate, &payload[2], 4);
+            memcpy(&cap->depth, &payload[6], 4);
+            memcpy(&cap->trigger_sample, &payload[10], 4);
+            for (uint32_t i = 0; i < cap->channel_count; i++) {
+                cap->channel[i] = payload[14 + 5 * i];
+                memcpy(&cap->full_scale[i], &payload[15 + 5 * i], 4);
+            }
+            free(cap->samples);
+            cap->samples = calloc((size_t)cap->depth * cap->channel_count, sizeof(float));
+        } else if (data[pos + 2] == TELEMETRY_FRAME_DATA && cap->samples) {
+            uint32_t first;
+            memcpy(&first, payload, 4);
+            uint32_t count = (length - 4) / (2 * cap->channel_count);
+            for (uint32_t n = 0; n < count && first + n < cap->depth; n++) {
+                for (uint32_t i = 0; i < cap->channel_count; i++) {
+                    int16_t raw;
+                    memcpy(&raw, &payload[4 + 2 * (n * cap->channel_count + i)], 2);
+                    cap->samples[(first + n) * cap->channel_count + i] =
+                        raw * cap->full_scale[i] / 32767.0f;
+                }
+                cap->samples_received++;
+            }
+        }
+        pos += 8 + length;
+    }
+    return cap->samples && cap->bad_frames == 0 && cap->samples_received == cap->depth;
+}
+
+static void print_capture_report(const telemetry_capture_t* cap, size_t bytes) {
+    printf("Telemetry capture: %zu bytes, %u frames (%u bad)\n", bytes, cap->frames,
+           cap->bad_frames);
+    printf("  %u channels, %u samples at %uHz, trigger at sample %u, %u received\n",
+           cap->channel_count, cap->depth, cap->sample_rate, cap->trigger_sample,
+           cap->samples_received);
+}
+
+/**
+ * @brief Stream a triggered capture of a velocity step and decode it
+ *
+ * The first channel is the velocity setpoint, which the capture triggers
+ * on, so the decoded trace must cross the level exactly at the trigger
+ * sample.
+ * @return Number of failed checks
+ */
+static int check_telemetry_stream(void) {
+    sim_timing_t timing;
+    telemetry_capture_t cap;
+
+    benchmark_telemetry_capture();
+    // Long enough to fill the ring and stream it out at the slowest rates
+    simulate_step(STEP_VELOCITY, 300.0f, 1.0f, 0.0f, true, NULL, &timing);
+    bool ok = telemetry_decode(uart_stream, uart_stream_size, &cap);
+    print_capture_report(&cap, uart_stream_size);
+
+    if (ok) {
+        float before = cap.samples[(cap.trigger_sample - 1) * cap.channel_count];
+        float at = cap.samples[cap.trigger_sample * cap.channel_count];
+        ok = before < 150.0f && at >= 150.0f;
+    }
+    if (!ok) {
+        printf("  FAILED\n");
+    }
+    free(cap.samples);
+    return ok ? 0 : 1;
+}
+
+/**
+ * @brief Overcurrent trip latency, with and without the break comparator
+ *
+ * Drives axis 0's d-axis current reference far past the trip levels, first
+ * into the normal winding (current rises at about 28A/ms) and then into
+ * one with a twentieth of the inductance, standing in for a shorted
+ * winding. The other axes hold zero current. Measures in virtual time how
+ * long the phase current stays above the level of the path that tripped,
+ * and the peak it reached. The analog watchdog only sees the current at
+ * the next sample, so its bound is one PWM period, and it must stop every
+ * axis; the comparator acts within a plant step on its own axis only.
+ * Either way the trip must be recorded against axis 0.
+ * @return Number of failed checks
+ */
+static int check_fault_trip(void) {
+    int substeps = (int)ceilf(SIM_STEP_RATE / PWM_FREQUENCY) & ~1;
+    float dt = 1.0f / ((float)PWM_FREQUENCY * substeps);
+    const char* names[] = { "none", "break input", "analog watchdog", "supervisor", "thermal" };
+    sim_timing_t timing;
+    int failures = 0;
+
+    printf("Overcurrent trip (watchdog %.1fA, comparator %.1fA, %dHz PWM, %d axes)\n",
+           OVERCURRENT_TRIP_AMPS, BREAK_TRIP_AMPS, PWM_FREQUENCY, MOTOR_AXIS_COUNT);
+    for (int scenario = 0; scenario < 4; scenario++) {
+        bool shorted = scenario >= 2;
+        bool fitted = (scenario & 1) == 0;
+        motor_plant_t* p = &plants[0];
+
+        sim_reset(fitted);
+        memset(motors, 0, sizeof(motors));
+        memset(&motor_trip, 0, sizeof(motor_trip));
+        memset(&timing, 0, sizeof(timing));
+        init_motor_control_system();
+
+        for (uint32_t n = 0; n < PWM_FREQUENCY / 50 && p->outputs_enabled; n++) {
+            if (n == PWM_FREQUENCY / 100) {
+                foc_axes.id_ref[0] = 20.0f;
+                if (shorted) p->inductance = MOTOR_LS / 20.0f;
+            }
+            sim_pwm_period(substeps, dt, &timing);
+        }
+
+        trip_source_t source;
+        uint32_t axis, count;
+        uint32_t measured_ns = fault_get_trip(&source, &axis, &count);
+        double crossed = (source == TRIP_BREAK_INPUT) ? p->crossed_break_at
+                                                      : p->crossed_watchdog_at;
+        double latency_us = (p->outputs_off_at - crossed) * 1e6;
+        double bound_us = (source == TRIP_BREAK_INPUT) ? dt * 1e6
+                                                       : (1.0 / PWM_FREQUENCY + dt) * 1e6;
+        uint32_t axes_off = 0;
+        for (uint32_t k = 0; k < MOTOR_AXIS_COUNT; k++) {
+            if (!plants[k].outputs_enabled) axes_off++;
+        }
+        uint32_t expected_off = (source == TRIP_BREAK_INPUT) ? 1 : MOTOR_AXIS_COUNT;
+
+        printf("  %-8s %-16s tripped by %-15s %5.1fus over the level (bound %4.1fus), "
+               "peak %5.1fA, %u/%d axes off", shorted ? "short" : "runaway",
+               fitted ? "with comparator" : "watchdog only", names[source],
+               latency_us, bound_us, p->peak_current, axes_off, MOTOR_AXIS_COUNT);
+        if (source == TRIP_ANALOG_WATCHDOG) {
+            printf(", sample to off %luns", (unsigned long)measured_ns);
+        }
+        printf("\n");
+        if (p->outputs_enabled || crossed < 0.0 || latency_us > bound_us ||
+            axes_off != expected_off ||
+            axis != 0 ||
+            (source != TRIP_BREAK_INPUT && source != TRIP_ANALOG_WATCHDOG)) {
+            printf("  FAILED\n");
+            failures++;
+        }
+    }
+    return failures;
+}
+
+/**
+ * @brief The watchdog names the axis whose sample left the window
+ *
+ * Forces one sample of one scan to full scale: phase A of axis 0; phase A
+ * and then phase B of axis 2 (the last axis if there are fewer) with the
+ * current loops already through the earlier axes; and phase B of that axis
+ * after the loops have taken its pair as well, which leaves nothing to
+ * identify it by. Each trip must be recorded against its axis, or as
+ * TRIP_ALL_AXES in the last case, and the saved black box must say the same.
+ * @return Number of failed checks
+ */
+static int check_trip_axis(void) {
+    const uint32_t far_axis = MOTOR_AXIS_COUNT > 2 ? 2 : MOTOR_AXIS_COUNT - 1;
+    const struct {
+        uint32_t sample, pairs_taken, expected;
+        const char* name;
+    } cases[] = {
+        { 0, 0, 0, "phase A, first axis" },
+        { 2 * far_axis, far_axis, far_axis, "phase A, earlier pairs taken" },
+        { 2 * far_axis + 1, far_axis, far_axis, "phase B, earlier pairs taken" },
+        { 2 * far_axis + 1, far_axis + 1, TRIP_ALL_AXES, "phase B, its pair taken" },
+    };
+    int substeps = (int)ceilf(SIM_STEP_RATE / PWM_FREQUENCY) & ~1;
+    float dt = 1.0f / ((float)PWM_FREQUENCY * substeps);
+    sim_timing_t timing;
+    int failures = 0;
+
+    printf("Watchdog trip axis (%d axes)\n", MOTOR_AXIS_COUNT);
+    for (size_t c = 0; c < sizeof(cases) / sizeof(cases[0]); c++) {
+        sim_reset(false);
+        memset(motors, 0, sizeof(motors));
+        memset(&motor_trip, 0, sizeof(motor_trip));
+        memset(&timing, 0, sizeof(timing));
+        init_motor_control_system();
+
+        for (uint32_t n = 0; n < PWM_FREQUENCY / 10 && blackbox.state != BLACKBOX_SAVED; n++) {
+            if (n == PWM_FREQUENCY / 100) {
+                sim_forced_sample = (int32_t)cases[c].sample;
+                sim_pairs_taken = cases[c].pairs_taken;
+            }
+            sim_pwm_period(substeps, dt, &timing);
+            sim_forced_sample = -1;
+            sim_pairs_taken = 0;
+        }
+
+        trip_source_t source;
+        uint32_t axis, count;
+        fault_get_trip(&source, &axis, &count);
+        const blackbox_record_t* r = NULL;
+        const blackbox_header_t* h = blackbox_load(&r);
+        printf("  %-30s axis %3u (expected %3u), black box axis %3d\n", cases[c].name,
+               (unsigned)axis, (unsigned)cases[c].expected, h != NULL ? h->axis : -1);
+        if (source != TRIP_ANALOG_WATCHDOG || axis != cases[c].expected ||
+            h == NULL || h->axis != cases[c].expected) {
+            printf("  FAILED\n");
+            failures++;
+        }
+        blackbox_clear();
+    }
+    return failures;
+}
+
+/**
+ * @brief Black box across a trip and a reset
+ *
+ * Runs axis 0 away into the analog watchdog with no comparator fitted,
+ * keeps the loop running until the box has been saved, then resets the
+ * simulated board and reads the box back. The saved records must belong to
+ * axis 0, be a run of consecutive snapshots that turns to FAULT exactly at
+ * trip_record, and show the current rising towards the trip level (the
+ * last snapshot before the trip can be up to one snapshot period early). A
+ * damaged image must be rejected.
+ * @return Number of failed checks
+ */
+static int check_blackbox(void) {
+    int substeps = (int)ceilf(SIM_STEP_RATE / PWM_FREQUENCY) & ~1;
+    float dt = 1.0f / ((float)PWM_FREQUENCY * substeps);
+    sim_timing_t timing;
+
+    benchmark_blackbox_record();
+    sim_reset(false);
+    memset(motors, 0, sizeof(motors));
+    memset(&motor_trip, 0, sizeof(motor_trip));
+    memset(&timing, 0, sizeof(timing));
+    init_motor_control_system();
+    // Long enough before the runaway to fill the ring
+    for (uint32_t n = 0; n < PWM_FREQUENCY / 10 && blackbox.state != BLACKBOX_SAVED; n++) {
+        if (n == PWM_FREQUENCY / 20) {
+            foc_axes.id_ref[0] = 20.0f;
+        }
+        sim_pwm_period(substeps, dt, &timing);
+    }
+
+    // Reset: RAM is lost, backup SRAM is not
+    memset(blackbox_ring, 0, sizeof(blackbox_ring));
+    memset(&blackbox, 0, sizeof(blackbox));
+    memset(motors, 0, sizeof(motors));
+    memset(&motor_trip, 0, sizeof(motor_trip));
+    sim_reset(false);
+    init_motor_control_system();
+
+    const blackbox_record_t* r = NULL;
+    const blackbox_header_t* h = blackbox_load(&r);
+    bool ok = h != NULL && h->axis == 0 && h->source == TRIP_ANALOG_WATCHDOG &&
+              h->record_count == BLACKBOX_SAVED_DEPTH && h->trip_record > 0;
+    float peak_id = 0.0f;
+    if (ok) {
+        for (uint32_t n = 1; n < h->record_count; n++) {
+            ok = ok && (uint16_t)(r[n].tick - r[n - 1].tick) == BLACKBOX_DIVISOR;
+        }
+        for (uint32_t n = 0; n < h->record_count; n++) {
+            bool faulted = r[n].state == MOTOR_STATE_FAULT;
+            ok = ok && faulted == (n >= h->trip_record);
+            if (fabsf(r[n].id * 0.001f) > peak_id) peak_id = fabsf(r[n].id * 0.001f);
+        }
+        ok = ok && (r[h->trip_record].faults & 1) && peak_id > 0.5f * OVERCURRENT_TRIP_AMPS;
+    }
+    printf("Black box (%u of %u snapshots per axis saved, %u bytes of backup SRAM)\n",
+           (unsigned)BLACKBOX_SAVED_DEPTH, (unsigned)BLACKBOX_DEPTH,
+           (unsigned)(sizeof(blackbox_header_t) + BLACKBOX_SAVED_DEPTH * sizeof(blackbox_record_t)));
+    if (h != NULL) {
+        printf("  after reset: axis %u, %u records, trip at record %u, peak id %.1fA\n",
+               h->axis, h->record_count, h->trip_record, peak_id);
+    }
+
+    // A flipped bit must be caught, and a cleared box must read as empty
+    ((blackbox_record_t*)(sim_backup_sram + sizeof(blackbox_header_t) / 4))[10].iq ^= 4;
+    ok = ok && blackbox_load(&r) == NULL;
+    ((blackbox_record_t*)(sim_backup_sram + sizeof(blackbox_header_t) / 4))[10].iq ^= 4;
+    ok = ok && blackbox_load(&r) != NULL;
+    blackbox_clear();
+    ok = ok && blackbox_load(&r) == NULL;
+
+    if (!ok) {
+        printf("  FAILED\n");
+    }
+    return ok ? 0 : 1;
+}
+
+/**
+ * @brief Closed-loop regression check for both step types and a planned move
+ * @return Number of failed checks
+ */
+static int check_step_responses(void) {
+    sim_timing_t timing;
+    int failures = 0;
+
+    step_result_t v = simulate_step(STEP_VELOCITY, 300.0f, 0.5f, 0.0f, false, NULL, &timing);
+    print_step_report(STEP_VELOCITY, 300.0f, 0.5f, &v, &timing);
+    if (v.faulted || v.settling_time < 0.0f || v.settling_time > 0.1f ||
+        v.overshoot > 25.0f || fabsf(v.final_error) > 3.0f) {
+        printf("  FAILED\n");
+        failures++;
+    }
+
+    step_result_t p = simulate_step(STEP_POSITION, 90.0f, 0.5f, 0.0f, false, NULL, &timing);
+    print_step_report(STEP_POSITION, 90.0f, 0.5f, &p, &timing);
+    if (p.faulted || p.settling_time < 0.0f || p.settling_time > 0.25f ||
+        p.overshoot > 10.0f || fabsf(p.final_error) > 0.5f) {
+        printf("  FAILED\n");
+        failures++;
+    }
+
+    // The same distance as a planned move: with the feedforward the PID only
+    // sees a small following error, so nothing saturates and the shaft
+    // lands without overshoot
+    step_result_t m = simulate_step(STEP_MOVE, 90.0f, 0.5f, 0.0f, false, NULL, &timing);
+    print_step_report(STEP_MOVE, 90.0f, 0.5f, &m, &timing);
+    if (m.faulted || m.settling_time < 0.0f || m.settling_time > 0.25f ||
+        m.overshoot > 2.0f || fabsf(m.final_error) > 0.5f ||
+        m.peak_following_error > 2.0f) {
+        printf("  FAILED\n");
+        failures++;
+    }
+    return failures;
+}
+
+/**
+ * @brief Sensorless velocity control against the encoder
+ *
+ * Steps every axis to 600rpm on the flux observer (the encoder carries it
+ * up to OBSERVER_LOCK_RPM) and adds a load torque of about 1A, measuring
+ * how far the estimated angle strays from the encoder's once locked.
+ * @return Number of failed checks
+ */
+static int check_sensorless(void) {
+    sim_timing_t timing;
+
+    sim_sensorless = true;
+    step_result_t r = simulate_step(STEP_VELOCITY, 600.0f, 0.5f, 0.05f, false, NULL, &timing);
+    print_step_report(STEP_VELOCITY, 600.0f, 0.5f, &r, &timing);
+    sim_sensorless = false;
+    if (r.faulted || r.settling_time < 0.0f || r.settling_time > 0.1f ||
+        fabsf(r.final_error) > 3.0f || r.lock_time < 0.0f || r.peak_angle_error > 5.0f) {
+        printf("  FAILED\n");
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Torque feedforward stays inside the velocity loop's current limit
+ *
+ * Runs the velocity loop of axis 0 on a stalled shaft for one second with a
+ * 500rpm error and a feedforward of twice max_current, the worst a fast
+ * queued move can ask for. The current reference must never pass the PID
+ * limit, and the integrator must stay within the limit plus the
+ * feedforward instead of winding up for the whole second.
+ * @return Number of failed checks
+ */
+static int check_feedforward_limit(void) {
+    motor_control_t* ctrl = &motors[0];
+    float peak = 0.0f, peak_integral = 0.0f;
+
+    sim_reset(true);
+    memset(motors, 0, sizeof(motors));
+    memset(&motor_trip, 0, sizeof(motor_trip));
+    init_motor_control_system();
+    ctrl->velocity_setpoint = 500.0f;
+    ctrl->current_feedforward = 2.0f * ctrl->max_current;
+
+    for (uint32_t n = 0; n < CONTROL_FREQUENCY; n++) {
+        velocity_loop_task(ctrl);
+        if (fabsf(foc_axes.iq_ref[0]) > peak) peak = fabsf(foc_axes.iq_ref[0]);
+        if (fabsf(ctrl->velocity_pid.integral) > peak_integral) {
+            peak_integral = fabsf(ctrl->velocity_pid.integral);
+        }
+    }
+
+    float limit = ctrl->velocity_pid.out_max;
+    bool ok = peak <= limit * 1.0001f &&
+              peak_integral <= limit + ctrl->current_feedforward;
+    printf("Current feedforward limit (%.1fA feedforward, 500rpm error, 1s)\n",
+           ctrl->current_feedforward);
+    printf("  peak iq_ref %.2fA (limit %.2fA), peak integral %.2fA %s\n",
+           peak, limit, peak_integral, ok ? "PASS" : "FAIL");
+    return ok ? 0 : 1;
+}
+
+int main(int argc, char** argv) {
+    step_mode_t mode = STEP_VELOCITY;
+    float amount = 0.0f;
+    float seconds = 0.5f;
+    float load_torque = 0.0f;
+    const char* trace_path = NULL;
+    const char* scope_path = NULL;
+
+    SystemCoreClock = calibrate_cycle_counter();
+    sim_reset(true);
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--selftest") == 0) {
+            benchmark_svm_paths();
+            benchmark_pid();
+            benchmark_foc_batch();
+            int failures = check_encoder_observer();
+            failures += check_trajectory();
+            failures += check_flux_observer();
+            failures += check_step_responses();
+            failures += check_sensorless();
+            failures += check_feedforward_limit();
+            failures += check_telemetry_stream();
+            failures += check_fault_trip();
+            failures += check_trip_axis();
+            failures += check_blackbox();
+            return failures ? 1 : 0;
+        } else if (strcmp(argv[i], "-m") == 0 && i + 1 < argc) {
+            i++;
+            mode = strcmp(argv[i], "position") == 0 ? STEP_POSITION :
+                   strcmp(argv[i], "move") == 0 ? STEP_MOVE : STEP_VELOCITY;
+        } else if (strcmp(argv[i], "-a") == 0 && i + 1 < argc) {
+            amount = (float)atof(argv[++i]);
+        } else if (strcmp(argv[i], "-s") == 0) {
+            sim_sensorless = true;
+        } else if (strcmp(argv[i], "-v") == 0 && i + 1 < argc) {
+            sim_move_velocity = (float)atof(argv[++i]);
+        } else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+            seconds = (float)atof(argv[++i]);
+        } else if (strcmp(argv[i], "-L") == 0 && i + 1 < argc) {
+            load_torque = (float)atof(argv[++i]);
+        } else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            trace_path = argv[++i];
+        } else if (strcmp(argv[i], "-T") == 0 && i + 1 < argc) {
+            scope_path = argv[++i];
+        } else {
+            fprintf(stderr, "usage: %s [-m velocity|position|move] [-a amount] [-v vmax] [-s] "
+                            "[-t seconds] [-L torque] [-o trace.csv] [-T scope.bin]\n"
+                            "       %s --selftest\n",
+                    argv[0], argv[0]);
+            return 2;
+        }
+    }
+    if (amount == 0.0f) {
+        amount = (mode == STEP_VELOCITY) ? 300.0f : 90.0f;
+    }
+
+    FILE* trace = NULL;
+    if (trace_path && !(trace = fopen(trace_path, "w"))) {
+        fprintf(stderr, "cannot write %s\n", trace_path);
+        return 2;
+    }
+
+    sim_timing_t timing;
+    step_result_t result = simulate_step(mode, amount, seconds, load_torque,
+                                         scope_path != NULL, trace, &timing);
+    print_step_report(mode, amount, seconds, &result, &timing);
+    if (trace) fclose(trace);
+
+    if (scope_path) {
+        telemetry_capture_t cap;
+        FILE* f = fopen(scope_path, "wb");
+        if (f) {
+            fwrite(uart_stream, 1, uart_stream_size, f);
+            fclose(f);
+        }
+        telemetry_decode(uart_stream, uart_stream_size, &cap);
+        print_capture_report(&cap, uart_stream_size);
+        free(cap.samples);
+    }
+    return result.faulted ? 1 : 0;
+}